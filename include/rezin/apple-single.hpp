@@ -63,6 +63,30 @@ class AppleSingle {
     // @throws std::runtime_error    If there is no such chunk in the file.
     const pn::data_view& at(uint32_t id);
 
+    // @param [in] id       The identifier of a chunk.
+    // @returns             True if the file contains a chunk with that identifier.
+    bool contains(uint32_t id) const;
+
+    // @param [in] header   At least the first 4 bytes of a file.
+    // @returns             True if the file starts with the magic number of an AppleSingle- or
+    //                      AppleDouble-encoded file, in either byte order.
+    static bool has_magic(const pn::data_view& header);
+
+    // Reads only the header of an AppleSingle- or AppleDouble-encoded file, for when the file is
+    // not held in memory all at once.  First, call header_size() with at least the first
+    // `kMinHeaderSize` bytes of the file; then locate() with at least that many bytes.
+    //
+    // @param [in] header   The beginning of an AppleSingle- or AppleDouble-encoded file.
+    // @param [in] id       The identifier of the chunk to find.
+    // @param [out] offset  Set to the offset of the chunk within the file, if found.
+    // @param [out] length  Set to the length of the chunk, if found.
+    // @returns             True if the file contains a chunk with that identifier.
+    // @throws std::runtime_error    If the header could not be parsed.
+    static const size_t kMinHeaderSize = 26;
+    static size_t       header_size(const pn::data_view& header);
+    static bool         locate(
+                    const pn::data_view& header, uint32_t id, uint64_t* offset, uint64_t* length);
+
   private:
     // Map from chunk identifiers to chunk data blocks.
     std::map<uint32_t, pn::data_view> _entries;
@@ -0,0 +1,50 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#ifndef REZIN_BINHEX_HPP_
+#define REZIN_BINHEX_HPP_
+
+#include <stdint.h>
+#include <sfz/sfz.hpp>
+
+namespace rezin {
+
+// Decodes a BinHex 4.0 file.
+//
+// A BinHex file is text: a line identifying the format, then the encoded file between two colons,
+// with line breaks anywhere.  Each character encodes 6 bits; the resulting bytes are then
+// run-length encoded, with 0x90 as the escape.  The decoded file is a header (name, type, creator,
+// flags, and the lengths of the forks), the data fork, and the resource fork, each followed by a
+// CRC.
+//
+// Decoding is done in a single pass over the text, with no intermediate buffers: characters are
+// decoded through a table, 4 at a time where possible, and each decoded byte is passed straight
+// through the run-length decoder to the part of the file it belongs to.  Only the resource fork is
+// kept; the header and data fork are checked against their CRCs, then discarded.
+class BinHex {
+  public:
+    // Checks whether a file is BinHex-encoded, from the identifying line near its start.
+    //
+    // @param [in] header   The start of the file.
+    // @returns             True if the identifying line is within `header`.
+    static bool has_header(const pn::data_view& header);
+
+    // @param [in] data     The contents of a BinHex-encoded file.
+    // @throws std::runtime_error    If the contents of `data` could not be decoded, or a CRC does
+    //                               not match.
+    BinHex(const pn::data_view& data);
+
+    pn::data_view resource_fork() const;
+
+  private:
+    pn::data _resource_fork;
+
+    BinHex(const BinHex&) = delete;
+    BinHex& operator=(const BinHex&) = delete;
+};
+
+}  // namespace rezin
+
+#endif  // REZIN_BINHEX_HPP_
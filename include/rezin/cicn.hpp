@@ -22,7 +22,8 @@ struct ColorIcon {
     std::unique_ptr<Rep> rep;
 };
 
-pn::data png(const ColorIcon& cicn);
+// Converts the icon to a PNG, scaled down to fit within `max_size` pixels if it is nonzero.
+pn::data png(const ColorIcon& cicn, int16_t max_size = 0);
 
 }  // namespace rezin
 
@@ -7,6 +7,7 @@
 #define REZIN_CLUT_HPP_
 
 #include <stdint.h>
+#include <rezin/emitter.hpp>
 #include <sfz/sfz.hpp>
 #include <vector>
 
@@ -25,6 +26,7 @@ struct ColorTable {
 };
 void      read_from(pn::file_view in, ColorTable* out);
 pn::value value(const ColorTable& color_table);
+void      emit(Emitter& out, const ColorTable& color_table);
 
 struct Color {
     uint16_t red;
@@ -33,6 +35,7 @@ struct Color {
 };
 void      read_from(pn::file_view in, Color* out);
 pn::value value(const Color& spec);
+void      emit(Emitter& out, const Color& spec);
 
 }  // namespace rezin
 
@@ -0,0 +1,69 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#ifndef REZIN_EMITTER_HPP_
+#define REZIN_EMITTER_HPP_
+
+#include <rezin/options.hpp>
+#include <sfz/sfz.hpp>
+#include <vector>
+
+namespace rezin {
+
+// Writes structured data directly to a file, as procyon or JSON.
+//
+// Arrays, maps, and scalars are written as they are emitted, without first building a pn::value
+// tree.  Every begin_array() and begin_map() must be matched by an end_array() or end_map(),
+// and every value within a map must be preceded by key().
+//
+// The top-level array or map is written one element per line; nested ones are written inline.
+// In procyon output, top-level arrays use the `*` syntax, and the values of top-level maps are
+// aligned, which requires begin_map() to know the width of the widest key in advance.
+class Emitter {
+  public:
+    Emitter(pn::file_view out, Options::Format format);
+
+    void begin_array();
+    void end_array();
+
+    // @param [in] key_width    The width of the widest key of the map, as found by key_width().
+    //                          Used to align the values of a top-level map in procyon output;
+    //                          ignored otherwise.
+    void begin_map(int key_width = 0);
+    void end_map();
+    void key(pn::string_view key);
+
+    void value(int64_t i);
+    void value(double d);
+    void value(pn::string_view s);
+
+    // Not an overload of value(), so that string literals aren't taken as booleans.
+    void boolean(bool b);
+
+    // @returns             The number of columns `key` takes up in procyon output: its number of
+    //                      code points, once it is quoted and escaped, if it isn't a bare key.
+    static int key_width(pn::string_view key);
+
+  private:
+    struct Frame {
+        bool is_map;
+        int  key_width;
+        int  count;
+    };
+
+    void before_value();
+    void after_value();
+    void begin(bool is_map, int key_width, pn::string_view open);
+    void end(pn::string_view open, pn::string_view close);
+    void write(pn::string_view s);
+
+    pn::file_view      _out;
+    Options::Format    _format;
+    std::vector<Frame> _stack;
+};
+
+}  // namespace rezin
+
+#endif  // REZIN_EMITTER_HPP_
@@ -0,0 +1,53 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#ifndef REZIN_MAC_BINARY_HPP_
+#define REZIN_MAC_BINARY_HPP_
+
+#include <stdint.h>
+#include <sfz/sfz.hpp>
+
+namespace rezin {
+
+// Reads the contents of a MacBinary-encoded file.
+//
+// A MacBinary file is a 128-byte header, followed by the data fork and then the resource fork,
+// each padded to a multiple of 128 bytes.  Versions I, II, and III of the format are accepted;
+// they differ only in the fields of the header, which rezin does not need beyond the lengths of
+// the forks.  Both forks are slices of the input: nothing is copied.
+class MacBinary {
+  public:
+    // The number of bytes from the start of a file that has_header() needs.
+    static const size_t kHeaderSize = 128;
+
+    // Checks whether a file is MacBinary-encoded, from its header alone.  Version I headers have
+    // no signature or checksum, so to tell them apart from other files, all of the fields which
+    // must be zero are checked, and the forks must fit within the file.
+    //
+    // @param [in] header   At least the first 128 bytes of the file.
+    // @param [in] size     The size of the whole file.
+    // @returns             True if the file has a valid MacBinary header.
+    static bool has_header(const pn::data_view& header, uint64_t size);
+
+    // @param [in] data     A block of memory containing the contents of a MacBinary-encoded file.
+    //                      The block of memory must continue to remain valid for the lifetime of
+    //                      this object; it is not copied.
+    // @throws std::runtime_error    If the contents of `data` could not be parsed.
+    MacBinary(const pn::data_view& data);
+
+    const pn::data_view& data_fork() const;
+    const pn::data_view& resource_fork() const;
+
+  private:
+    pn::data_view _data_fork;
+    pn::data_view _resource_fork;
+
+    MacBinary(const MacBinary&) = delete;
+    MacBinary& operator=(const MacBinary&) = delete;
+};
+
+}  // namespace rezin
+
+#endif  // REZIN_MAC_BINARY_HPP_
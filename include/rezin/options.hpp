@@ -16,7 +16,48 @@ struct Options {
     enum LineEnding { CR, NL, CRNL };
     LineEnding line_ending;
 
+    // If true, `ls` also prints the size and metadata of each resource.
+    bool long_listing;
+
+    // If nonzero, `convert` scales images down to fit within this many pixels.
+    int16_t max_size;
+
+    // The file format `convert` writes sounds in.
+    enum AudioFormat { AIFF, WAV, RAW };
+    AudioFormat audio_format;
+
+    // If nonnegative, `convert` writes only this track of a 'snd ' resource, rather than all of
+    // its tracks concatenated.
+    int32_t track;
+
+    // If nonzero, sounds are converted to this sample rate, in Hz.
+    int32_t sample_rate;
+
+    // The format `convert` writes structured data, such as 'STR#' and 'clut' resources, in.
+    enum Format { PROCYON, JSON };
+    Format format;
+
+    // The number of forks of an archive to decompress at once.
+    int jobs;
+
+    // If nonzero, forks in zip archives are decompressed incrementally, as their resources are
+    // read, keeping at most this many MiB of decompressed data.
+    int32_t window;
+
+    // When reading a directory, the most files to map at once, and the most MiB to map in total.
+    // A single file larger than `max_mapped` may still be mapped, but only on its own.
+    int32_t max_open;
+    int32_t max_mapped;
+
+    // If nonzero, the MiB to allocate up front for standard input, when it isn't a regular file
+    // and so its size can't be found in advance.
+    int32_t stdin_size;
+
     pn::string decode(const pn::data_view& bytes) const;
+
+    // Returns true if decode() would return `bytes` unchanged: they are all ASCII, and contain no
+    // carriage returns which would be replaced.  This is much cheaper than decoding.
+    bool decodes_unchanged(const pn::data_view& bytes) const;
 };
 
 }  // namespace rezin
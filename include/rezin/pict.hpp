@@ -12,6 +12,23 @@ namespace rezin {
 
 struct PngPicture;
 
+// Reads a 'PICT' resource.
+//
+// Constructing a Picture only scans the opcodes of the resource, recording a display list of the
+// ops it contains and where their operands are.  This is enough to answer is_raster(), version(),
+// width(), and height().  Pixel data is decoded and composited the first time png() is called on
+// the picture, so pictures which are classified and discarded never pay for decompression.  A
+// picture which is a single image filling its frame isn't composited at all: its rows are encoded
+// as they are decoded.
+//
+// Vector ops (lines, rects, rounded rects, ovals, arcs, polygons, and regions) are rasterized in
+// the same pass as pixel data, so is_raster() only reports whether the picture contained any;
+// both kinds can be converted to PNG.  Ops which can't be drawn faithfully, such as patterns and
+// pen modes other than solid copies, make png() throw.
+//
+// @param [in] in       The content of a 'PICT' resource.  The block of memory must remain valid
+//                      for the lifetime of this object; it is not copied.
+// @throws std::runtime_error    If the structure of the 'PICT' data could not be read.
 struct Picture {
     struct Rep;
 
@@ -20,11 +37,14 @@ struct Picture {
 
     bool    is_raster() const;
     uint8_t version() const;
+    int16_t width() const;
+    int16_t height() const;
 
     std::shared_ptr<Rep> rep;
 };
 
-pn::data png(const Picture& pict);
+// Converts the picture to a PNG, scaled down to fit within `max_size` pixels if it is nonzero.
+pn::data png(const Picture& pict, int16_t max_size = 0);
 
 }  // namespace rezin
 
@@ -0,0 +1,46 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#ifndef REZIN_PROBE_HPP_
+#define REZIN_PROBE_HPP_
+
+#include <stdint.h>
+#include <sfz/sfz.hpp>
+
+namespace rezin {
+
+// Reads metadata about a resource without decoding its payload.
+//
+// Only the headers of the resource are examined: the frame of a 'PICT'; the PixMap header of a
+// 'cicn'; the sound header of a 'snd '; and the counts of 'STR#' and 'clut' resources.  Pixels,
+// samples, and strings are never read, so probing a resource costs a few dozen bytes of reads,
+// regardless of its size.
+//
+// Fields which do not apply to the resource's type are left empty.
+//
+// @param [in] type     The 4-character code of the resource type, e.g. "PICT".
+// @param [in] in       The content of the resource.
+// @throws std::runtime_error    If the headers of the resource could not be read.
+struct ResourceInfo {
+    ResourceInfo(pn::string_view type, pn::data_view in);
+
+    sfz::optional<int16_t>  width;
+    sfz::optional<int16_t>  height;
+    sfz::optional<int16_t>  depth;
+    sfz::optional<int16_t>  pixel_type;
+    sfz::optional<uint8_t>  version;
+    sfz::optional<uint32_t> channels;
+    sfz::optional<uint32_t> sample_bits;
+    sfz::optional<double>   sample_rate;
+    sfz::optional<uint32_t> samples;
+    sfz::optional<uint32_t> strings;
+    sfz::optional<uint32_t> colors;
+};
+
+pn::value value(const ResourceInfo& info);
+
+}  // namespace rezin
+
+#endif  // REZIN_PROBE_HPP_
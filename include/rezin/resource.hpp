@@ -13,6 +13,23 @@ namespace rezin {
 struct Options;
 class ResourceEntry;
 class ResourceType;
+struct ResourceData;
+
+// Reads a resource fork which is not held in memory all at once, e.g. because it is decompressed
+// on demand.
+class ForkReader {
+  public:
+    virtual ~ForkReader() {}
+
+    // @returns             The size of the resource fork, in bytes.
+    virtual uint64_t size() const = 0;
+
+    // Copies `size` bytes from `offset` within the resource fork to `out`.
+    //
+    // @throws std::runtime_error    If the range extends past the end of the fork, or could not
+    //                               be read.
+    virtual void read(uint64_t offset, uint64_t size, uint8_t* out) = 0;
+};
 
 // Represents the resource fork of a file.
 //
@@ -30,6 +47,21 @@ class ResourceFork {
     // @param [in] options  Miscellaneous options.
     ResourceFork(const pn::data_view& data, const Options& options);
 
+    // Reads the resource fork through `reader`.  Only the header and resource map are read on
+    // construction; the data of each resource is read the first time it is requested.
+    //
+    // @param [in] reader   Reads the resource fork of a file.
+    // @param [in] options  Miscellaneous options.
+    ResourceFork(std::unique_ptr<ForkReader> reader, const Options& options);
+
+    // Checks whether a file could be a flat resource fork, from its header alone.
+    //
+    // @param [in] header   At least the first 16 bytes of the file.
+    // @param [in] size     The size of the whole file.
+    // @returns             True if the header describes data and map sections which fit within
+    //                      the file, without overlapping.
+    static bool has_header(const pn::data_view& header, uint64_t size);
+
     ResourceFork(ResourceFork&&) = default;
     ResourceFork& operator=(ResourceFork&&) = default;
 
@@ -77,9 +109,16 @@ class ResourceFork {
     const_iterator end() const;
 
   private:
+    void read_types(
+            const pn::data_view& map_data, const ResourceData& data, const Options& options);
+
     // The map represented by this object.
     sfz::StringMap<std::unique_ptr<ResourceType>> _types;
 
+    // If the fork is read through a ForkReader, the reader and the resource map it read.
+    std::unique_ptr<ForkReader> _reader;
+    pn::data                    _map;
+
     ResourceFork(const ResourceFork&) = delete;
     ResourceFork& operator=(const ResourceFork&) = delete;
 };
@@ -104,6 +143,9 @@ class ResourceType {
     // @throws std::runtime_error    If the resource type does not contain the given ID.
     const ResourceEntry& at(int16_t id) const;
 
+    // @returns             The number of entries of this type.
+    size_t size() const;
+
     // STL-like iterator type.
     class const_iterator {
       public:
@@ -143,11 +185,11 @@ class ResourceType {
     // @param [in] type_data A block of data containing all resource types.
     // @param [in] index    The index of the particular type to read in.
     // @param [in] name_data The block of data containing all resource names.
-    // @param [in] data_data The block of data containing all resource data.
+    // @param [in] data   The resource data section of the fork.
     // @param [in] options  Miscellaneous options.
     ResourceType(
             const pn::data_view& type_data, int index, const pn::data_view& name_data,
-            const pn::data_view& data_data, const Options& options);
+            const ResourceData& data, const Options& options);
 
     // The 4-character code of this resource type.
     pn::string _code;
@@ -174,8 +216,15 @@ class ResourceEntry {
     const pn::string& name() const;
 
     // @returns             The block of data corresponding to this entry.
+    // @throws std::runtime_error    If the fork is read through a ForkReader, and the data could
+    //                               not be read, or extends past the end of the fork.
     const pn::data_view& data() const;
 
+    // Frees the data read by data(), if the fork is read through a ForkReader, so that commands
+    // which visit every resource only hold one at a time.  The data is read again if data() is
+    // called again.  Views returned by earlier calls to data() are invalidated.
+    void release() const;
+
   private:
     friend class ResourceType;
 
@@ -184,11 +233,11 @@ class ResourceEntry {
     // @param [in] entry_data A block of data containing all resource entries for a type.
     // @param [in] index    The index of the particular entry to read in.
     // @param [in] name_data The block of data containing all resource names.
-    // @param [in] data_data The block of data containing all resource data.
+    // @param [in] data   The resource data section of the fork.
     // @param [in] options  Miscellaneous options.
     ResourceEntry(
             const pn::data_view& entry_data, int index, const pn::data_view& name_data,
-            const pn::data_view& data_data, const Options& options);
+            const ResourceData& data, const Options& options);
 
     // The ID of this resource entry.
     int16_t _id;
@@ -196,8 +245,14 @@ class ResourceEntry {
     // The name of this entry (if any).
     pn::string _name;
 
-    // The block of data corresponding to this entry.
-    pn::data_view _data;
+    // The block of data corresponding to this entry.  If the fork is read through a ForkReader,
+    // the data is read into `_owned` by the first call to data(), from `_offset` within the fork,
+    // and `_loaded` is set until release() is called.
+    mutable pn::data_view _data;
+    mutable pn::data      _owned;
+    mutable bool          _loaded;
+    ForkReader*           _reader;
+    uint64_t              _offset;
 
     ResourceEntry(const ResourceEntry&) = delete;
     ResourceEntry& operator=(const ResourceEntry&) = delete;
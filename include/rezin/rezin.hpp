@@ -9,10 +9,13 @@
 #include <rezin/apple-single.hpp>
 #include <rezin/cicn.hpp>
 #include <rezin/clut.hpp>
+#include <rezin/emitter.hpp>
 #include <rezin/options.hpp>
 #include <rezin/pict.hpp>
+#include <rezin/probe.hpp>
 #include <rezin/resource.hpp>
 #include <rezin/snd.hpp>
 #include <rezin/strl.hpp>
+#include <rezin/tmpl.hpp>
 
 #endif  // REZIN_REZIN_HPP_
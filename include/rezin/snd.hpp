@@ -6,7 +6,9 @@
 #ifndef REZIN_SND_HPP_
 #define REZIN_SND_HPP_
 
+#include <memory>
 #include <sfz/sfz.hpp>
+#include <vector>
 
 namespace rezin {
 
@@ -15,30 +17,97 @@ struct AiffSound;
 // Reads 'snd ' resource data object.
 //
 // "format" specifies whether the source was a version 1 or version 2 'snd ' resource.  "channels"
-// gives the number of sound channels; currently only "1" (mono) is supported.  "sample_bits" gives
-// the number of bits per sample, which is always 8.  "sample_rate" is the sample rate for the
-// samples, usually 44100, 22050, or 11025.  "samples" is an array of integral samples in the range
-// [0, 255].
+// gives the number of sound channels.  "sample_bits" gives the number of bits per sample, 8 or 16.
+// "sample_rate" is the sample rate for the samples, usually 44100, 22050, or 11025.  "samples" is
+// an array of interleaved sample frames; 8-bit samples are unsigned, in the range [0, 255], and
+// 16-bit samples are signed and big-endian.
 //
-// @param [in] in       The content of a 'snd ' resource.
+// Standard, extended, and compressed sound headers are supported.  IMA4, MACE 3:1, and MACE 6:1
+// compressed sounds are decoded to 16-bit samples.
+//
+// For uncompressed sounds, only the headers of the resource are parsed; "samples" points into
+// `in` rather than holding a copy of the sample data.  Compressed sounds are decoded into
+// "decoded", which "samples" then points into.  Use `samples.copy()` to get a copy which outlives
+// the resource.
+//
+// If the resource refers to more than one sound header (see SoundList), the tracks are
+// concatenated into "decoded", which requires them all to have the same sample format.
+//
+// @param [in] in       The content of a 'snd ' resource.  The block of memory must remain valid
+//                      for the lifetime of this object; it is not copied.
 // @throws std::runtime_error    If the 'snd ' data could not be read.
 struct Sound {
+    Sound();
     Sound(pn::data_view in);
 
-    uint16_t             fmt;
-    uint32_t             channels;
-    uint32_t             sample_bits;
-    double               sample_rate;
-    std::vector<uint8_t> samples;
+    // The number of sample frames: samples per channel.
+    uint32_t frames() const;
+
+    uint16_t                                     fmt;
+    uint32_t                                     channels;
+    uint32_t                                     sample_bits;
+    double                                       sample_rate;
+    pn::data_view                                samples;
+    std::shared_ptr<const std::vector<uint8_t>> decoded;
 };
 
+// Reads all of the sounds referred to by a 'snd ' resource.
+//
+// The command list of the resource is walked in a single pass, and each soundCmd or bufferCmd
+// which points to a sound header adds a track, in the order they appear.  Several commands
+// pointing to the same header add a single track.  As with Sound, the samples of the tracks
+// point into `in`.
+//
+// @param [in] in       The content of a 'snd ' resource.  The block of memory must remain valid
+//                      for the lifetime of this object; it is not copied.
+// @throws std::runtime_error    If the 'snd ' data could not be read.
+struct SoundList {
+    SoundList(pn::data_view in);
+
+    uint16_t           fmt;
+    std::vector<Sound> tracks;
+};
+
+// Converts a Sound to a different sample rate.
+//
+// Uses a windowed-sinc low-pass filter, precomputed at a fixed number of fractional phases, with
+// its cutoff at the lower of the two Nyquist frequencies.  The result always has 16-bit samples,
+// which it owns.
+//
+// @param [in] sound        The sound to convert.
+// @param [in] sample_rate  The sample rate of the result, in Hz.
+// @throws std::runtime_error    If either sample rate is not positive.
+Sound resample(const Sound& sound, double sample_rate);
+
 // Converts a Sound into AIFF data.
 //
-// Sound data is required to be as returned by read_snd().  It would be possible for us to
-// interpret a wider range of sound data (e.g. "sample_bits" of 16) but currently we observe the
-// same restrictions on input as read_snd() does on output.
+// The samples are converted to AIFF's signed, big-endian representation.
 pn::data aiff(const Sound& sound);
 
+// Writes a Sound as AIFF data to `out`.
+//
+// The output is written in a single pass, without buffering the whole file; aiff() is a
+// convenience wrapper around this.
+//
+// @param [out] out     The pn::file_view to write the AIFF data to.
+// @param [in] sound    The sound to write.
+void write_aiff(pn::file_view out, const Sound& sound);
+
+// Converts a Sound into WAV data.
+//
+// As with AIFF, write_wav() writes the data in a single pass, and wav() wraps it.
+pn::data wav(const Sound& sound);
+void     write_wav(pn::file_view out, const Sound& sound);
+
+// Writes the samples of a Sound with no header, encoded as in the "data" chunk of a WAV file.
+//
+// 8-bit samples are unsigned.
+void write_pcm(pn::file_view out, const Sound& sound);
+
+// Writes the samples of a Sound with no header, as 16-bit signed little-endian samples,
+// regardless of the sample size of the sound.
+void write_pcm16(pn::file_view out, const Sound& sound);
+
 }  // namespace rezin
 
 #endif  // REZIN_SND_HPP_
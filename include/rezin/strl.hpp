@@ -6,21 +6,52 @@
 #ifndef REZIN_STRL_HPP_
 #define REZIN_STRL_HPP_
 
+#include <rezin/emitter.hpp>
+#include <rezin/options.hpp>
 #include <sfz/sfz.hpp>
 #include <vector>
 
 namespace rezin {
 
-struct Options;
-
-struct StringList {
+// Reads a 'STR#' resource.
+//
+// Constructing a StringList only finds where each Pascal string starts, in a single pass over
+// the resource.  Strings are decoded when they are accessed, so looking up a single string of a
+// large list doesn't decode the others.
+//
+// @param [in] in       The content of a 'STR#' resource.  The block of memory must remain valid
+//                      for the lifetime of this object; it is not copied.
+// @param [in] options  Determines how strings are decoded.
+// @throws std::runtime_error    If the structure of the 'STR#' data could not be read.
+class StringList {
+  public:
     StringList(pn::data_view in, const Options& options);
 
-    std::vector<pn::string> strings;
+    // @returns             The number of strings in the list.
+    size_t size() const;
+
+    // @param [in] index    The index of a string in the list; must be less than size().
+    // @returns             The undecoded MacRoman bytes of the string.
+    pn::data_view data(size_t index) const;
+
+    // @param [in] index    The index of a string in the list; must be less than size().
+    // @returns             The string, decoded to UTF-8.
+    pn::string at(size_t index) const;
+
+    // @returns             All of the strings in the list, decoded to UTF-8.
+    std::vector<pn::string> strings() const;
+
+  private:
+    pn::data_view         _data;
+    Options               _options;
+    std::vector<uint32_t> _offsets;
 };
 
 pn::value value(const StringList& strings);
 
+// Writes the strings of `strings` as an array, decoding each as it is written.
+void emit(Emitter& out, const StringList& strings);
+
 }  // namespace rezin
 
 #endif  // REZIN_STRL_HPP_
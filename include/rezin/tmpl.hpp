@@ -0,0 +1,75 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#ifndef REZIN_TMPL_HPP_
+#define REZIN_TMPL_HPP_
+
+#include <stdint.h>
+#include <memory>
+#include <rezin/emitter.hpp>
+#include <rezin/options.hpp>
+#include <sfz/sfz.hpp>
+#include <vector>
+
+namespace rezin {
+
+class ResourceFork;
+
+// A resource template, as stored in a 'TMPL' resource and used by ResEdit.
+//
+// A template is a list of fields, each a Pascal string label followed by a 4-character field
+// type, describing the layout of resources of the type named by the 'TMPL' resource.  On
+// construction, the field list is compiled to a flat program, which emit() then runs over each
+// resource: there is no further parsing of the template, and lists are loops within the program.
+//
+// Each level of the template (the top level, or the body of a list) is written as a map from
+// labels to values, unless it has a single unlabeled field, in which case it is written as that
+// field's value alone.  Fillers, alignment, and list counts are not written.
+//
+// @param [in] in       The content of a 'TMPL' resource.
+// @param [in] options  Determines how labels and strings are decoded.
+// @throws std::runtime_error    If the template is malformed or uses an unsupported field type.
+class Template {
+  public:
+    Template(pn::data_view in, const Options& options);
+    ~Template();
+
+    // Decodes a resource, writing it to `out`.
+    //
+    // @param [in] out      Receives the fields of the resource.
+    // @param [in] in       The content of a resource of the type this template describes.
+    // @throws std::runtime_error    If the resource does not match the template.
+    void emit(Emitter& out, pn::data_view in) const;
+
+  private:
+    struct Field;
+    struct Op;
+    struct Case;
+
+    static size_t list_end(const std::vector<Field>& fields, size_t begin, size_t end);
+    void          compile(const std::vector<Field>& fields, size_t begin, size_t end);
+    void          compile_field(const Field& field, uint16_t key);
+    void          check_bits() const;
+    uint16_t      add_key(const Field& field, bool is_map);
+
+    Options                        _options;
+    std::vector<Op>                _ops;
+    std::vector<pn::string>        _keys;
+    std::vector<std::vector<Case>> _cases;
+};
+
+// Finds and compiles the template for a resource type.
+//
+// @param [in] rsrc     The fork to find 'TMPL' resources in.
+// @param [in] type     The 4-character code of a resource type, e.g. "vers".
+// @param [in] options  Determines how the template is decoded.
+// @returns             The template for `type`, or nullptr if the fork has none.
+// @throws std::runtime_error    If the template for `type` could not be compiled.
+std::unique_ptr<Template> find_template(
+        const ResourceFork& rsrc, pn::string_view type, const Options& options);
+
+}  // namespace rezin
+
+#endif  // REZIN_TMPL_HPP_
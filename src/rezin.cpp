@@ -4,8 +4,11 @@
 // under the terms of the MIT License.
 
 #include <getopt.h>
+#include <deque>
 #include <exception>
+#include <future>
 #include <rezin/apple-single.hpp>
+#include <rezin/commands/atlas.hpp>
 #include <rezin/commands/cat.hpp>
 #include <rezin/commands/convert.hpp>
 #include <rezin/commands/ls.hpp>
@@ -13,7 +16,13 @@
 #include <rezin/resource.hpp>
 #include <rezin/source.hpp>
 #include <rezin/sources/apple-single.hpp>
+#include <rezin/sources/binhex.hpp>
+#include <rezin/sources/detect.hpp>
+#include <rezin/sources/directory.hpp>
 #include <rezin/sources/file.hpp>
+#include <rezin/sources/hfs.hpp>
+#include <rezin/sources/mac-binary.hpp>
+#include <rezin/sources/stdin.hpp>
 #include <rezin/sources/zip.hpp>
 #include <vector>
 
@@ -27,22 +36,51 @@ const char help[] =
         "usage: rezin [options] ls [type [id]]\n"
         "       rezin [options] cat type id\n"
         "       rezin [options] convert type id\n"
+        "       rezin [options] atlas audio index\n"
         "\n"
         "rezin is a tool for extracting data from the resource fork of legacy files.\n"
         "\n"
         "sources:\n"
         " -a, --apple-single=FILE     read from an AppleSingle/AppleDouble file\n"
         " -f, --flat-file=FILE        read from a flat file\n"
+        " -b, --mac-binary=FILE       read from a MacBinary file\n"
+        " -x, --binhex=FILE           read from a BinHex 4.0 file\n"
+        " -i, --input=FILE            read from a file in any of the formats above,\n"
+        "                             detected from its content\n"
         " -z, --zip-file=ZIP,FILE     read from a file enclosed in a zip archive\n"
+        " -Z, --zip-archive=ZIP       read from every file enclosed in a zip archive\n"
+        " -d, --directory=DIR         read from every file within a directory tree\n"
+        " -H, --hfs=IMAGE             read from every file on an HFS or HFS+ disk image\n"
+        " -, --stdin                  read from standard input, in any of the formats\n"
+        "                             accepted by --input\n"
         "\n"
         "options:\n"
         " -l, --line-ending=CRNL      convert cr (\\r) to cr, nl, or crnl (default: nl)\n"
+        " -L, --long                  with ls, also print size and metadata of resources\n"
+        " -m, --max-size=N            with convert, scale images down to fit in N pixels\n"
+        " -A, --audio-format=FORMAT   with convert, write sounds as aiff, wav, or raw\n"
+        "                             (default: aiff)\n"
+        " -T, --track=N               with convert, write only track N of a sound\n"
+        " -r, --sample-rate=HZ        with convert and atlas, resample sounds to HZ\n"
+        " -F, --format=FORMAT         with convert, write tables as procyon or json\n"
+        "                             (default: procyon)\n"
+        " -j, --jobs=N                decompress up to N files from an archive at once\n"
+        "                             (default: 1)\n"
+        " -W, --window=N              decompress zipped files as they are read, keeping\n"
+        "                             about N MiB of each (per job) in memory\n"
+        " -O, --max-open=N            with --directory, map at most N files at once\n"
+        "                             (default: 64)\n"
+        " -M, --max-mapped=N          with --directory, map at most N MiB at once\n"
+        "                             (default: 1024)\n"
+        " -S, --stdin-size=N          with --stdin, allocate N MiB for input from a pipe\n"
         "\n"
         "commands:\n"
         "     ls [type [id]]          list resource types or IDs\n"
         "     cat type id             print content of a resource as raw data\n"
         "     convert type id         print converted form of a resource if possible\n"
-        "                             (if not, print the raw data with a warning)\n";
+        "                             (if not, print the raw data with a warning)\n"
+        "     atlas audio index       write all sounds as 16-bit PCM to one file, and an\n"
+        "                             index of their offsets to another\n";
 
 Options::LineEnding parse_line_ending(pn::string_view s) {
     if (s == "cr") {
@@ -56,6 +94,73 @@ Options::LineEnding parse_line_ending(pn::string_view s) {
     }
 }
 
+Options::Format parse_format(pn::string_view s) {
+    if (s == "procyon") {
+        return Options::PROCYON;
+    } else if (s == "json") {
+        return Options::JSON;
+    } else {
+        throw std::runtime_error("must be one of procyon|json");
+    }
+}
+
+Options::AudioFormat parse_audio_format(pn::string_view s) {
+    if (s == "aiff") {
+        return Options::AIFF;
+    } else if (s == "wav") {
+        return Options::WAV;
+    } else if (s == "raw") {
+        return Options::RAW;
+    } else {
+        throw std::runtime_error("must be one of aiff|wav|raw");
+    }
+}
+
+int32_t parse_sample_rate(pn::string_view s) {
+    sfz::optional<int32_t> rate;
+    args::integer_option(s, &rate);
+    if (*rate <= 0) {
+        throw std::runtime_error("must be positive");
+    }
+    return *rate;
+}
+
+int32_t parse_track(pn::string_view s) {
+    sfz::optional<int32_t> track;
+    args::integer_option(s, &track);
+    if (*track < 0) {
+        throw std::runtime_error("must be nonnegative");
+    }
+    return *track;
+}
+
+int32_t parse_window(pn::string_view s) {
+    sfz::optional<int32_t> window;
+    args::integer_option(s, &window);
+    if ((*window <= 0) || (*window >= 4096)) {
+        throw std::runtime_error("must be between 1 and 4095");
+    }
+    return *window;
+}
+
+int32_t parse_count(pn::string_view s) {
+    sfz::optional<int32_t> n;
+    args::integer_option(s, &n);
+    if (*n <= 0) {
+        throw std::runtime_error("must be positive");
+    }
+    return *n;
+}
+
+int16_t parse_max_size(pn::string_view s) {
+    sfz::optional<int16_t> size;
+    args::integer_option(s, &size);
+    if (*size <= 0) {
+        throw std::runtime_error("must be positive");
+    }
+    return *size;
+}
+
 void print_nested_exception(const std::exception& e) {
     pn::format(stderr, ": {0}", e.what());
     try {
@@ -75,6 +180,59 @@ void print_exception(pn::string_view progname, const std::exception& e) {
     pn::format(stderr, "\n");
 }
 
+// Runs `command` on each fork of `source`, in order.
+//
+// While the command runs on one fork, up to `options.jobs - 1` of the following forks are
+// decompressed and parsed in the background.  Output is only written by the command, on this
+// thread, so it is never interleaved.  Errors in one fork of an archive are reported, but do not
+// stop the others; the process exits with an error once all have been tried.
+void run_all(
+        pn::string_view progname, const Source& source, const Command& command,
+        const Options& options) {
+    typedef std::future<std::unique_ptr<ResourceFork>> Pending;
+    const std::launch policy = (options.jobs > 1) ? std::launch::async : std::launch::deferred;
+    std::deque<Pending> pending;
+    size_t              next = 0;
+    auto                fill = [&]() {
+        while ((next < source.size()) && (pending.size() < size_t(options.jobs))) {
+            pending.push_back(
+                    std::async(policy, &Source::open, &source, next++, std::cref(options)));
+        }
+    };
+
+    bool failed = false;
+    bool first  = true;
+    for (size_t i = 0; i < source.size(); ++i) {
+        fill();
+        Pending         fork = std::move(pending.front());
+        pn::string_view name = source.name(i);
+        pending.pop_front();
+        if (name.empty()) {
+            command.begin_fork(name);
+            command.run(*fork.get(), options);
+            continue;
+        }
+
+        try {
+            std::unique_ptr<ResourceFork> rsrc = fork.get();
+            if (rsrc) {
+                pn::format(stdout, "{0}{1}:\n", first ? "" : "\n", name);
+                first = false;
+                command.begin_fork(name);
+                command.run(*rsrc, options);
+            }
+        } catch (const std::exception& e) {
+            fflush(stdout);
+            print_exception(pn::format("{0}: {1}", progname, name), e);
+            failed = true;
+        }
+        source.close(i);
+    }
+    if (failed) {
+        exit(1);
+    }
+}
+
 void main(int argc, char** argv) {
     std::unique_ptr<Command> command;
     std::unique_ptr<Source>  source;
@@ -82,11 +240,15 @@ void main(int argc, char** argv) {
 
     args::callbacks callbacks;
 
-    callbacks.argument = [&command](pn::string_view arg) {
+    callbacks.argument = [&command, &source, &options](pn::string_view arg) {
         if (command) {
             return command->argument(arg);
+        } else if (arg == "-") {
+            source.reset(new StdinSource(options));
         } else if (arg == "convert") {
             command.reset(new ConvertCommand);
+        } else if (arg == "atlas") {
+            command.reset(new AtlasCommand);
         } else if (arg == "cat") {
             command.reset(new CatCommand);
         } else if (arg == "ls") {
@@ -102,23 +264,77 @@ void main(int argc, char** argv) {
         switch (opt.value()) {
             case 'a': source.reset(new AppleSingleSource(get_value())); break;
             case 'f': source.reset(new FlatFileSource(get_value())); break;
+            case 'b': source.reset(new MacBinarySource(get_value())); break;
+            case 'x': source.reset(new BinHexSource(get_value())); break;
+            case 'i': source.reset(new DetectedFileSource(get_value())); break;
             case 'z': source.reset(new ZipSource(get_value())); break;
+            case 'Z': source.reset(new ZipArchiveSource(get_value())); break;
+            case 'd': source.reset(new DirectorySource(get_value())); break;
+            case 'H': source.reset(new HfsSource(get_value())); break;
             case 'l': options.line_ending = parse_line_ending(get_value()); break;
+            case 'L': options.long_listing = true; break;
+            case 'm': options.max_size = parse_max_size(get_value()); break;
+            case 'A': options.audio_format = parse_audio_format(get_value()); break;
+            case 'T': options.track = parse_track(get_value()); break;
+            case 'r': options.sample_rate = parse_sample_rate(get_value()); break;
+            case 'F': options.format = parse_format(get_value()); break;
+            case 'j': options.jobs = parse_count(get_value()); break;
+            case 'W': options.window = parse_window(get_value()); break;
+            case 'O': options.max_open = parse_count(get_value()); break;
+            case 'M': options.max_mapped = parse_count(get_value()); break;
+            case 'S': options.stdin_size = parse_count(get_value()); break;
             default: return false;
         }
         return true;
     };
 
-    callbacks.long_option =
-            [&callbacks](pn::string_view opt, const args::callbacks::get_value_f& get_value) {
+    callbacks.long_option = [&callbacks, &source, &options](
+                                    pn::string_view                     opt,
+                                    const args::callbacks::get_value_f& get_value) {
                 if (opt == "--apple-single") {
                     return callbacks.short_option(pn::rune{'a'}, get_value);
                 } else if (opt == "--flat-file") {
                     return callbacks.short_option(pn::rune{'f'}, get_value);
+                } else if (opt == "--mac-binary") {
+                    return callbacks.short_option(pn::rune{'b'}, get_value);
+                } else if (opt == "--binhex") {
+                    return callbacks.short_option(pn::rune{'x'}, get_value);
+                } else if (opt == "--input") {
+                    return callbacks.short_option(pn::rune{'i'}, get_value);
                 } else if (opt == "--zip-file") {
                     return callbacks.short_option(pn::rune{'z'}, get_value);
+                } else if (opt == "--zip-archive") {
+                    return callbacks.short_option(pn::rune{'Z'}, get_value);
+                } else if (opt == "--directory") {
+                    return callbacks.short_option(pn::rune{'d'}, get_value);
+                } else if (opt == "--hfs") {
+                    return callbacks.short_option(pn::rune{'H'}, get_value);
+                } else if (opt == "--stdin") {
+                    source.reset(new StdinSource(options));
                 } else if (opt == "--line-ending") {
                     return callbacks.short_option(pn::rune{'l'}, get_value);
+                } else if (opt == "--long") {
+                    return callbacks.short_option(pn::rune{'L'}, get_value);
+                } else if (opt == "--max-size") {
+                    return callbacks.short_option(pn::rune{'m'}, get_value);
+                } else if (opt == "--audio-format") {
+                    return callbacks.short_option(pn::rune{'A'}, get_value);
+                } else if (opt == "--track") {
+                    return callbacks.short_option(pn::rune{'T'}, get_value);
+                } else if (opt == "--sample-rate") {
+                    return callbacks.short_option(pn::rune{'r'}, get_value);
+                } else if (opt == "--format") {
+                    return callbacks.short_option(pn::rune{'F'}, get_value);
+                } else if (opt == "--jobs") {
+                    return callbacks.short_option(pn::rune{'j'}, get_value);
+                } else if (opt == "--window") {
+                    return callbacks.short_option(pn::rune{'W'}, get_value);
+                } else if (opt == "--max-open") {
+                    return callbacks.short_option(pn::rune{'O'}, get_value);
+                } else if (opt == "--max-mapped") {
+                    return callbacks.short_option(pn::rune{'M'}, get_value);
+                } else if (opt == "--stdin-size") {
+                    return callbacks.short_option(pn::rune{'S'}, get_value);
                 } else {
                     return false;
                 }
@@ -136,8 +352,7 @@ void main(int argc, char** argv) {
             exit(1);
         }
         source->load();
-        ResourceFork fork(source->data(), options);
-        command->run(fork, options);
+        run_all(argv[0], *source, *command, options);
     } catch (const std::exception& e) {
         print_exception(argv[0], e);
         exit(1);
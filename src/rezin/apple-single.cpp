@@ -5,7 +5,7 @@
 
 #include <rezin/apple-single.hpp>
 
-#include <arpa/inet.h>
+#include <rezin/endian.hpp>
 #include <sfz/sfz.hpp>
 
 using sfz::hex;
@@ -36,62 +36,103 @@ enum AppleSingleVersion {
     APPLE_SINGLE_VERSION_2 = 0x00020000,
 };
 
-}  // namespace
+// The header and entry descriptors of an AppleSingle file, in either byte order.
+template <template <typename> class Int>
+struct AppleSingleHeader {
+    Int<uint32_t> magic;
+    Int<uint32_t> version;
+    uint8_t       filler[16];
+    Int<uint16_t> entry_count;
+};
 
-AppleSingle::AppleSingle(const pn::data_view& data) {
-    bool     little_endian = false;
-    pn::file remainder     = data.open();
-    uint32_t magic;
-    remainder.read(&magic).check();
+template <template <typename> class Int>
+struct EntryDescriptor {
+    Int<uint32_t> id;
+    Int<uint32_t> offset;
+    Int<uint32_t> length;
+};
+
+// Calls `f(id, offset, length)` for each entry descriptor in `data`, which need not extend past
+// the descriptors.
+template <template <typename> class Int, typename F>
+void read_entries(const pn::data_view& data, F f) {
+    const AppleSingleHeader<Int>& header      = overlay<AppleSingleHeader<Int>>(data);
+    const uint32_t                version     = header.version;
+    const uint16_t                entry_count = header.entry_count;
+    switch (version) {
+        case APPLE_SINGLE_VERSION_2: {
+            for (uint16_t i : range(entry_count)) {
+                const EntryDescriptor<Int>& entry = overlay<EntryDescriptor<Int>>(
+                        data, sizeof(AppleSingleHeader<Int>) + (i * sizeof(EntryDescriptor<Int>)));
+                f(uint32_t(entry.id), uint32_t(entry.offset), uint32_t(entry.length));
+            }
+        } break;
+
+        default:
+            throw std::runtime_error(
+                    pn::format("unknown version {0}.", version / 65536.0).c_str());
+    }
+}
+
+template <typename F>
+void read_entries(const pn::data_view& data, F f) {
+    const uint32_t magic = overlay<be<uint32_t>>(data);
     switch (magic) {
         case APPLE_SINGLE_MAGIC:
-        case APPLE_DOUBLE_MAGIC: break;
+        case APPLE_DOUBLE_MAGIC: read_entries<be>(data, f); break;
 
         case APPLE_SINGLE_CIGAM:
-        case APPLE_DOUBLE_CIGAM: little_endian = true; break;
+        case APPLE_DOUBLE_CIGAM: read_entries<le>(data, f); break;
 
         default:
             throw std::runtime_error(
                     pn::format("invalid magic number 0x{0}.", hex(magic, 8)).c_str());
     }
+}
 
-    uint32_t version;
-    remainder.read(&version).check();
-    if (little_endian) {
-        version = htonl(version);
-    }
-
-    switch (version) {
-        case APPLE_SINGLE_VERSION_2: {
-            uint16_t entry_count;
-            remainder.read(pn::pad(16), &entry_count).check();
-            if (little_endian) {
-                entry_count = htons(entry_count);
-            }
+}  // namespace
 
-            for (uint16_t i : range(entry_count)) {
-                static_cast<void>(i);
-                uint32_t id;
-                uint32_t offset;
-                uint32_t length;
-                remainder.read(&id, &offset, &length).check();
-
-                if (little_endian) {
-                    id     = htonl(id);
-                    offset = htonl(offset);
-                    length = htonl(length);
-                }
-
-                _entries.insert(std::make_pair(id, data.slice(offset, length)));
-            }
-        } break;
+AppleSingle::AppleSingle(const pn::data_view& data) {
+    read_entries(data, [this, &data](uint32_t id, uint32_t offset, uint32_t length) {
+        _entries.insert(std::make_pair(id, data.slice(offset, length)));
+    });
+}
 
-        default:
-            throw std::runtime_error(
-                    pn::format("unknown version {0}.", version / 65536.0).c_str());
+bool AppleSingle::has_magic(const pn::data_view& header) {
+    if (header.size() < 4) {
+        return false;
+    }
+    switch (overlay<be<uint32_t>>(header)) {
+        case APPLE_SINGLE_MAGIC:
+        case APPLE_DOUBLE_MAGIC:
+        case APPLE_SINGLE_CIGAM:
+        case APPLE_DOUBLE_CIGAM: return true;
+        default: return false;
     }
 }
 
+size_t AppleSingle::header_size(const pn::data_view& data) {
+    // Both byte orders have the same layout; only the entry count needs to be read.
+    const uint32_t magic = overlay<be<uint32_t>>(data);
+    const uint16_t count = ((magic == APPLE_SINGLE_CIGAM) || (magic == APPLE_DOUBLE_CIGAM))
+                                   ? overlay<AppleSingleHeader<le>>(data).entry_count
+                                   : overlay<AppleSingleHeader<be>>(data).entry_count;
+    return sizeof(AppleSingleHeader<be>) + (count * sizeof(EntryDescriptor<be>));
+}
+
+bool AppleSingle::locate(
+        const pn::data_view& header, uint32_t id, uint64_t* offset, uint64_t* length) {
+    bool found = false;
+    read_entries(header, [id, offset, length, &found](uint32_t i, uint32_t o, uint32_t l) {
+        if (i == id) {
+            *offset = o;
+            *length = l;
+            found   = true;
+        }
+    });
+    return found;
+}
+
 const pn::data_view& AppleSingle::at(uint32_t id) {
     std::map<uint32_t, pn::data_view>::const_iterator it = _entries.find(id);
     if (it == _entries.end()) {
@@ -100,4 +141,6 @@ const pn::data_view& AppleSingle::at(uint32_t id) {
     return it->second;
 }
 
+bool AppleSingle::contains(uint32_t id) const { return _entries.find(id) != _entries.end(); }
+
 }  // namespace rezin
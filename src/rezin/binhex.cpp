@@ -0,0 +1,272 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#include <rezin/binhex.hpp>
+
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <rezin/crc16.hpp>
+#include <rezin/endian.hpp>
+
+namespace rezin {
+
+namespace {
+
+const char kTag[]      = "(This file must be converted with BinHex";
+const char kAlphabet[] = "!\"#$%&'()*+,-012345689@ABCDEFGHIJKLMNPQRSTUVXYZ[`abcdefhijklmpqr";
+
+// Entries of the decode table which are not 6-bit values.  Each has one of the top two bits set,
+// so a group of characters is all values if the OR of their entries has neither.
+const uint8_t kSkip    = 0x40;  // line breaks and other whitespace.
+const uint8_t kEnd     = 0x80;  // the closing colon.
+const uint8_t kInvalid = 0xc0;
+
+const uint8_t kRunLengthEscape = 0x90;
+
+typedef std::array<uint8_t, 256> DecodeTable;
+
+DecodeTable make_decode_table() {
+    DecodeTable table;
+    table.fill(kInvalid);
+    for (int i = 0; i < 64; ++i) {
+        table[uint8_t(kAlphabet[i])] = i;
+    }
+    for (uint8_t ch : {'\t', '\n', '\r', ' '}) {
+        table[ch] = kSkip;
+    }
+    table[':'] = kEnd;
+    return table;
+}
+
+const DecodeTable& decode_table() {
+    static const DecodeTable table = make_decode_table();
+    return table;
+}
+
+const uint8_t* find_tag(const pn::data_view& data) {
+    const uint8_t* begin = data.data();
+    const uint8_t* end   = begin + data.size();
+    const uint8_t* tag   = reinterpret_cast<const uint8_t*>(kTag);
+    const uint8_t* found = std::search(begin, end, tag, tag + strlen(kTag));
+    return (found == end) ? nullptr : found;
+}
+
+// Receives the decoded bytes of the file, one at a time, and sorts them into its parts, checking
+// the CRC at the end of each.
+//
+// The resource fork is allocated at the length given in the header.  That length is untrusted, so
+// it is first checked against `max_size`, the most that the encoded text could decode to.
+class Unpacker {
+  public:
+    Unpacker(pn::data* resource_fork, uint64_t max_size)
+            : _part(NAME_LENGTH),
+              _remaining(0),
+              _filled(0),
+              _stored_crc(0),
+              _max_size(max_size),
+              _rsrc(resource_fork) {}
+
+    void add(uint8_t byte) {
+        switch (_part) {
+            case NAME_LENGTH:
+                _crc.add(byte);
+                if ((byte < 1) || (byte > 63)) {
+                    throw std::runtime_error("invalid BinHex file name length");
+                }
+                _header[_filled++] = byte;
+                _part              = HEADER;
+                _remaining = byte + kHeaderFieldsSize;
+                break;
+
+            case HEADER:
+                _crc.add(byte);
+                _header[_filled++] = byte;
+                if (--_remaining == 0) {
+                    begin_crc();
+                }
+                break;
+
+            case DATA:
+                _crc.add(byte);
+                if (--_remaining == 0) {
+                    begin_crc();
+                }
+                break;
+
+            case RESOURCE:
+                _crc.add(byte);
+                (*_rsrc)[_filled++] = byte;
+                if (--_remaining == 0) {
+                    begin_crc();
+                }
+                break;
+
+            case HEADER_CRC:
+            case DATA_CRC:
+            case RESOURCE_CRC:
+                _stored_crc = (_stored_crc << 8) | byte;
+                if (++_filled == 2) {
+                    end_crc();
+                }
+                break;
+
+            case DONE: break;
+        }
+    }
+
+    // @throws std::runtime_error    If the file ended before its resource fork did.
+    void finish() const {
+        if (_part != DONE) {
+            throw std::runtime_error("unexpected end of BinHex data");
+        }
+    }
+
+  private:
+    // The parts of a file, in order.
+    enum Part {
+        NAME_LENGTH,
+        HEADER,
+        HEADER_CRC,
+        DATA,
+        DATA_CRC,
+        RESOURCE,
+        RESOURCE_CRC,
+        DONE,
+    };
+
+    // The header is the length of the name, the name, and then these fields: version, type,
+    // creator, flags, data length, and resource length.
+    static const uint32_t kHeaderFieldsSize = 1 + 4 + 4 + 2 + 4 + 4;
+
+    void begin_crc() {
+        _part       = Part(_part + 1);
+        _filled     = 0;
+        _stored_crc = 0;
+    }
+
+    void end_crc() {
+        if (_stored_crc != _crc.value()) {
+            throw std::runtime_error("BinHex CRC mismatch");
+        }
+        _crc    = Crc16();
+        _filled = 0;
+        switch (_part) {
+            case HEADER_CRC: {
+                const pn::data_view fields{_header + 1 + _header[0], kHeaderFieldsSize};
+                const uint32_t      data_size = overlay<be<uint32_t>>(fields, 11);
+                const uint32_t      rsrc_size = overlay<be<uint32_t>>(fields, 15);
+                if ((uint64_t(data_size) + rsrc_size) > _max_size) {
+                    throw std::runtime_error("BinHex forks are longer than the file could hold");
+                }
+                _part      = DATA;
+                _remaining = data_size;
+                _rsrc->resize(rsrc_size);
+                break;
+            }
+            case DATA_CRC:
+                _part      = RESOURCE;
+                _remaining = _rsrc->size();
+                break;
+            default: _part = DONE; return;
+        }
+        if (_remaining == 0) {
+            begin_crc();
+        }
+    }
+
+    Part      _part;
+    uint32_t  _remaining;
+    uint32_t  _filled;
+    uint16_t  _stored_crc;
+    uint64_t  _max_size;
+    Crc16     _crc;
+    uint8_t   _header[1 + 63 + kHeaderFieldsSize];
+    pn::data* _rsrc;
+};
+
+}  // namespace
+
+bool BinHex::has_header(const pn::data_view& header) { return find_tag(header) != nullptr; }
+
+BinHex::BinHex(const pn::data_view& data) {
+    const uint8_t* p = find_tag(data);
+    if (!p) {
+        throw std::runtime_error("not a BinHex file");
+    }
+    const uint8_t* end = data.data() + data.size();
+    p                  = std::find(p, end, ':');
+    if (p == end) {
+        throw std::runtime_error("unexpected end of BinHex data");
+    }
+    ++p;
+
+    // Undoes the run-length encoding: 0x90 followed by a count repeats the last byte until it
+    // has appeared `count` times in all; followed by 0, it is a literal 0x90.  So each 4
+    // characters decode to 3 bytes, each of which stands for at most 255 bytes of the file.
+    Unpacker unpack(&_resource_fork, (uint64_t(end - p) * 3 / 4) * 255);
+    bool     escaped = false;
+    uint8_t  last    = 0;
+    auto     put     = [&unpack, &escaped, &last](uint8_t byte) {
+        if (escaped) {
+            escaped = false;
+            if (byte == 0) {
+                unpack.add(kRunLengthEscape);
+                last = kRunLengthEscape;
+            }
+            for (int i = 1; i < byte; ++i) {
+                unpack.add(last);
+            }
+        } else if (byte == kRunLengthEscape) {
+            escaped = true;
+        } else {
+            unpack.add(byte);
+            last = byte;
+        }
+    };
+
+    const DecodeTable& table = decode_table();
+    uint32_t           bits  = 0;
+    int                nbits = 0;
+    while (true) {
+        if (p == end) {
+            throw std::runtime_error("unexpected end of BinHex data");
+        }
+
+        // Most of the text is unbroken runs of encoded characters, which decode 4 to 3 bytes.
+        if ((nbits == 0) && ((end - p) >= 4)) {
+            const uint8_t a = table[p[0]], b = table[p[1]], c = table[p[2]], d = table[p[3]];
+            if (((a | b | c | d) & 0xc0) == 0) {
+                const uint32_t group = (a << 18) | (b << 12) | (c << 6) | d;
+                put(group >> 16);
+                put(group >> 8);
+                put(group);
+                p += 4;
+                continue;
+            }
+        }
+
+        const uint8_t value = table[*(p++)];
+        if (value < 64) {
+            bits = ((bits << 6) | value) & 0x3fff;
+            nbits += 6;
+            if (nbits >= 8) {
+                nbits -= 8;
+                put(bits >> nbits);
+            }
+        } else if (value == kEnd) {
+            break;
+        } else if (value == kInvalid) {
+            throw std::runtime_error("invalid character in BinHex data");
+        }
+    }
+    unpack.finish();
+}
+
+pn::data_view BinHex::resource_fork() const {
+    return pn::data_view{_resource_fork.data(), _resource_fork.size()};
+}
+
+}  // namespace rezin
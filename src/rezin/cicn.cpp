@@ -59,11 +59,24 @@ ColorIcon::ColorIcon(pn::data_view in) : rep(new Rep) {
 }
 
 ColorIcon::~ColorIcon() {}
-pn::data png(const ColorIcon& cicn) {
-    const ColorIcon::Rep& rep = *cicn.rep;
-    RasterImage           composite(rep.mask_bitmap.bounds);
-    composite.src(*rep.icon_pixmap_image, *rep.mask_bitmap_image);
-    return png(composite);
+
+// The icon is masked a row at a time as it is encoded, rather than composited into a full-size
+// image first; nothing else draws over it.
+pn::data png(const ColorIcon& cicn, int16_t max_size) {
+    const ColorIcon::Rep& rep    = *cicn.rep;
+    const Rect&           bounds = rep.mask_bitmap.bounds;
+    pn::data              d;
+    pn::file              f = d.open("w");
+    PngRowWriter          writer(f, bounds.width(), bounds.height(), max_size);
+    vector<AlphaColor>    row(bounds.width());
+    for (int16_t y = bounds.top; y < bounds.bottom; ++y) {
+        for (int16_t x = bounds.left; x < bounds.right; ++x) {
+            const bool opaque    = rep.mask_bitmap_image->get(x, y).alpha;
+            row[x - bounds.left] = opaque ? rep.icon_pixmap_image->get(x, y) : AlphaColor();
+        }
+        writer.append_row(row.data());
+    }
+    return d;
 }
 
 }  // namespace rezin
@@ -39,6 +39,19 @@ pn::value value(const ColorTable& color_table) {
     return std::move(m);
 }
 
+void emit(Emitter& out, const ColorTable& color_table) {
+    int key_width = 1;
+    if (!color_table.table.empty()) {
+        key_width = pn::format("{0}", color_table.table.rbegin()->first).size();
+    }
+    out.begin_map(key_width);
+    for (const auto& p : color_table.table) {
+        out.key(pn::format("{0}", p.first));
+        emit(out, p.second);
+    }
+    out.end_map();
+}
+
 void read_from(pn::file_view in, Color* out) {
     in.read(&out->red, &out->green, &out->blue).check();
 }
@@ -51,4 +64,15 @@ pn::value value(const Color& spec) {
     };
 }
 
+void emit(Emitter& out, const Color& spec) {
+    out.begin_map(1);
+    out.key("r");
+    out.value(spec.red / 65535.0 * 255);
+    out.key("g");
+    out.value(spec.green / 65535.0 * 255);
+    out.key("b");
+    out.value(spec.blue / 65535.0 * 255);
+    out.end_map();
+}
+
 }  // namespace rezin
@@ -6,7 +6,7 @@
 #ifndef REZIN_COMMAND_HPP_
 #define REZIN_COMMAND_HPP_
 
-#include <pn/fwd>
+#include <pn/string>
 
 namespace rezin {
 
@@ -18,6 +18,10 @@ class Command {
     virtual ~Command() {}
     virtual bool argument(pn::string_view arg)                               = 0;
     virtual void run(const ResourceFork& rsrc, const Options& options) const = 0;
+
+    // Called before each call to run(), with the name of the fork within its source (e.g. its
+    // path within an archive), or an empty string if the source has a single, unnamed fork.
+    virtual void begin_fork(pn::string_view name) const {}
 };
 
 }  // namespace rezin
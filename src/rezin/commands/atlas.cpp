@@ -0,0 +1,109 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#include <rezin/commands/atlas.hpp>
+
+#include <math.h>
+#include <stdint.h>
+#include <rezin/endian.hpp>
+#include <rezin/rezin.hpp>
+
+namespace rezin {
+
+AtlasCommand::AtlasCommand() : _offset(0) {}
+
+bool AtlasCommand::argument(pn::string_view arg) {
+    if (!_audio_path.has_value()) {
+        _audio_path.emplace(arg.copy());
+    } else if (!_index_path.has_value()) {
+        _index_path.emplace(arg.copy());
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void AtlasCommand::begin_fork(pn::string_view name) const { _fork_name = name.copy(); }
+
+void AtlasCommand::run(const ResourceFork& rsrc, const Options& options) const {
+    if (!_index_path.has_value()) {
+        throw std::runtime_error("atlas requires audio and index paths");
+    }
+
+    // Each sound is decoded and appended to the audio file as soon as it is parsed, so only the
+    // (small) index is held in memory; if the fork is streamed, the data of each sound is
+    // released once it is written.  Sounds which can't be read are skipped with a warning,
+    // rather than aborting the whole atlas.
+    if (!_audio.has_value()) {
+        _audio.emplace(pn::open(*_audio_path, "w"));
+    }
+    const ResourceType* sounds = nullptr;
+    for (const ResourceType& type : rsrc) {
+        if (type.code() == "snd ") {
+            sounds = &type;
+        }
+    }
+    if (!sounds) {
+        write_index();
+        return;
+    } else if (_forks.size() > UINT16_MAX) {
+        throw std::runtime_error("too many forks for atlas index");
+    }
+    const uint16_t fork = _forks.size();
+    _forks.push_back(_fork_name.copy());
+
+    for (const ResourceEntry& entry : *sounds) {
+        try {
+            Sound snd(entry.data());
+            if (options.sample_rate > 0) {
+                snd = resample(snd, options.sample_rate);
+            }
+            if (_offset > UINT32_MAX) {
+                throw std::runtime_error("too many samples for atlas index");
+            }
+            write_pcm16(*_audio, snd);
+            _entries.push_back(Entry{fork, entry.id(), uint16_t(snd.channels),
+                                     uint32_t(lround(snd.sample_rate * 65536.0)),
+                                     uint32_t(_offset), snd.frames()});
+            _offset += uint64_t(snd.frames()) * snd.channels;
+        } catch (const std::exception& e) {
+            pn::format(stderr, "warning: 'snd ' {0}: {1}\n", entry.id(), e.what());
+        }
+        entry.release();
+    }
+    write_index();
+}
+
+// Writes the index of the atlas.
+//
+// The index is a 16-byte header (the magic number "RZAT", a version number, and the numbers of
+// forks and sounds), followed by a 20-byte record for each sound, and then the name of each fork,
+// as a 16-bit length and that many bytes of UTF-8.  The records come first, so they are at fixed
+// offsets.  All integers are little-endian, to match the samples.
+void AtlasCommand::write_index() const {
+    pn::file out = pn::open(*_index_path, "w");
+    out.write(pn::string_view{"RZAT", 4}).check();
+    write_le32(out, 2);
+    write_le32(out, _forks.size());
+    write_le32(out, _entries.size());
+    for (const Entry& entry : _entries) {
+        write_le16(out, entry.fork);
+        write_le16(out, entry.id);
+        write_le16(out, entry.channels);
+        write_le16(out, 0);
+        write_le32(out, entry.sample_rate);
+        write_le32(out, entry.offset);
+        write_le32(out, entry.frames);
+    }
+    for (const pn::string& name : _forks) {
+        if (name.size() > UINT16_MAX) {
+            throw std::runtime_error("fork name too long for atlas index");
+        }
+        write_le16(out, name.size());
+        out.write(name).check();
+    }
+}
+
+}  // namespace rezin
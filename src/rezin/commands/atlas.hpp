@@ -0,0 +1,60 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#ifndef REZIN_COMMANDS_ATLAS_HPP_
+#define REZIN_COMMANDS_ATLAS_HPP_
+
+#include <rezin/command.hpp>
+#include <sfz/sfz.hpp>
+#include <vector>
+
+namespace rezin {
+
+class ResourceFork;
+
+// Writes every 'snd ' resource of a fork into a single file of PCM samples, and an index of
+// where each sound is within it.
+//
+// If the source has several forks, they share one atlas: the audio file is opened when the first
+// fork is run, and the sounds of each later fork are appended to it, in order.  Forks without
+// sounds are skipped.  The index names each fork with sounds, and records which fork each sound
+// came from, since IDs are only unique within a fork.  It is rewritten after each fork, so it
+// covers every sound written so far.
+class AtlasCommand : public Command {
+  public:
+    AtlasCommand();
+
+    virtual bool argument(pn::string_view arg);
+    virtual void run(const ResourceFork& rsrc, const Options& options) const;
+    virtual void begin_fork(pn::string_view name) const;
+
+  private:
+    // The location of a single sound within the atlas.
+    struct Entry {
+        uint16_t fork;  // The index of the fork in `_forks`.
+        int16_t  id;
+        uint16_t channels;
+        uint32_t sample_rate;  // 16.16 fixed-point, as in a sound header.
+        uint32_t offset;       // In samples, from the start of the audio file.
+        uint32_t frames;
+    };
+
+    void write_index() const;
+
+    sfz::optional<pn::string>       _audio_path;
+    sfz::optional<pn::string>       _index_path;
+    mutable sfz::optional<pn::file> _audio;
+    mutable pn::string              _fork_name;  // of the fork being run.
+    mutable std::vector<pn::string> _forks;      // the names of the forks with sounds.
+    mutable std::vector<Entry>      _entries;
+    mutable uint64_t                _offset;
+
+    AtlasCommand(const AtlasCommand&) = delete;
+    AtlasCommand& operator=(const AtlasCommand&) = delete;
+};
+
+}  // namespace rezin
+
+#endif  // REZIN_COMMANDS_ATLAS_HPP_
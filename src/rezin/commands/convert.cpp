@@ -32,28 +32,53 @@ void ConvertCommand::run(const ResourceFork& rsrc, const Options& options) const
     pn::data             converted;
 
     if (*_type == "snd ") {
-        Sound snd(data);
-        converted = aiff(snd);
+        Sound snd;
+        if (options.track >= 0) {
+            SoundList list(data);
+            if (static_cast<size_t>(options.track) >= list.tracks.size()) {
+                throw std::runtime_error(
+                        pn::format("no track {0} in 'snd ' resource", options.track).c_str());
+            }
+            snd = list.tracks[options.track];
+        } else {
+            snd = Sound(data);
+        }
+        if (options.sample_rate > 0) {
+            snd = resample(snd, options.sample_rate);
+        }
+        switch (options.audio_format) {
+            case Options::AIFF: write_aiff(pn::file_view{stdout}, snd); break;
+            case Options::WAV: write_wav(pn::file_view{stdout}, snd); break;
+            case Options::RAW: write_pcm(pn::file_view{stdout}, snd); break;
+        }
+        return;
     } else if (*_type == "TEXT") {
+        if (options.decodes_unchanged(data)) {
+            pn::file_view{stdout}.write(data).check();
+            return;
+        }
         pn::string string(options.decode(data));
         converted = string.as_data().copy();
     } else if (*_type == "STR#") {
-        StringList string_list(data, options);
-        pn::value  list           = value(string_list);
-        pn::string decoded_string = pn::dump(list);
-        converted                 = decoded_string.as_data().copy();
+        Emitter emitter(pn::file_view{stdout}, options.format);
+        emit(emitter, StringList(data, options));
+        return;
     } else if (*_type == "cicn") {
         ColorIcon cicn(data);
-        converted = png(cicn);
+        converted = png(cicn, options.max_size);
     } else if (*_type == "clut") {
-        ColorTable clut(data);
-        pn::value  list           = value(clut);
-        pn::string decoded_string = pn::dump(list);
-        converted                 = decoded_string.as_data().copy();
+        Emitter emitter(pn::file_view{stdout}, options.format);
+        emit(emitter, ColorTable(data));
+        return;
     } else if (*_type == "PICT") {
         Picture pict(data);
-        converted = png(pict);
+        converted = png(pict, options.max_size);
     } else {
+        if (std::unique_ptr<Template> tmpl = find_template(rsrc, *_type, options)) {
+            Emitter emitter(pn::file_view{stdout}, options.format);
+            tmpl->emit(emitter, data);
+            return;
+        }
         pn::format(
                 stderr, "warning: printing unknown resource type {0} as raw data.\n",
                 pn::dump(*_type, pn::dump_short));
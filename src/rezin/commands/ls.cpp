@@ -5,6 +5,8 @@
 
 #include <rezin/commands/ls.hpp>
 
+#include <rezin/options.hpp>
+#include <rezin/probe.hpp>
 #include <rezin/resource.hpp>
 #include <sfz/sfz.hpp>
 
@@ -12,6 +14,35 @@ namespace args = sfz::args;
 
 namespace rezin {
 
+namespace {
+
+// Prints a single resource entry.
+//
+// Normally, prints the ID and name of the entry.  With a long listing, also prints the size of the
+// resource data and the metadata found by probing its headers, so the line reads "ID, size,
+// metadata, name".  If the headers can't be probed, the metadata is left empty and a warning is
+// printed, rather than aborting the whole listing.  The data is released once it is probed, so a
+// long listing of a streamed fork holds one resource at a time.
+void print_entry(pn::string_view type, const ResourceEntry& entry, const Options& options) {
+    if (!options.long_listing) {
+        pn::format(stdout, "{0}\t{1}\n", entry.id(), entry.name());
+        return;
+    }
+
+    pn::value info = pn::map{};
+    try {
+        info = value(ResourceInfo(type, entry.data()));
+    } catch (const std::exception& e) {
+        pn::format(stderr, "warning: {0} {1}: {2}\n", type, entry.id(), e.what());
+    }
+    pn::format(
+            stdout, "{0}\t{1}\t{2}\t{3}\n", entry.id(), entry.data().size(),
+            pn::dump(info, pn::dump_short), entry.name());
+    entry.release();
+}
+
+}  // namespace
+
 LsCommand::LsCommand() = default;
 
 bool LsCommand::argument(pn::string_view arg) {
@@ -28,7 +59,11 @@ bool LsCommand::argument(pn::string_view arg) {
 void LsCommand::run(const ResourceFork& rsrc, const Options& options) const {
     if (!_type.has_value()) {
         for (const ResourceType& type : rsrc) {
-            pn::format(stdout, "{0}\n", type.code());
+            if (options.long_listing) {
+                pn::format(stdout, "{0}\t{1}\n", type.code(), type.size());
+            } else {
+                pn::format(stdout, "{0}\n", type.code());
+            }
         }
         return;
     }
@@ -36,13 +71,12 @@ void LsCommand::run(const ResourceFork& rsrc, const Options& options) const {
     const ResourceType& type = rsrc.at(*_type);
     if (!_id.has_value()) {
         for (const ResourceEntry& entry : type) {
-            pn::format(stdout, "{0}\t{1}\n", entry.id(), entry.name());
+            print_entry(type.code(), entry, options);
         }
         return;
     }
 
-    const ResourceEntry& entry = type.at(*_id);
-    pn::format(stdout, "{0}\t{1}\n", entry.id(), entry.name());
+    print_entry(type.code(), type.at(*_id), options);
 }
 
 }  // namespace rezin
@@ -0,0 +1,40 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#include <rezin/crc16.hpp>
+
+#include <array>
+
+namespace rezin {
+
+namespace {
+
+std::array<uint16_t, 256> make_table() {
+    std::array<uint16_t, 256> table;
+    for (int i = 0; i < 256; ++i) {
+        uint16_t crc = i << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? uint16_t((crc << 1) ^ 0x1021) : uint16_t(crc << 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+}  // namespace
+
+void Crc16::add(pn::data_view bytes) {
+    const uint8_t* p = bytes.data();
+    for (int i = 0; i < bytes.size(); ++i) {
+        add(p[i]);
+    }
+}
+
+const uint16_t* Crc16::table() {
+    static const std::array<uint16_t, 256> table = make_table();
+    return table.data();
+}
+
+}  // namespace rezin
@@ -0,0 +1,34 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#ifndef REZIN_CRC16_HPP_
+#define REZIN_CRC16_HPP_
+
+#include <stdint.h>
+#include <sfz/sfz.hpp>
+
+namespace rezin {
+
+// The CRC-16 used by MacBinary and BinHex: the CCITT polynomial (0x1021), with an initial value of
+// 0, and no reflection.  It is computed a byte at a time, from a 256-entry table.
+class Crc16 {
+  public:
+    Crc16() : _table(table()), _value(0) {}
+
+    void add(uint8_t byte) { _value = uint16_t(_value << 8) ^ _table[(_value >> 8) ^ byte]; }
+    void add(pn::data_view bytes);
+
+    uint16_t value() const { return _value; }
+
+  private:
+    static const uint16_t* table();
+
+    const uint16_t* _table;
+    uint16_t        _value;
+};
+
+}  // namespace rezin
+
+#endif  // REZIN_CRC16_HPP_
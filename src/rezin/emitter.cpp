@@ -0,0 +1,182 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#include <rezin/emitter.hpp>
+
+#include <math.h>
+
+namespace rezin {
+
+namespace {
+
+// Keys made of letters, digits, and underscores can be written bare in procyon.
+bool is_bare_key(pn::string_view key) {
+    if (key.size() == 0) {
+        return false;
+    }
+    for (int i = 0; i < key.size(); ++i) {
+        const char ch = key.data()[i];
+        if (!(((ch >= 'a') && (ch <= 'z')) || ((ch >= 'A') && (ch <= 'Z')) ||
+              ((ch >= '0') && (ch <= '9')) || (ch == '_'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+pn::string procyon_key(pn::string_view key) {
+    return is_bare_key(key) ? key.copy() : pn::dump(key.copy(), pn::dump_short);
+}
+
+pn::string json_string(pn::string_view s) {
+    pn::string result = "\"";
+    for (int i = 0; i < s.size(); ++i) {
+        const char ch = s.data()[i];
+        switch (ch) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (uint8_t(ch) < 0x20) {
+                    result += pn::format("\\u{0}", sfz::hex(uint8_t(ch), 4));
+                } else {
+                    result += s.substr(i, 1);
+                }
+        }
+    }
+    result += "\"";
+    return result;
+}
+
+}  // namespace
+
+Emitter::Emitter(pn::file_view out, Options::Format format) : _out(out), _format(format) {}
+
+void Emitter::begin_array() { begin(false, 0, "["); }
+void Emitter::end_array() { end("[", "]"); }
+void Emitter::begin_map(int key_width) { begin(true, key_width, "{"); }
+void Emitter::end_map() { end("{", "}"); }
+
+void Emitter::key(pn::string_view key) {
+    Frame&     frame = _stack.back();
+    const bool top   = (_stack.size() == 1);
+    if (_format == Options::PROCYON) {
+        if (!top && (frame.count > 0)) {
+            write(", ");
+        }
+        write(procyon_key(key));
+        write(":");
+        // Top-level values line up two columns past the widest key, as in pn::dump().
+        for (int i = top ? key_width(key) : frame.key_width + 1; i < frame.key_width + 2; ++i) {
+            write(" ");
+        }
+    } else {
+        if (top) {
+            write((frame.count > 0) ? ",\n  " : "\n  ");
+        } else if (frame.count > 0) {
+            write(", ");
+        }
+        write(json_string(key));
+        write(": ");
+    }
+    ++frame.count;
+}
+
+int Emitter::key_width(pn::string_view key) {
+    const pn::string written = procyon_key(key);
+    int              width   = 0;
+    for (int i = 0; i < written.size(); ++i) {
+        if ((uint8_t(written.data()[i]) & 0xc0) != 0x80) {  // not a UTF-8 continuation byte.
+            ++width;
+        }
+    }
+    return width;
+}
+
+void Emitter::value(int64_t i) {
+    before_value();
+    write(pn::format("{0}", i));
+    after_value();
+}
+
+void Emitter::value(double d) {
+    before_value();
+    if ((_format == Options::JSON) && !isfinite(d)) {
+        write("null");
+    } else {
+        write(pn::dump(pn::value{d}, pn::dump_short));
+    }
+    after_value();
+}
+
+void Emitter::value(pn::string_view s) {
+    before_value();
+    write((_format == Options::PROCYON) ? pn::dump(s.copy(), pn::dump_short) : json_string(s));
+    after_value();
+}
+
+void Emitter::boolean(bool b) {
+    before_value();
+    write(b ? "true" : "false");
+    after_value();
+}
+
+void Emitter::begin(bool is_map, int key_width, pn::string_view open) {
+    before_value();
+    if ((_format == Options::JSON) || !_stack.empty()) {
+        write(open);
+    }
+    _stack.push_back(Frame{is_map, key_width, 0});
+}
+
+void Emitter::end(pn::string_view open, pn::string_view close) {
+    const Frame frame = _stack.back();
+    _stack.pop_back();
+    if (!_stack.empty()) {
+        write(close);
+    } else if (frame.count == 0) {
+        // In procyon, top-level elements end their own lines; an empty collection has none.
+        if (_format == Options::PROCYON) {
+            write(open);
+        }
+        write(close);
+    } else if (_format == Options::JSON) {
+        write("\n");
+        write(close);
+    }
+    after_value();
+}
+
+// Writes whatever separates a value from the one before it.  Within a map, key() has already
+// written the separator.
+void Emitter::before_value() {
+    if (_stack.empty() || _stack.back().is_map) {
+        return;
+    }
+    Frame&     frame = _stack.back();
+    const bool top   = (_stack.size() == 1);
+    if (top && (_format == Options::PROCYON)) {
+        write("*\t");
+    } else if (top) {
+        write((frame.count > 0) ? ",\n  " : "\n  ");
+    } else if (frame.count > 0) {
+        write(", ");
+    }
+    ++frame.count;
+}
+
+// Ends the line after a top-level value, or after each element of a top-level collection in
+// procyon.
+void Emitter::after_value() {
+    if (_stack.empty() || ((_stack.size() == 1) && (_format == Options::PROCYON))) {
+        write("\n");
+    }
+}
+
+void Emitter::write(pn::string_view s) { _out.write(s).check(); }
+
+}  // namespace rezin
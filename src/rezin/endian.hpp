@@ -0,0 +1,94 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#ifndef REZIN_ENDIAN_HPP_
+#define REZIN_ENDIAN_HPP_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sfz/sfz.hpp>
+#include <type_traits>
+
+namespace rezin {
+
+// Integer fields stored in big- or little-endian byte order.
+//
+// These have the size of T but an alignment of 1, so structs built from them (and from arrays of
+// uint8_t, for reserved fields) have no padding, and exactly match the layout of the structures
+// they describe.  Such a struct can overlay the bytes of a resource directly; each field is only
+// converted to host byte order when it is read.
+template <typename T>
+class be {
+    static_assert(std::is_integral<T>::value, "be<T> requires an integral type");
+
+  public:
+    constexpr operator T() const { return static_cast<T>(get(sizeof(T))); }
+
+  private:
+    typedef typename std::make_unsigned<T>::type U;
+    constexpr U get(size_t n) const { return n ? U((get(n - 1) << 8) | _bytes[n - 1]) : U(0); }
+
+    uint8_t _bytes[sizeof(T)];
+};
+
+template <typename T>
+class le {
+    static_assert(std::is_integral<T>::value, "le<T> requires an integral type");
+
+  public:
+    constexpr operator T() const { return static_cast<T>(get(0)); }
+
+  private:
+    typedef typename std::make_unsigned<T>::type U;
+    constexpr U get(size_t i) const {
+        return (i < sizeof(T)) ? U(_bytes[i] | (U(get(i + 1)) << 8)) : U(0);
+    }
+
+    uint8_t _bytes[sizeof(T)];
+};
+
+// Returns the struct T at `offset` bytes into `in`, without copying it.
+//
+// T must be made of be<>, le<>, and uint8_t fields.  The bounds are checked once, for the whole
+// struct; after that, its fields can be read freely.
+//
+// @throws std::runtime_error    If T extends past the end of `in`.
+template <typename T>
+const T& overlay(pn::data_view in, uint64_t offset = 0) {
+    static_assert(alignof(T) == 1, "overlay<T> requires a packed struct");
+    static_assert(std::is_trivially_copyable<T>::value, "overlay<T> requires a plain struct");
+    if ((offset > static_cast<uint64_t>(in.size())) || (sizeof(T) > (in.size() - offset))) {
+        throw std::runtime_error("unexpected end of data");
+    }
+    return *reinterpret_cast<const T*>(in.data() + offset);
+}
+
+// Write little-endian integers, as used by RIFF files and sound atlases.
+inline void write_le16(pn::file_view out, uint16_t value) {
+    uint8_t bytes[2] = {uint8_t(value), uint8_t(value >> 8)};
+    out.write(pn::data_view{bytes, 2}).check();
+}
+
+inline void write_le32(pn::file_view out, uint32_t value) {
+    uint8_t bytes[4] = {uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16),
+                        uint8_t(value >> 24)};
+    out.write(pn::data_view{bytes, 4}).check();
+}
+
+// Reads the struct T from `in` in a single read, rather than field by field.
+//
+// @throws std::runtime_error    If `in` ends before T does.
+template <typename T>
+void read_struct(pn::file_view in, T* out) {
+    static_assert(alignof(T) == 1, "read_struct<T> requires a packed struct");
+    static_assert(std::is_trivially_copyable<T>::value, "read_struct<T> requires a plain struct");
+    if (fread(out, sizeof(T), 1, in.c_obj()) != 1) {
+        throw std::runtime_error("unexpected end of data");
+    }
+}
+
+}  // namespace rezin
+
+#endif  // REZIN_ENDIAN_HPP_
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <rezin/png.hpp>
+#include <rezin/region.hpp>
 
 using std::max;
 using std::min;
@@ -42,6 +43,18 @@ void RasterImage::set(int16_t x, int16_t y, const AlphaColor& color) {
     }
 }
 
+void RasterImage::fill_span(int16_t y, int16_t left, int16_t right, const AlphaColor& color) {
+    if ((y < bounds().top) || (y >= bounds().bottom)) {
+        return;
+    }
+    left  = max(left, bounds().left);
+    right = min(right, bounds().right);
+    if (left >= right) {
+        return;
+    }
+    std::fill(_pixels.begin() + index(left, y), _pixels.begin() + index(right - 1, y) + 1, color);
+}
+
 AlphaColor RasterImage::get(int16_t x, int16_t y) const {
     if (contains(x, y)) {
         return _pixels[index(x, y)];
@@ -66,21 +79,109 @@ void RasterImage::src(const Image& src, const Image& mask) {
     }
 }
 
+void RasterImage::src(const Image& src, const Region& clip) {
+    Rect area = {
+            max(src.bounds().top, bounds().top),
+            max(src.bounds().left, bounds().left),
+            min(src.bounds().bottom, bounds().bottom),
+            min(src.bounds().right, bounds().right),
+    };
+    for (const Region::Band& band : clip.intersect(Region(area)).bands()) {
+        for (int16_t y = band.top; y < band.bottom; ++y) {
+            for (size_t i = 0; i < band.edges.size(); i += 2) {
+                auto out = _pixels.begin() + index(band.edges[i], y);
+                for (int16_t x = band.edges[i]; x < band.edges[i + 1]; ++x) {
+                    *(out++) = src.get(x, y);
+                }
+            }
+        }
+    }
+}
+
+const AlphaColor* RasterImage::row(int16_t y) const {
+    return _pixels.data() + index(bounds().left, y);
+}
+
 size_t RasterImage::index(int16_t x, int16_t y) const {
     x -= bounds().left;
     y -= bounds().top;
     return x + (y * bounds().width());
 }
 
-pn::data png(const RasterImage& image) {
-    pn::data  d;
-    pn::file  f = d.open("w");
-    PngWriter writer(f, image.bounds().width(), image.bounds().height());
-    for (int16_t y = image.bounds().top; y < image.bounds().bottom; ++y) {
-        for (int16_t x = image.bounds().left; x < image.bounds().right; ++x) {
-            const AlphaColor& color = image.get(x, y);
-            writer.append_pixel(color.red, color.green, color.blue, color.alpha);
+PngRowWriter::PngRowWriter(pn::file_view out, int16_t width, int16_t height, int16_t max_size)
+        : _src_width(width),
+          _src_height(height),
+          _width(width),
+          _height(height),
+          _y(0),
+          _out_y(0) {
+    const int16_t longest = max(width, height);
+    if ((max_size > 0) && (longest > max_size)) {
+        _width  = max(1, (width * max_size) / longest);
+        _height = max(1, (height * max_size) / longest);
+
+        _column.resize(_src_width);
+        _column_size.resize(_width, 0);
+        for (int x = 0; x < _src_width; ++x) {
+            _column[x] = (x * _width) / _src_width;
+            ++_column_size[_column[x]];
         }
+        _sums.resize(4 * _width, 0);
+    }
+    _writer.reset(new PngWriter(out, _width, _height));
+}
+
+PngRowWriter::~PngRowWriter() {}
+
+void PngRowWriter::append_row(const AlphaColor* pixels) {
+    if (_sums.empty()) {
+        for (int x = 0; x < _width; ++x) {
+            _writer->append_pixel(pixels[x].red, pixels[x].green, pixels[x].blue, pixels[x].alpha);
+        }
+        return;
+    }
+
+    // Colors are premultiplied by alpha while summing, so that transparent pixels do not bleed
+    // into their neighbors.  All arithmetic is integral.
+    for (int x = 0; x < _src_width; ++x) {
+        const uint32_t a   = pixels[x].alpha;
+        uint64_t*      sum = &_sums[4 * _column[x]];
+        sum[0] += pixels[x].red * a;
+        sum[1] += pixels[x].green * a;
+        sum[2] += pixels[x].blue * a;
+        sum[3] += a;
+    }
+    ++_y;
+
+    // Each destination row is emitted as soon as its last source row has been added.  Since the
+    // image is only ever scaled down, every destination row covers at least one source row.
+    const int row_top = (_out_y * _src_height) / _height;
+    const int row_end = ((_out_y + 1) * _src_height) / _height;
+    if (_y < row_end) {
+        return;
+    }
+    for (int out_x = 0; out_x < _width; ++out_x) {
+        const uint64_t* sum   = &_sums[4 * out_x];
+        const uint64_t  count = uint64_t(row_end - row_top) * _column_size[out_x];
+        const uint64_t  alpha = sum[3];
+        if (alpha == 0) {
+            _writer->append_pixel(0, 0, 0, 0);
+            continue;
+        }
+        _writer->append_pixel(
+                (sum[0] + alpha / 2) / alpha, (sum[1] + alpha / 2) / alpha,
+                (sum[2] + alpha / 2) / alpha, (alpha + count / 2) / count);
+    }
+    std::fill(_sums.begin(), _sums.end(), 0);
+    ++_out_y;
+}
+
+pn::data png(const RasterImage& image, int16_t max_size) {
+    pn::data     d;
+    pn::file     f = d.open("w");
+    PngRowWriter writer(f, image.bounds().width(), image.bounds().height(), max_size);
+    for (int16_t y = image.bounds().top; y < image.bounds().bottom; ++y) {
+        writer.append_row(image.row(y));
     }
     return d;
 }
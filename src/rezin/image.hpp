@@ -6,6 +6,7 @@
 #ifndef REZIN_IMAGE_HPP_
 #define REZIN_IMAGE_HPP_
 
+#include <memory>
 #include <rezin/primitives.hpp>
 #include <sfz/sfz.hpp>
 #include <vector>
@@ -13,6 +14,8 @@
 namespace rezin {
 
 struct PngRasterImage;
+class PngWriter;
+class Region;
 
 struct AlphaColor {
     uint8_t alpha;
@@ -58,17 +61,62 @@ class RasterImage : public Image {
 
     virtual AlphaColor get(int16_t x, int16_t y) const;
 
+    // Returns the pixels of row y, which must be within the bounds of the image.
+    const AlphaColor* row(int16_t y) const;
+
     void set(int16_t x, int16_t y, const AlphaColor& color);
 
+    // Sets the pixels [left, right) of row y to `color`.  Pixels outside of the bounds of the
+    // image are ignored.
+    void fill_span(int16_t y, int16_t left, int16_t right, const AlphaColor& color);
+
     void src(const Image& src, const Image& mask);
 
+    // Copies the pixels of `src` which are inside `clip`.  Rather than testing each pixel against
+    // the clip, the region is walked a span at a time.
+    void src(const Image& src, const Region& clip);
+
   private:
     size_t index(int16_t x, int16_t y) const;
 
     std::vector<AlphaColor> _pixels;
 };
 
-pn::data png(const RasterImage& image);
+// Encodes a `width` x `height` image as a PNG, a row at a time.
+//
+// If `max_size` is nonzero and the image is wider or taller than it, the image is scaled down,
+// preserving its aspect ratio, so that its larger dimension is `max_size`.  Each pixel of the
+// result is the average of the block of source pixels it covers, weighted by alpha.
+//
+// Rows must be appended from top to bottom.  When scaling, they are summed into a single row of
+// accumulators, so neither the source nor the result is ever held in memory whole; readers which
+// can decode an image a row at a time can encode it without building a RasterImage at all.
+class PngRowWriter {
+  public:
+    PngRowWriter(pn::file_view out, int16_t width, int16_t height, int16_t max_size = 0);
+    ~PngRowWriter();
+
+    // Appends a row of `width` pixels.  Must be called exactly `height` times.
+    void append_row(const AlphaColor* pixels);
+
+  private:
+    const int16_t              _src_width;
+    const int16_t              _src_height;
+    int16_t                    _width;
+    int16_t                    _height;
+    std::unique_ptr<PngWriter> _writer;
+    std::vector<int>           _column;
+    std::vector<int>           _column_size;
+    std::vector<uint64_t>      _sums;
+    int                        _y;
+    int                        _out_y;
+
+    PngRowWriter(const PngRowWriter&) = delete;
+    PngRowWriter& operator=(const PngRowWriter&) = delete;
+};
+
+// Encodes `image` as a PNG, scaled down to fit within `max_size` as by PngRowWriter.
+pn::data png(const RasterImage& image, int16_t max_size = 0);
 
 class TranslatedImage : public Image {
   public:
@@ -0,0 +1,100 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#include <rezin/mac-binary.hpp>
+
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <rezin/crc16.hpp>
+#include <rezin/endian.hpp>
+
+namespace rezin {
+
+namespace {
+
+struct MacBinaryHeader {
+    uint8_t      old_version;  // zero.
+    uint8_t      name_length;
+    uint8_t      name[63];
+    uint8_t      type[4];
+    uint8_t      creator[4];
+    uint8_t      finder_flags;
+    uint8_t      zero_1;
+    be<uint16_t> vertical;
+    be<uint16_t> horizontal;
+    be<uint16_t> window_id;
+    uint8_t      protected_flag;
+    uint8_t      zero_2;
+    be<uint32_t> data_length;
+    be<uint32_t> resource_length;
+    be<uint32_t> created;
+    be<uint32_t> modified;
+    be<uint16_t> comment_length;    // II and later.
+    uint8_t      finder_flags_low;  // II and later.
+    uint8_t      signature[4];      // "mBIN" in III.
+    uint8_t      script;            // III.
+    uint8_t      extended_flags;    // III.
+    uint8_t      reserved[8];
+    be<uint32_t> unpacked_length;   // II and later.
+    be<uint16_t> secondary_length;  // II and later.
+    uint8_t      version;           // II and later: 129 for II, 130 for III.
+    uint8_t      minimum_version;   // II and later.
+    be<uint16_t> crc;               // II and later, of the preceding bytes.
+    uint8_t      unused[2];
+};
+static_assert(sizeof(MacBinaryHeader) == MacBinary::kHeaderSize, "bad MacBinary header size");
+
+uint64_t padded(uint64_t size) { return (size + 127) & ~uint64_t(127); }
+
+uint64_t data_offset(const MacBinaryHeader& header) {
+    return sizeof(MacBinaryHeader) + padded(header.secondary_length);
+}
+
+uint64_t resource_offset(const MacBinaryHeader& header) {
+    return data_offset(header) + padded(header.data_length);
+}
+
+}  // namespace
+
+bool MacBinary::has_header(const pn::data_view& data, uint64_t size) {
+    if (data.size() < int(sizeof(MacBinaryHeader))) {
+        return false;
+    }
+    const MacBinaryHeader& header = overlay<MacBinaryHeader>(data);
+    if ((header.old_version != 0) || (header.zero_1 != 0) || (header.zero_2 != 0) ||
+        (header.name_length < 1) || (header.name_length > 63) ||
+        ((resource_offset(header) + header.resource_length) > size)) {
+        return false;
+    }
+
+    // II and III have a CRC, and III also has a signature.  I has neither, but instead has zeroes
+    // in every field after the dates.
+    Crc16 crc;
+    crc.add(data.slice(0, offsetof(MacBinaryHeader, crc)));
+    if (crc.value() == header.crc) {
+        return true;
+    } else if (memcmp(header.signature, "mBIN", 4) == 0) {
+        return true;
+    }
+    const uint8_t* begin = data.data() + offsetof(MacBinaryHeader, comment_length);
+    const uint8_t* end   = data.data() + sizeof(MacBinaryHeader);
+    return std::all_of(begin, end, [](uint8_t byte) { return byte == 0; });
+}
+
+MacBinary::MacBinary(const pn::data_view& data) {
+    if (!has_header(data, data.size())) {
+        throw std::runtime_error("invalid MacBinary header");
+    }
+    const MacBinaryHeader& header = overlay<MacBinaryHeader>(data);
+    _data_fork                    = data.slice(data_offset(header), header.data_length);
+    _resource_fork                = data.slice(resource_offset(header), header.resource_length);
+}
+
+const pn::data_view& MacBinary::data_fork() const { return _data_fork; }
+
+const pn::data_view& MacBinary::resource_fork() const { return _resource_fork; }
+
+}  // namespace rezin
@@ -5,38 +5,173 @@
 
 #include <rezin/options.hpp>
 
+#include <string.h>
+#include <algorithm>
+#include <array>
+
 namespace macroman = sfz::macroman;
 
 namespace rezin {
 
 namespace {
 
-void convert_cr(pn::string* string, const pn::string_view& replacement) {
-    pn::string result;
-    for (pn::rune r : *string) {
-        if (r == pn::rune{'\r'}) {
-            result += replacement;
-        } else {
-            result += pn::rune{r};
+// The UTF-8 encoding of a single MacRoman byte.  Every MacRoman character is in the Basic
+// Multilingual Plane, so no encoding is longer than 3 bytes.
+struct Utf8Sequence {
+    uint8_t size;
+    char    bytes[3];
+};
+
+typedef std::array<Utf8Sequence, 256> DecodeTable;
+
+// Builds the table mapping each MacRoman byte to its UTF-8 encoding, with carriage returns
+// replaced according to `line_ending`.  The encodings come from sfz::macroman::decode(), so the
+// table agrees with it exactly.
+DecodeTable make_decode_table(Options::LineEnding line_ending) {
+    DecodeTable table;
+    for (int i = 0; i < 256; ++i) {
+        uint8_t    byte = i;
+        pn::string utf8 = macroman::decode(pn::data_view{&byte, 1});
+        if (utf8.size() > 3) {
+            throw std::runtime_error("MacRoman character too long");
         }
+        table[i].size = utf8.size();
+        std::copy(utf8.data(), utf8.data() + utf8.size(), table[i].bytes);
+    }
+
+    switch (line_ending) {
+        case Options::CR: table['\r'] = Utf8Sequence{1, {'\r'}}; break;
+        case Options::NL: table['\r'] = Utf8Sequence{1, {'\n'}}; break;
+        case Options::CRNL: table['\r'] = Utf8Sequence{2, {'\r', '\n'}}; break;
+    }
+    return table;
+}
+
+// Returns the decode table for `line_ending`, building it on first use.
+const DecodeTable& decode_table(Options::LineEnding line_ending) {
+    static const DecodeTable tables[] = {
+            make_decode_table(Options::CR), make_decode_table(Options::NL),
+            make_decode_table(Options::CRNL),
+    };
+    return tables[line_ending];
+}
+
+const uint64_t kHighBits = 0x8080808080808080ull;
+const uint64_t kLowBits  = 0x0101010101010101ull;
+
+// Returns true if the 8 bytes at `p` can be copied to the output unchanged: none has its high
+// bit set, and, unless carriage returns are kept, none is a carriage return.
+//
+// The carriage return test is the usual SWAR test for a zero byte, applied to the word XORed
+// with a word of carriage returns.
+bool is_plain_word(const uint8_t* p, bool keep_cr) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    if (word & kHighBits) {
+        return false;
+    } else if (keep_cr) {
+        return true;
+    }
+    uint64_t x = word ^ (kLowBits * '\r');
+    return ((x - kLowBits) & ~x & kHighBits) == 0;
+}
+
+// The single-byte version of is_plain_word().
+bool is_plain_byte(uint8_t byte, bool keep_cr) {
+    return !(byte & 0x80) && (keep_cr || (byte != '\r'));
+}
+
+// Returns the exact size of the UTF-8 decoding of `in`.
+size_t decoded_size(const uint8_t* in, size_t size, const DecodeTable& table, bool keep_cr) {
+    size_t result = 0;
+    size_t i      = 0;
+    for (; (i + 8) <= size; i += 8) {
+        if (is_plain_word(in + i, keep_cr)) {
+            result += 8;
+            continue;
+        }
+        for (size_t j = i; j < (i + 8); ++j) {
+            result += table[in[j]].size;
+        }
+    }
+    for (; i < size; ++i) {
+        result += table[in[i]].size;
+    }
+    return result;
+}
+
+// Decodes `in` into `out`, which must have room for decoded_size() bytes.
+void decode_into(
+        const uint8_t* in, size_t size, const DecodeTable& table, bool keep_cr, char* out) {
+    size_t i = 0;
+    for (; (i + 8) <= size; i += 8) {
+        if (is_plain_word(in + i, keep_cr)) {
+            memcpy(out, in + i, 8);
+            out += 8;
+            continue;
+        }
+        for (size_t j = i; j < (i + 8); ++j) {
+            // Every byte decodes to at least one, so while three bytes of input remain, there is
+            // room in `out` to copy a whole sequence, of which only `seq.size` bytes are kept.
+            const Utf8Sequence& seq = table[in[j]];
+            memcpy(out, seq.bytes, ((size - j) >= 3) ? 3 : seq.size);
+            out += seq.size;
+        }
+    }
+    for (; i < size; ++i) {
+        const Utf8Sequence& seq = table[in[i]];
+        std::copy(seq.bytes, seq.bytes + seq.size, out);
+        out += seq.size;
     }
-    result.swap(*string);
 }
 
 }  // namespace
 
-Options::Options() : line_ending(NL) {}
+Options::Options()
+        : line_ending(NL),
+          long_listing(false),
+          max_size(0),
+          audio_format(AIFF),
+          track(-1),
+          sample_rate(0),
+          format(PROCYON),
+          jobs(1),
+          window(0),
+          max_open(64),
+          max_mapped(1024),
+          stdin_size(0) {}
 
+// Decodes in a single pass over the input (after a pass to size the output), replacing carriage
+// returns as it goes.  The result is allocated once, at its final size, and decoded into in place.
 pn::string Options::decode(const pn::data_view& d) const {
-    pn::string result = macroman::decode(d);
-    switch (line_ending) {
-        case Options::CR: break;
-        case Options::NL: convert_cr(&result, "\n"); break;
-        case Options::CRNL: convert_cr(&result, "\r\n"); break;
-    }
+    const DecodeTable& table   = decode_table(line_ending);
+    const bool         keep_cr = (line_ending == CR);
+    const uint8_t*     in      = d.data();
+    const size_t       size    = decoded_size(in, d.size(), table, keep_cr);
+
+    pn::string result(static_cast<int>(size), pn::rune{0});
+    decode_into(in, d.size(), table, keep_cr, result.data());
     return result;
 }
 
+bool Options::decodes_unchanged(const pn::data_view& d) const {
+    const bool     keep_cr = (line_ending == CR);
+    const uint8_t* in      = d.data();
+    const size_t   size    = d.size();
+    size_t         i       = 0;
+    for (; (i + 8) <= size; i += 8) {
+        if (!is_plain_word(in + i, keep_cr)) {
+            return false;
+        }
+    }
+    for (; i < size; ++i) {
+        if (!is_plain_byte(in[i], keep_cr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /*
 bool store_argument(Options::LineEnding& to, pn::string_view value, PrintTarget error) {
     if (value == "cr") {
@@ -6,9 +6,13 @@
 #include <rezin/pict.hpp>
 
 #include <stdint.h>
+#include <algorithm>
 #include <rezin/clut.hpp>
+#include <rezin/endian.hpp>
 #include <rezin/image.hpp>
 #include <rezin/primitives.hpp>
+#include <rezin/quickdraw.hpp>
+#include <rezin/region.hpp>
 #include <vector>
 
 using sfz::hex;
@@ -18,10 +22,28 @@ using std::vector;
 
 namespace rezin {
 
+namespace {
+
+// An entry in the display list of a picture.
+//
+// Records where the operands of a single opcode are, without interpreting them beyond what is
+// needed to find their size.  `rect` is the rectangle the op draws into or sets, if any: the
+// destination of a bits op, the frame of a shape, or the bounding box of a clip region.
+struct PictureOp {
+    uint16_t code;
+    size_t   offset;
+    size_t   size;
+    Rect     rect;
+};
+
+}  // namespace
+
 struct Picture::Rep {
+    pn::data_view           data;
     Rect                    bounds;
     bool                    is_raster;
     uint8_t                 version;
+    vector<PictureOp>       ops;
     unique_ptr<RasterImage> image;
 };
 
@@ -35,22 +57,39 @@ T round_up_even(T t) {
     return t;
 }
 
-struct PackBitsRectOp {
+// Composites the pixels of a bits op into `canvas`, within its destination rect, the clip region
+// of the picture, and its mask region, if any.
+void draw_bits(
+        RasterImage* canvas, const Region& clip, const RasterImage& image, const Rect& src_rect,
+        const Rect& dst_rect, const Region* mask_rgn) {
+    TranslatedImage src(image, dst_rect.left - src_rect.left, dst_rect.top - src_rect.top);
+    Region          area = clip.intersect(Region(dst_rect));
+    if (mask_rgn) {
+        area = area.intersect(*mask_rgn);
+    }
+    canvas->src(src, area);
+}
+
+// The operands of PackBitsRect and PackBitsRgn ops, which differ only by the mask region.
+struct PackBitsOp {
+    explicit PackBitsOp(bool has_mask_rgn) : has_mask_rgn(has_mask_rgn) {}
+
+    bool                    has_mask_rgn;
     PixMap                  pix_map;
     ColorTable              clut;
     Rect                    src_rect;
     Rect                    dst_rect;
     int16_t                 mode;
+    Region                  mask_rgn;
     unique_ptr<RasterImage> image;
 
-    void draw(Picture::Rep& rep) {
-        RectImage       mask(dst_rect, AlphaColor(0, 0, 0));
-        TranslatedImage src(*image, dst_rect.left - src_rect.left, dst_rect.top - src_rect.top);
-        rep.image->src(src, mask);
+    void draw(RasterImage* canvas, const Region& clip) {
+        draw_bits(canvas, clip, *image, src_rect, dst_rect, has_mask_rgn ? &mask_rgn : nullptr);
     }
 };
 
-void read_from(pn::file_view in, PackBitsRectOp* op) {
+// Reads the operands which precede the pixel data.
+void read_header(pn::file_view in, PackBitsOp* op) {
     read_from(in, &op->pix_map);
     read_from(in, &op->clut);
     read_from(in, &op->src_rect);
@@ -59,24 +98,35 @@ void read_from(pn::file_view in, PackBitsRectOp* op) {
     if (op->mode != 0) {
         throw std::runtime_error("only source compositing is supported");
     }
+    if (op->has_mask_rgn) {
+        read_from(in, &op->mask_rgn);
+    }
+}
+
+void read_from(pn::file_view in, PackBitsOp* op) {
+    read_header(in, op);
     op->image = op->pix_map.read_packed_image(in, op->clut);
 }
 
-struct DirectBitsRectOp {
+// The operands of DirectBitsRect and DirectBitsRgn ops, which differ only by the mask region.
+struct DirectBitsOp {
+    explicit DirectBitsOp(bool has_mask_rgn) : has_mask_rgn(has_mask_rgn) {}
+
+    bool                    has_mask_rgn;
     AddressedPixMap         pix_map;
     Rect                    src_rect;
     Rect                    dst_rect;
     int16_t                 mode;
+    Region                  mask_rgn;
     unique_ptr<RasterImage> image;
 
-    void draw(Picture::Rep& rep) {
-        RectImage       mask(dst_rect, AlphaColor(0, 0, 0));
-        TranslatedImage src(*image, dst_rect.left - src_rect.left, dst_rect.top - src_rect.top);
-        rep.image->src(src, mask);
+    void draw(RasterImage* canvas, const Region& clip) {
+        draw_bits(canvas, clip, *image, src_rect, dst_rect, has_mask_rgn ? &mask_rgn : nullptr);
     }
 };
 
-void read_from(pn::file_view in, DirectBitsRectOp* op) {
+// Reads the operands which precede the pixel data.
+void read_header(pn::file_view in, DirectBitsOp* op) {
     read_from(in, &op->pix_map);
     read_from(in, &op->src_rect);
     read_from(in, &op->dst_rect);
@@ -85,6 +135,13 @@ void read_from(pn::file_view in, DirectBitsRectOp* op) {
     if (op->mode != 0) {
         throw std::runtime_error("only source compositing is supported");
     }
+    if (op->has_mask_rgn) {
+        read_from(in, &op->mask_rgn);
+    }
+}
+
+void read_from(pn::file_view in, DirectBitsOp* op) {
+    read_header(in, op);
     op->image = op->pix_map.read_direct_image(in);
 }
 
@@ -126,240 +183,832 @@ void read_from(pn::file_view in, Header* header) {
 enum {
     NOOP_V2             = 0x0000,
     CLIP_V2             = 0x0001,
+    BG_PATTERN_V2       = 0x0002,
+    TEXT_FONT_V2        = 0x0003,
+    TEXT_FACE_V2        = 0x0004,
     PEN_SIZE_V2         = 0x0007,
+    PEN_MODE_V2         = 0x0008,
+    PEN_PATTERN_V2      = 0x0009,
+    FILL_PATTERN_V2     = 0x000a,
+    OVAL_SIZE_V2        = 0x000b,
+    TEXT_SIZE_V2        = 0x000d,
     FOREGROUND_COLOR_V2 = 0x001a,
     BACKGROUND_COLOR_V2 = 0x001b,
     DEFAULT_HILITE_V2   = 0x001e,
     OP_COLOR_V2         = 0x001f,
+    LINE_V2             = 0x0020,
+    LINE_FROM_V2        = 0x0021,
     SHORT_LINE_V2       = 0x0022,
+    SHORT_LINE_FROM_V2  = 0x0023,
     FRAME_RECT_V2       = 0x0030,
     PAINT_RECT_V2       = 0x0031,
+    ERASE_RECT_V2       = 0x0032,
     FRAME_SAME_RECT_V2  = 0x0038,
     PAINT_SAME_RECT_V2  = 0x0039,
+    ERASE_SAME_RECT_V2  = 0x003a,
+    FRAME_RRECT_V2      = 0x0040,
+    PAINT_RRECT_V2      = 0x0041,
+    ERASE_RRECT_V2      = 0x0042,
+    FRAME_SAME_RRECT_V2 = 0x0048,
+    PAINT_SAME_RRECT_V2 = 0x0049,
+    ERASE_SAME_RRECT_V2 = 0x004a,
     FRAME_OVAL_V2       = 0x0050,
     PAINT_OVAL_V2       = 0x0051,
+    ERASE_OVAL_V2       = 0x0052,
     FRAME_SAME_OVAL_V2  = 0x0058,
     PAINT_SAME_OVAL_V2  = 0x0059,
+    ERASE_SAME_OVAL_V2  = 0x005a,
     FRAME_ARC_V2        = 0x0060,
     PAINT_ARC_V2        = 0x0061,
+    ERASE_ARC_V2        = 0x0062,
     FRAME_SAME_ARC_V2   = 0x0068,
     PAINT_SAME_ARC_V2   = 0x0069,
+    ERASE_SAME_ARC_V2   = 0x006a,
     FRAME_POLY_V2       = 0x0070,
     PAINT_POLY_V2       = 0x0071,
+    ERASE_POLY_V2       = 0x0072,
+    FRAME_RGN_V2        = 0x0080,
+    PAINT_RGN_V2        = 0x0081,
+    ERASE_RGN_V2        = 0x0082,
+    FRAME_SAME_RGN_V2   = 0x0088,
+    PAINT_SAME_RGN_V2   = 0x0089,
+    ERASE_SAME_RGN_V2   = 0x008a,
     PACK_BITS_RECT_V2   = 0x0098,
+    PACK_BITS_RGN_V2    = 0x0099,
     DIRECT_BITS_RECT_V2 = 0x009a,
+    DIRECT_BITS_RGN_V2  = 0x009b,
     SHORT_COMMENT_V2    = 0x00a0,
     LONG_COMMENT_V2     = 0x00a1,
     HEADER_OP_V2        = 0x0c00,
     END_V2              = 0x00ff,
 };
 
-void read_version_2_pict(pn::file_view in, Picture& pict) {
-    uint16_t header_version;
-    in.read(&header_version).check();
+template <typename T>
+T read_at(pn::data_view in, size_t offset) {
+    return overlay<be<T>>(in, offset);
+}
+
+Rect read_rect_at(pn::data_view in, size_t offset) {
+    pn::file f = in.slice(offset, 8).open();
+    Rect     r;
+    read_from(f, &r);
+    return r;
+}
+
+// Returns the size of the packed pixel data following the header of a bits op.
+//
+// Each row is preceded by its packed size, one byte wide if `row_bytes` is at most 250 and two
+// bytes wide otherwise; the rows can be skipped over without unpacking them.  The data is padded
+// to an even number of bytes.
+size_t packed_data_size(pn::data_view in, int16_t row_bytes, int16_t height) {
+    if (row_bytes == 0) {
+        return 0;
+    }
+    size_t size = 0;
+    for (int y = 0; y < height; ++y) {
+        if (row_bytes <= 250) {
+            size += 1 + read_at<uint8_t>(in, size);
+        } else {
+            size += 2 + read_at<uint16_t>(in, size);
+        }
+    }
+    return round_up_even(size);
+}
+
+// Finds the size and rect of the operands of a single version 2 op.
+//
+// @param [in] in       The data following the op code.
+// @param [in] code     The op code.
+// @param [out] op      Receives the size and rect of the operands.
+void scan_version_2_op(pn::data_view in, uint16_t code, PictureOp* op) {
+    op->size = 0;
+    op->rect = Rect{0, 0, 0, 0};
+    switch (code) {
+        case NOOP_V2:
+        case DEFAULT_HILITE_V2:
+        case FRAME_SAME_RECT_V2:
+        case PAINT_SAME_RECT_V2:
+        case ERASE_SAME_RECT_V2:
+        case FRAME_SAME_RRECT_V2:
+        case PAINT_SAME_RRECT_V2:
+        case ERASE_SAME_RRECT_V2:
+        case FRAME_SAME_OVAL_V2:
+        case PAINT_SAME_OVAL_V2:
+        case ERASE_SAME_OVAL_V2:
+        case FRAME_SAME_RGN_V2:
+        case PAINT_SAME_RGN_V2:
+        case ERASE_SAME_RGN_V2: break;
+
+        // TEXT_FACE_V2 holds a single byte, padded to keep the next op aligned.
+        case TEXT_FONT_V2:
+        case TEXT_FACE_V2:
+        case PEN_MODE_V2:
+        case TEXT_SIZE_V2:
+        case SHORT_LINE_FROM_V2: op->size = 2; break;
+
+        case PEN_SIZE_V2:
+        case OVAL_SIZE_V2:
+        case LINE_FROM_V2:
+        case FRAME_SAME_ARC_V2:
+        case PAINT_SAME_ARC_V2:
+        case ERASE_SAME_ARC_V2: op->size = 4; break;
+
+        case FOREGROUND_COLOR_V2:
+        case BACKGROUND_COLOR_V2:
+        case OP_COLOR_V2:
+        case SHORT_LINE_V2: op->size = 6; break;
+
+        case BG_PATTERN_V2:
+        case PEN_PATTERN_V2:
+        case FILL_PATTERN_V2:
+        case LINE_V2: op->size = 8; break;
+
+        case FRAME_RECT_V2:
+        case PAINT_RECT_V2:
+        case ERASE_RECT_V2:
+        case FRAME_RRECT_V2:
+        case PAINT_RRECT_V2:
+        case ERASE_RRECT_V2:
+        case FRAME_OVAL_V2:
+        case PAINT_OVAL_V2:
+        case ERASE_OVAL_V2: {
+            op->size = 8;
+            op->rect = read_rect_at(in, 0);
+            break;
+        }
+
+        case FRAME_ARC_V2:
+        case PAINT_ARC_V2:
+        case ERASE_ARC_V2: {
+            op->size = 12;
+            op->rect = read_rect_at(in, 0);
+            break;
+        }
+
+        case FRAME_POLY_V2:
+        case PAINT_POLY_V2:
+        case ERASE_POLY_V2: {
+            // The size includes itself and the bounding box, so it's at least 10.
+            uint16_t poly_size = read_at<uint16_t>(in, 0);
+            if (poly_size < 10) {
+                throw std::runtime_error(
+                        pn::format("invalid polygon size {0} in 'PICT' resource", poly_size)
+                                .c_str());
+            }
+            op->size = 2 + round_up_even(poly_size - 2);
+            op->rect = read_rect_at(in, 2);
+            break;
+        }
+
+        case CLIP_V2:
+        case FRAME_RGN_V2:
+        case PAINT_RGN_V2:
+        case ERASE_RGN_V2: {
+            // As with polygons, the size includes the size and the bounding box.
+            uint16_t rgn_size = read_at<uint16_t>(in, 0);
+            if (rgn_size < 10) {
+                throw std::runtime_error(
+                        pn::format("invalid region size {0} in 'PICT' resource", rgn_size)
+                                .c_str());
+            }
+            op->size = round_up_even(rgn_size);
+            op->rect = read_rect_at(in, 2);
+            break;
+        }
+
+        case PACK_BITS_RECT_V2:
+        case PACK_BITS_RGN_V2: {
+            // PixMap, ColorTable, source and destination rects, mode, and mask region.
+            int16_t row_bytes  = read_at<int16_t>(in, 0) & 0x3fff;
+            Rect    bounds     = read_rect_at(in, 2);
+            size_t  clut_size  = 8 + 8 * (size_t(read_at<uint16_t>(in, 46 + 6)) + 1);
+            size_t  dst_offset = 46 + clut_size + 8;
+            size_t  header     = dst_offset + 8 + 2;
+            if (code == PACK_BITS_RGN_V2) {
+                header += read_at<uint16_t>(in, header);
+            }
+            op->rect = read_rect_at(in, dst_offset);
+            op->size = header + packed_data_size(in.slice(header), row_bytes, bounds.height());
+            break;
+        }
+
+        case DIRECT_BITS_RECT_V2:
+        case DIRECT_BITS_RGN_V2: {
+            // Base address, PixMap, source and destination rects, mode, and mask region.
+            int16_t row_bytes = read_at<int16_t>(in, 4) & 0x3fff;
+            Rect    bounds    = read_rect_at(in, 6);
+            size_t  header    = 4 + 46 + 8 + 8 + 2;
+            if (code == DIRECT_BITS_RGN_V2) {
+                header += read_at<uint16_t>(in, header);
+            }
+            op->rect = read_rect_at(in, 4 + 46 + 8);
+            op->size = header + packed_data_size(in.slice(header), row_bytes, bounds.height());
+            break;
+        }
+
+        case SHORT_COMMENT_V2: op->size = 2; break;
+
+        case LONG_COMMENT_V2: {
+            uint16_t comment_size = read_at<uint16_t>(in, 2);
+            op->size              = 4 + round_up_even(comment_size);
+            break;
+        }
+
+        default: {
+            throw std::runtime_error(
+                    pn::format("unsupported op ${0} in 'PICT' resource", hex(code, 4)).c_str());
+        }
+    }
+}
+
+// Builds the display list of a version 2 picture, starting at `offset`.
+//
+// @returns             The offset following the END_V2 op.
+size_t scan_version_2_pict(size_t offset, Picture::Rep& rep) {
+    uint16_t header_version = read_at<uint16_t>(rep.data, offset);
     if (header_version != HEADER_OP_V2) {
         throw std::runtime_error("expected header of version 2 'PICT' resource");
     }
-    Header header = {pict.rep->bounds};
-    read_from(in, &header);
-    if (pict.rep->bounds != header.bounds) {
+    Header   header = {rep.bounds};
+    pn::file f      = rep.data.slice(offset + 2, 24).open();
+    read_from(f, &header);
+    if (rep.bounds != header.bounds) {
         throw std::runtime_error("PICT resource must fill bounds");
     }
+    offset += 2 + 24;
 
     while (true) {
-        uint16_t op;
-        in.read(&op).check();
-        switch (op) {
+        PictureOp op;
+        op.code = read_at<uint16_t>(rep.data, offset);
+        offset += 2;
+        if (op.code == END_V2) {
+            return offset;
+        }
+        op.offset = offset;
+        scan_version_2_op(rep.data.slice(offset), op.code, &op);
+        offset += op.size;
+
+        switch (op.code) {
             case NOOP_V2:
-            case DEFAULT_HILITE_V2: {
+            case DEFAULT_HILITE_V2:
+            case SHORT_COMMENT_V2:
+            case LONG_COMMENT_V2: continue;
+
+            case LINE_V2:
+            case LINE_FROM_V2:
+            case SHORT_LINE_V2:
+            case SHORT_LINE_FROM_V2:
+            case FRAME_RECT_V2:
+            case PAINT_RECT_V2:
+            case ERASE_RECT_V2:
+            case FRAME_SAME_RECT_V2:
+            case PAINT_SAME_RECT_V2:
+            case ERASE_SAME_RECT_V2:
+            case FRAME_RRECT_V2:
+            case PAINT_RRECT_V2:
+            case ERASE_RRECT_V2:
+            case FRAME_SAME_RRECT_V2:
+            case PAINT_SAME_RRECT_V2:
+            case ERASE_SAME_RRECT_V2:
+            case FRAME_OVAL_V2:
+            case PAINT_OVAL_V2:
+            case ERASE_OVAL_V2:
+            case FRAME_SAME_OVAL_V2:
+            case PAINT_SAME_OVAL_V2:
+            case ERASE_SAME_OVAL_V2:
+            case FRAME_ARC_V2:
+            case PAINT_ARC_V2:
+            case ERASE_ARC_V2:
+            case FRAME_SAME_ARC_V2:
+            case PAINT_SAME_ARC_V2:
+            case ERASE_SAME_ARC_V2:
+            case FRAME_POLY_V2:
+            case PAINT_POLY_V2:
+            case ERASE_POLY_V2:
+            case FRAME_RGN_V2:
+            case PAINT_RGN_V2:
+            case ERASE_RGN_V2:
+            case FRAME_SAME_RGN_V2:
+            case PAINT_SAME_RGN_V2:
+            case ERASE_SAME_RGN_V2: rep.is_raster = false; break;
+        }
+        rep.ops.push_back(op);
+    }
+}
+
+enum {
+    NOOP_V1        = 0x00,
+    PIC_VERSION_V1 = 0x11,
+};
+
+// Builds the display list of a picture, starting after its frame.
+//
+// Only the structure of the picture is examined; pixel data is skipped over row by row, without
+// unpacking it.
+void scan_version_1_pict(size_t offset, Picture::Rep& rep) {
+    while (offset < static_cast<size_t>(rep.data.size())) {
+        uint8_t op = rep.data[offset++];
+        switch (op) {
+            case NOOP_V1: {
+                break;
+            }
+
+            case PIC_VERSION_V1: {
+                uint8_t version = read_at<uint8_t>(rep.data, offset++);
+                if (version == 0x01) {
+                    rep.version = 1;
+                    return;
+                } else if (version == 0x02) {
+                    rep.version = 2;
+                    if (read_at<uint8_t>(rep.data, offset++) != 0xff) {
+                        throw std::runtime_error("expected end of version 1 'PICT' resource");
+                    }
+                    offset = scan_version_2_pict(offset, rep);
+                } else {
+                    throw std::runtime_error(
+                            "only version 1 and 2 'PICT' resources are supported");
+                }
                 break;
             }
 
+            default: {
+                throw std::runtime_error(
+                        pn::format("unsupported op ${0} in 'PICT' resource", hex(op, 2)).c_str());
+            }
+        }
+    }
+}
+
+// QuickDraw drawing state, as modified by the ops of a picture.
+//
+// "Same" shape ops reuse the rect of the last shape of the same kind, so the last rect of each
+// kind is tracked separately.  Only solid patterns are supported, so each pattern is recorded as
+// the value of its bytes: $FF draws in the foreground color, and $00 in the background color.
+struct DrawState {
+    Region     clip;
+    Point      size;
+    Point      location;
+    Point      oval_size;
+    AlphaColor foreground;
+    AlphaColor background;
+    uint8_t    pen_pattern;
+    uint8_t    bg_pattern;
+    Rect       last_rect;
+    Rect       last_rrect;
+    Rect       last_oval;
+    Rect       last_arc;
+    int16_t    last_arc_start;
+    int16_t    last_arc_extent;
+    Region     last_rgn;
+
+    explicit DrawState(const Rect& bounds)
+            : clip(bounds),
+              size{1, 1},
+              location{0, 0},
+              oval_size{0, 0},
+              foreground(0, 0, 0),
+              background(255, 255, 255),
+              pen_pattern(0xff),
+              bg_pattern(0x00),
+              last_rect{0, 0, 0, 0},
+              last_rrect{0, 0, 0, 0},
+              last_oval{0, 0, 0, 0},
+              last_arc{0, 0, 0, 0},
+              last_arc_start(0),
+              last_arc_extent(0) {}
+};
+
+AlphaColor read_rgb_color(pn::file_view in) {
+    Color color;
+    read_from(in, &color);
+    return AlphaColor(color.red >> 8, color.green >> 8, color.blue >> 8);
+}
+
+// Shape ops come in groups by shape, with the verb in the low bits of the op code: e.g.
+// FRAME_OVAL_V2, PAINT_OVAL_V2, and ERASE_OVAL_V2 are $50, $51, and $52.  The "same" variant of
+// each op has bit 3 set.
+enum ShapeVerb {
+    FRAME = 0,
+    PAINT = 1,
+    ERASE = 2,
+};
+
+// Reads an 8x8 pattern, which must be solid.
+//
+// @returns                      $FF if every pixel is drawn in the foreground color, or $00 if
+//                               every pixel is drawn in the background color.
+// @throws std::runtime_error    If the pattern mixes the two.
+uint8_t read_solid_pattern(pn::file_view in) {
+    uint8_t pattern[8];
+    in.read(pn::data_view{pattern, 8}).check();
+    for (uint8_t byte : pattern) {
+        if (((byte != 0x00) && (byte != 0xff)) || (byte != pattern[0])) {
+            throw std::runtime_error("only solid patterns are supported in 'PICT' resources");
+        }
+    }
+    return pattern[0];
+}
+
+ShapeVerb shape_verb(uint16_t code) { return static_cast<ShapeVerb>(code & 0x0007); }
+
+bool is_same_shape(uint16_t code) { return (code & 0x0008) != 0; }
+
+// Returns a function which fills spans of `canvas` with the color a verb draws with: that of the
+// pen pattern for framing and painting, and that of the background pattern for erasing.  Spans
+// are cut to the clip region.
+SpanFunc verb_fill(RasterImage* canvas, const DrawState& state, ShapeVerb verb) {
+    const Region*    clip    = &state.clip;
+    const uint8_t    pattern = (verb == ERASE) ? state.bg_pattern : state.pen_pattern;
+    const AlphaColor color   = (pattern == 0xff) ? state.foreground : state.background;
+    return [canvas, clip, color](int16_t y, int16_t left, int16_t right) {
+        const vector<int16_t>& edges = clip->row(y);
+        for (size_t i = 0; i < edges.size(); i += 2) {
+            canvas->fill_span(y, std::max(left, edges[i]), std::min(right, edges[i + 1]), color);
+        }
+    };
+}
+
+// Emits the spans of each row of `rgn`.
+void paint_region(const Region& rgn, const SpanFunc& span) {
+    for (const Region::Band& band : rgn.bands()) {
+        for (int16_t y = band.top; y < band.bottom; ++y) {
+            for (size_t i = 0; i < band.edges.size(); i += 2) {
+                span(y, band.edges[i], band.edges[i + 1]);
+            }
+        }
+    }
+}
+
+void draw_line(RasterImage* canvas, DrawState& state, Point from, Point to) {
+    line(from, to, state.size, verb_fill(canvas, state, FRAME));
+    state.location = to;
+}
+
+// Decodes the pixel data of the ops in the display list, and composites them.  Vector ops are
+// rasterized in the same pass.
+//
+// Shapes are drawn with the copy pen mode and solid patterns only; other modes and patterns are
+// rejected rather than drawn wrongly.  Text state is skipped, since text isn't drawn.
+//
+// @returns                      The rendered picture.
+// @throws std::runtime_error    If any op can't be drawn.  Nothing is kept from earlier ops.
+unique_ptr<RasterImage> render(const Picture::Rep& rep) {
+    unique_ptr<RasterImage> image(new RasterImage(rep.bounds));
+    RasterImage*            canvas = image.get();
+    DrawState               state(rep.bounds);
+    for (const PictureOp& op : rep.ops) {
+        pn::file in = rep.data.slice(op.offset, op.size).open();
+        switch (op.code) {
             case PEN_SIZE_V2: {
-                in.read(pn::pad(4)).check();
+                read_from(in, &state.size);
                 break;
             }
 
-            case FOREGROUND_COLOR_V2:
-            case BACKGROUND_COLOR_V2:
-            case OP_COLOR_V2: {
-                in.read(pn::pad(6)).check();
+            case PEN_MODE_V2: {
+                // patCopy, or srcCopy, which has the same effect for solid patterns.
+                uint16_t mode;
+                in.read(&mode).check();
+                if ((mode != 8) && (mode != 0)) {
+                    throw std::runtime_error(
+                            pn::format("unsupported pen mode {0} in 'PICT' resource", mode)
+                                    .c_str());
+                }
                 break;
             }
 
-            case SHORT_LINE_V2: {
-                pict.rep->is_raster = false;
-                in.read(pn::pad(6)).check();
+            case PEN_PATTERN_V2: {
+                state.pen_pattern = read_solid_pattern(in);
                 break;
             }
 
-            case FRAME_RECT_V2:
-            case PAINT_RECT_V2:
-            case FRAME_OVAL_V2:
-            case PAINT_OVAL_V2: {
-                pict.rep->is_raster = false;
-                in.read(pn::pad(8)).check();
+            case BG_PATTERN_V2: {
+                state.bg_pattern = read_solid_pattern(in);
                 break;
             }
 
-            case FRAME_SAME_RECT_V2:
-            case PAINT_SAME_RECT_V2:
-            case FRAME_SAME_OVAL_V2:
-            case PAINT_SAME_OVAL_V2: {
-                pict.rep->is_raster = false;
+            case FILL_PATTERN_V2: {
+                // No fill ops are supported, but an unsupported pattern is still an error, in
+                // case one follows.
+                read_solid_pattern(in);
                 break;
             }
 
-            case FRAME_ARC_V2:
-            case PAINT_ARC_V2: {
-                pict.rep->is_raster = false;
-                in.read(pn::pad(12)).check();
+            case OVAL_SIZE_V2: {
+                read_from(in, &state.oval_size);
                 break;
             }
 
-            case FRAME_SAME_ARC_V2:
-            case PAINT_SAME_ARC_V2: {
-                pict.rep->is_raster = false;
-                in.read(pn::pad(4)).check();
+            case FOREGROUND_COLOR_V2: {
+                state.foreground = read_rgb_color(in);
                 break;
             }
 
-            case FRAME_POLY_V2:
-            case PAINT_POLY_V2: {
-                pict.rep->is_raster = false;
-                uint16_t poly_size;
-                in.read(&poly_size).check();
-                in.read(pn::pad(round_up_even(poly_size - 2))).check();
+            case BACKGROUND_COLOR_V2: {
+                state.background = read_rgb_color(in);
                 break;
             }
 
-            case CLIP_V2: {
-                uint16_t clip_type;
-                in.read(&clip_type).check();
-                if (clip_type != 0x000a) {
-                    throw std::runtime_error("only rectangular clip regions are supported");
+            case LINE_V2: {
+                Point from, to;
+                read_from(in, &from);
+                read_from(in, &to);
+                draw_line(canvas, state, from, to);
+                break;
+            }
+
+            case LINE_FROM_V2: {
+                Point to;
+                read_from(in, &to);
+                draw_line(canvas, state, state.location, to);
+                break;
+            }
+
+            case SHORT_LINE_V2: {
+                Point  from;
+                int8_t dh, dv;
+                read_from(in, &from);
+                in.read(&dh, &dv).check();
+                draw_line(canvas, state, from, Point{int16_t(from.v + dv), int16_t(from.h + dh)});
+                break;
+            }
+
+            case SHORT_LINE_FROM_V2: {
+                Point  from = state.location;
+                int8_t dh, dv;
+                in.read(&dh, &dv).check();
+                draw_line(canvas, state, from, Point{int16_t(from.v + dv), int16_t(from.h + dh)});
+                break;
+            }
+
+            case FRAME_RECT_V2:
+            case PAINT_RECT_V2:
+            case ERASE_RECT_V2:
+            case FRAME_SAME_RECT_V2:
+            case PAINT_SAME_RECT_V2:
+            case ERASE_SAME_RECT_V2: {
+                if (!is_same_shape(op.code)) {
+                    state.last_rect = op.rect;
+                }
+                ShapeVerb verb = shape_verb(op.code);
+                if (verb == FRAME) {
+                    frame_rect(state.last_rect, state.size, verb_fill(canvas, state, verb));
+                } else {
+                    paint_rect(state.last_rect, verb_fill(canvas, state, verb));
                 }
-                Rect r;
-                read_from(in, &r);
-                if (r != pict.rep->bounds) {
-                    throw std::runtime_error("PICT clip must fill bounds");
+                break;
+            }
+
+            case FRAME_RRECT_V2:
+            case PAINT_RRECT_V2:
+            case ERASE_RRECT_V2:
+            case FRAME_SAME_RRECT_V2:
+            case PAINT_SAME_RRECT_V2:
+            case ERASE_SAME_RRECT_V2: {
+                if (!is_same_shape(op.code)) {
+                    state.last_rrect = op.rect;
+                }
+                const Rect&    r    = state.last_rrect;
+                ShapeVerb      verb = shape_verb(op.code);
+                const SpanFunc fill = verb_fill(canvas, state, verb);
+                if (verb == FRAME) {
+                    frame_rrect(r, state.oval_size, state.size, fill);
+                } else {
+                    paint_rrect(r, state.oval_size, fill);
                 }
                 break;
             }
 
-            case PACK_BITS_RECT_V2: {
-                PackBitsRectOp op;
-                read_from(in, &op);
-                op.draw(*pict.rep);
+            case FRAME_OVAL_V2:
+            case PAINT_OVAL_V2:
+            case ERASE_OVAL_V2:
+            case FRAME_SAME_OVAL_V2:
+            case PAINT_SAME_OVAL_V2:
+            case ERASE_SAME_OVAL_V2: {
+                if (!is_same_shape(op.code)) {
+                    state.last_oval = op.rect;
+                }
+                ShapeVerb verb = shape_verb(op.code);
+                if (verb == FRAME) {
+                    frame_oval(state.last_oval, state.size, verb_fill(canvas, state, verb));
+                } else {
+                    paint_oval(state.last_oval, verb_fill(canvas, state, verb));
+                }
                 break;
             }
 
-            case DIRECT_BITS_RECT_V2: {
-                DirectBitsRectOp op;
-                read_from(in, &op);
-                op.draw(*pict.rep);
+            case FRAME_ARC_V2:
+            case PAINT_ARC_V2:
+            case ERASE_ARC_V2:
+            case FRAME_SAME_ARC_V2:
+            case PAINT_SAME_ARC_V2:
+            case ERASE_SAME_ARC_V2: {
+                if (!is_same_shape(op.code)) {
+                    read_from(in, &state.last_arc);
+                }
+                in.read(&state.last_arc_start, &state.last_arc_extent).check();
+                const Rect&    r      = state.last_arc;
+                const int16_t  start  = state.last_arc_start;
+                const int16_t  extent = state.last_arc_extent;
+                ShapeVerb      verb   = shape_verb(op.code);
+                const SpanFunc fill   = verb_fill(canvas, state, verb);
+                if (verb == FRAME) {
+                    frame_arc(r, start, extent, state.size, fill);
+                } else {
+                    paint_arc(r, start, extent, fill);
+                }
                 break;
             }
 
-            case SHORT_COMMENT_V2: {
-                in.read(pn::pad(2)).check();
+            case FRAME_POLY_V2:
+            case PAINT_POLY_V2:
+            case ERASE_POLY_V2: {
+                uint16_t poly_size;
+                in.read(&poly_size, pn::pad(8)).check();
+                vector<Point> points((poly_size - 10) / 4);
+                for (Point& p : points) {
+                    read_from(in, &p);
+                }
+                ShapeVerb verb = shape_verb(op.code);
+                if (verb == FRAME) {
+                    frame_poly(points, state.size, verb_fill(canvas, state, verb));
+                    if (!points.empty()) {
+                        state.location = points.back();
+                    }
+                } else {
+                    paint_poly(points, verb_fill(canvas, state, verb));
+                }
                 break;
             }
 
-            case LONG_COMMENT_V2: {
-                in.read(pn::pad(2)).check();
-                uint16_t comment_size;
-                in.read(&comment_size).check();
-                in.read(pn::pad(round_up_even(comment_size))).check();
+            case FRAME_RGN_V2:
+            case PAINT_RGN_V2:
+            case ERASE_RGN_V2:
+            case FRAME_SAME_RGN_V2:
+            case PAINT_SAME_RGN_V2:
+            case ERASE_SAME_RGN_V2: {
+                if (!is_same_shape(op.code)) {
+                    read_from(in, &state.last_rgn);
+                }
+                ShapeVerb verb = shape_verb(op.code);
+                paint_region(
+                        (verb == FRAME) ? state.last_rgn.frame(state.size) : state.last_rgn,
+                        verb_fill(canvas, state, verb));
                 break;
             }
 
-            case END_V2: {
-                goto end_pict_v2;
+            case CLIP_V2: {
+                read_from(in, &state.clip);
+                break;
             }
 
-            default: {
-                throw std::runtime_error(
-                        pn::format("unsupported op ${0} in 'PICT' resource", hex(op, 4)).c_str());
+            case PACK_BITS_RECT_V2:
+            case PACK_BITS_RGN_V2: {
+                PackBitsOp bits(op.code == PACK_BITS_RGN_V2);
+                read_from(in, &bits);
+                bits.draw(canvas, state.clip);
+                break;
+            }
+
+            case DIRECT_BITS_RECT_V2:
+            case DIRECT_BITS_RGN_V2: {
+                DirectBitsOp bits(op.code == DIRECT_BITS_RGN_V2);
+                read_from(in, &bits);
+                bits.draw(canvas, state.clip);
+                break;
             }
         }
     }
-end_pict_v2:;
+    return image;
 }
 
-enum {
-    NOOP_V1        = 0x00,
-    PIC_VERSION_V1 = 0x11,
-};
-
-void read_version_1_pict(pn::file_view in, Picture& pict) {
-    while (true) {
-        uint8_t op;
-        if (in.read(&op).eof()) {
-            break;
+// Returns true if `region` includes every pixel of `rect`.
+bool covers(const Region& region, const Rect& rect) {
+    int16_t y = rect.top;
+    for (const Region::Band& band : region.intersect(Region(rect)).bands()) {
+        if ((band.top != y) || (band.edges.size() != 2) || (band.edges[0] != rect.left) ||
+            (band.edges[1] != rect.right)) {
+            return false;
         }
-        in.check();
-        switch (op) {
-            case NOOP_V1: {
+        y = band.bottom;
+    }
+    return y == rect.bottom;
+}
+
+// Returns true if a bits op copies every pixel of its pixel map to the whole of `bounds`.
+bool fills(const PixMap& pix_map, const Rect& src_rect, const Rect& dst_rect, const Rect& bounds) {
+    return (src_rect == pix_map.bounds) && (dst_rect == bounds) &&
+           (src_rect.width() == dst_rect.width()) && (src_rect.height() == dst_rect.height());
+}
+
+// Encodes a picture which consists of a single bits op covering its frame, without rendering it.
+//
+// Nothing else in such a picture can draw over the pixels of the op, so its rows are passed to a
+// PngRowWriter as they are unpacked, and when scaling, no more than one row of the picture is
+// ever held in memory.  Pictures which set a pattern or pen mode are left to render(), which
+// rejects the ones it can't draw.
+//
+// @returns                      True if the picture was encoded into `out`; false if it has to
+//                               be rendered instead.
+// @throws std::runtime_error    If the pixel data of the op is malformed.
+bool stream_png(const Picture::Rep& rep, int16_t max_size, pn::data* out) {
+    if (!rep.is_raster) {
+        return false;
+    }
+    const PictureOp* bits = nullptr;
+    Region           clip(rep.bounds);
+    for (const PictureOp& op : rep.ops) {
+        switch (op.code) {
+            case CLIP_V2: {
+                if (!bits) {
+                    pn::file in = rep.data.slice(op.offset, op.size).open();
+                    read_from(in, &clip);
+                }
                 break;
             }
 
-            case PIC_VERSION_V1: {
-                uint8_t version;
-                in.read(&version).check();
-                if (version == 0x01) {
-                    pict.rep->version = 1;
-                    return;
-                } else if (version == 0x02) {
-                    pict.rep->version = 2;
-                    in.read(&op).check();
-                    if (op != 0xff) {
-                        throw std::runtime_error("expected end of version 1 'PICT' resource");
-                    }
-                    read_version_2_pict(in, pict);
-                } else {
-                    throw std::runtime_error(
-                            "only version 1 and 2 'PICT' resources are supported");
+            case PACK_BITS_RECT_V2:
+            case DIRECT_BITS_RECT_V2: {
+                if (bits) {
+                    return false;
                 }
+                bits = &op;
                 break;
             }
 
-            default: {
-                throw std::runtime_error(
-                        pn::format("unsupported op ${0} in 'PICT' resource", hex(op, 2)).c_str());
-            }
+            case PACK_BITS_RGN_V2:
+            case DIRECT_BITS_RGN_V2:
+            case PEN_MODE_V2:
+            case PEN_PATTERN_V2:
+            case BG_PATTERN_V2:
+            case FILL_PATTERN_V2: return false;
         }
     }
+    if (!bits || !covers(clip, rep.bounds)) {
+        return false;
+    }
+
+    pn::file      in     = rep.data.slice(bits->offset, bits->size).open();
+    pn::file      f      = out->open("w");
+    const int16_t width  = rep.bounds.width();
+    const int16_t height = rep.bounds.height();
+    if (bits->code == PACK_BITS_RECT_V2) {
+        PackBitsOp op(false);
+        read_header(in, &op);
+        if (!fills(op.pix_map, op.src_rect, op.dst_rect, rep.bounds)) {
+            return false;
+        }
+        PngRowWriter writer(f, width, height, max_size);
+        op.pix_map.read_packed_rows(
+                in, op.clut, [&writer](const AlphaColor* row) { writer.append_row(row); });
+    } else {
+        DirectBitsOp op(false);
+        read_header(in, &op);
+        if (!fills(op.pix_map, op.src_rect, op.dst_rect, rep.bounds)) {
+            return false;
+        }
+        PngRowWriter writer(f, width, height, max_size);
+        op.pix_map.read_direct_rows(
+                in, [&writer](const AlphaColor* row) { writer.append_row(row); });
+    }
+    return true;
 }
 
 }  // namespace
 
 Picture::Picture(pn::data_view in) : rep(new Rep) {
-    pn::file f     = in.open();
+    rep->data      = in;
     rep->version   = 0;
     rep->is_raster = true;
+    pn::file f     = in.open();
     f.read(pn::pad(2)).check();
     read_from(f, &rep->bounds);
-    rep->image.reset(new RasterImage(rep->bounds));
 
-    read_version_1_pict(f, *this);
+    scan_version_1_pict(10, *rep);
 }
 
 bool Picture::is_raster() const { return rep->is_raster; }
 
 uint8_t Picture::version() const { return rep->version; }
 
+int16_t Picture::width() const { return rep->bounds.width(); }
+
+int16_t Picture::height() const { return rep->bounds.height(); }
+
 Picture::~Picture() {}
 
-pn::data png(const Picture& pict) {
+pn::data png(const Picture& pict, int16_t max_size) {
     if (pict.version() != 2) {
         throw std::runtime_error("can only create png of version 2 'PICT' resource");
     }
-    if (!pict.is_raster()) {
-        throw std::runtime_error("cannot create png of vector 'PICT' resource");
+    Picture::Rep& rep = *pict.rep;
+    pn::data      d;
+    if (!rep.image && stream_png(rep, max_size, &d)) {
+        return d;
+    }
+    if (!rep.image) {
+        rep.image = render(rep);
     }
-    const Picture::Rep& rep = *pict.rep;
-    return png(*rep.image);
+    return png(*rep.image, max_size);
 }
 
 }  // namespace rezin
@@ -7,12 +7,50 @@
 
 #include <rezin/bits-slice.hpp>
 #include <rezin/clut.hpp>
+#include <rezin/endian.hpp>
 #include <rezin/image.hpp>
 #include <sfz/sfz.hpp>
 #include <vector>
 
 namespace rezin {
 
+namespace {
+
+// The layouts of QuickDraw structures, for reading each with a single read.
+struct RectRecord {
+    be<int16_t> top;
+    be<int16_t> left;
+    be<int16_t> bottom;
+    be<int16_t> right;
+
+    Rect rect() const { return Rect{top, left, bottom, right}; }
+};
+
+struct PixMapRecord {
+    be<int16_t>  row_bytes;
+    RectRecord   bounds;
+    be<int16_t>  pm_version;
+    be<int16_t>  pack_type;
+    be<int32_t>  pack_size;
+    be<int32_t>  h_res;
+    be<int32_t>  v_res;
+    be<int16_t>  pixel_type;
+    be<int16_t>  pixel_size;
+    be<int16_t>  cmp_count;
+    be<int16_t>  cmp_size;
+    be<int32_t>  plane_bytes;
+    be<uint32_t> pm_table;
+    be<int32_t>  pm_reserved;
+};
+
+struct BitMapRecord {
+    be<uint32_t> base_addr;
+    be<uint16_t> row_bytes;
+    RectRecord   bounds;
+};
+
+}  // namespace
+
 int16_t Rect::width() const { return right - left; }
 
 int16_t Rect::height() const { return bottom - top; }
@@ -31,9 +69,13 @@ bool operator==(const Rect& x, const Rect& y) {
 bool operator!=(const Rect& x, const Rect& y) { return !(x == y); }
 
 void read_from(pn::file_view in, Rect* out) {
-    in.read(&out->top, &out->left, &out->bottom, &out->right).check();
+    RectRecord record;
+    read_struct(in, &record);
+    *out = record.rect();
 }
 
+void read_from(pn::file_view in, Point* out) { in.read(&out->v, &out->h).check(); }
+
 double fixed32_t::to_double() const { return int_value / 65536.0; }
 
 pn::value fixed32_t::to_value() const { return to_double(); }
@@ -92,16 +134,41 @@ std::unique_ptr<RasterImage> PixMap::read_image(pn::file_view in, const ColorTab
     return image;
 }
 
+namespace {
+
+// Collects the rows of an image read a row at a time.
+std::unique_ptr<RasterImage> read_rows(
+        const Rect& bounds, const std::function<void(const RowFunc&)>& read) {
+    std::unique_ptr<RasterImage> image(new RasterImage(bounds));
+    int16_t                      y = bounds.top;
+    read([&image, &y, &bounds](const AlphaColor* row) {
+        for (int16_t x = 0; x < bounds.width(); ++x) {
+            image->set(x + bounds.left, y, row[x]);
+        }
+        ++y;
+    });
+    return image;
+}
+
+}  // namespace
+
 std::unique_ptr<RasterImage> PixMap::read_direct_image(pn::file_view in) const {
+    return read_rows(bounds, [this, in](const RowFunc& row) { read_direct_rows(in, row); });
+}
+
+void PixMap::read_direct_rows(pn::file_view in, const RowFunc& row) const {
     if (pixel_type != RGB_DIRECT) {
         throw std::runtime_error("image is not direct");
     }
     if (pack_type != 4) {
         throw std::runtime_error(pn::format("unsupported pack_type {0}", pack_type).c_str());
     }
-    std::unique_ptr<RasterImage> image(new RasterImage(bounds));
+    std::vector<AlphaColor> pixels(bounds.width());
     if (row_bytes == 0) {
-        return image;
+        for (int y = 0; y < bounds.height(); ++y) {
+            row(pixels.data());
+        }
+        return;
     }
     size_t bytes_read = 0;
     for (int y = 0; y < bounds.height(); ++y) {
@@ -146,23 +213,31 @@ std::unique_ptr<RasterImage> PixMap::read_direct_image(pn::file_view in) const {
         const pn::data_view green = components.slice((cmp_count - 2) * w, w);
         const pn::data_view blue  = components.slice((cmp_count - 1) * w);
         for (int x = 0; x < w; ++x) {
-            image->set(x, y, AlphaColor(red[x], green[x], blue[x]));
+            pixels[x] = AlphaColor(red[x], green[x], blue[x]);
         }
+        row(pixels.data());
     }
     if ((bytes_read % 2) != 0) {
         in.read(pn::pad(1)).check();
     }
-    return image;
 }
 
 std::unique_ptr<RasterImage> PixMap::read_packed_image(
         pn::file_view in, const ColorTable& clut) const {
+    return read_rows(
+            bounds, [this, in, &clut](const RowFunc& row) { read_packed_rows(in, clut, row); });
+}
+
+void PixMap::read_packed_rows(pn::file_view in, const ColorTable& clut, const RowFunc& row) const {
     if (pixel_type != INDEXED) {
         throw std::runtime_error("image is not indexed");
     }
-    std::unique_ptr<RasterImage> image(new RasterImage(bounds));
+    std::vector<AlphaColor> pixels(bounds.width());
     if (row_bytes == 0) {
-        return image;
+        for (int y = 0; y < bounds.height(); ++y) {
+            row(pixels.data());
+        }
+        return;
     }
     size_t bytes_read = 0;
     for (int y = 0; y < bounds.height(); ++y) {
@@ -181,6 +256,8 @@ std::unique_ptr<RasterImage> PixMap::read_packed_image(
         in.read(&d).check();
         bytes_read += d.size();
 
+        // Pixels which the row doesn't reach are left clear.
+        std::fill(pixels.begin(), pixels.end(), AlphaColor());
         int32_t  x         = 0;
         pn::file remainder = d.open();
         while (true) {
@@ -195,7 +272,7 @@ std::unique_ptr<RasterImage> PixMap::read_packed_image(
                 uint8_t size = 0x101 - header;
                 for (int j = 0; j < size; ++j) {
                     if (x < bounds.width()) {
-                        image->set(x + bounds.left, y + bounds.top, lookup(clut, value));
+                        pixels[x] = lookup(clut, value);
                     }
                     ++x;
                 }
@@ -205,29 +282,36 @@ std::unique_ptr<RasterImage> PixMap::read_packed_image(
                     if (x < bounds.width()) {
                         uint8_t value;
                         remainder.read(&value);
-                        image->set(x + bounds.left, y + bounds.top, lookup(clut, value));
+                        pixels[x] = lookup(clut, value);
                     }
                     ++x;
                 }
             }
         }
+        row(pixels.data());
     }
     if ((bytes_read % 2 == 1)) {
         in.read(pn::pad(1)).check();
     }
-    return image;
 }
 
 void read_from(pn::file_view in, PixMap* out) {
-    in.read(&out->row_bytes).check();
-    out->row_bytes &= 0x3fff;
-    read_from(in, &out->bounds);
-    in.read(&out->pm_version, &out->pack_type, &out->pack_size).check();
-    read_from(in, &out->h_res);
-    read_from(in, &out->v_res);
-    in.read(&out->pixel_type, &out->pixel_size, &out->cmp_count, &out->cmp_size, &out->plane_bytes,
-            &out->pm_table, &out->pm_reserved)
-            .check();
+    PixMapRecord record;
+    read_struct(in, &record);
+    out->row_bytes       = record.row_bytes & 0x3fff;
+    out->bounds          = record.bounds.rect();
+    out->pm_version      = record.pm_version;
+    out->pack_type       = record.pack_type;
+    out->pack_size       = record.pack_size;
+    out->h_res.int_value = record.h_res;
+    out->v_res.int_value = record.v_res;
+    out->pixel_type      = record.pixel_type;
+    out->pixel_size      = record.pixel_size;
+    out->cmp_count       = record.cmp_count;
+    out->cmp_size        = record.cmp_size;
+    out->plane_bytes     = record.plane_bytes;
+    out->pm_table        = record.pm_table;
+    out->pm_reserved     = record.pm_reserved;
 
     if (out->pm_reserved != 0) {
         throw std::runtime_error("PixMap::pm_reserved must be 0");
@@ -290,7 +374,9 @@ void read_from(pn::file_view in, PixMap* out) {
 }
 
 void read_from(pn::file_view in, AddressedPixMap* out) {
-    in.read(&out->base_addr).check();
+    be<uint32_t> base_addr;
+    read_struct(in, &base_addr);
+    out->base_addr = base_addr;
     PixMap* parent = out;
     read_from(in, parent);
 }
@@ -318,8 +404,11 @@ std::unique_ptr<RasterImage> BitMap::read_image(
 }
 
 void read_from(pn::file_view in, BitMap* out) {
-    in.read(&out->base_addr, &out->row_bytes).check();
-    read_from(in, &out->bounds);
+    BitMapRecord record;
+    read_struct(in, &record);
+    out->base_addr = record.base_addr;
+    out->row_bytes = record.row_bytes;
+    out->bounds    = record.bounds.rect();
 
     if (out->base_addr != 0) {
         throw std::runtime_error("PixMap::base_addr must be 0");
@@ -7,6 +7,7 @@
 #define REZIN_PRIMITIVES_HPP_
 
 #include <stdint.h>
+#include <functional>
 #include <sfz/sfz.hpp>
 
 namespace rezin {
@@ -15,6 +16,9 @@ struct AlphaColor;
 class RasterImage;
 struct ColorTable;
 
+// Receives one row of pixels of an image being decoded.
+typedef std::function<void(const AlphaColor* row)> RowFunc;
+
 struct Rect {
     int16_t top;
     int16_t left;
@@ -31,6 +35,12 @@ bool operator==(const Rect& x, const Rect& y);
 bool operator!=(const Rect& x, const Rect& y);
 void read_from(pn::file_view in, Rect* out);
 
+struct Point {
+    int16_t v;
+    int16_t h;
+};
+void read_from(pn::file_view in, Point* out);
+
 struct fixed32_t {
     int32_t int_value;
 
@@ -58,6 +68,11 @@ struct PixMap {
     std::unique_ptr<RasterImage> read_image(pn::file_view in, const ColorTable& clut) const;
     std::unique_ptr<RasterImage> read_packed_image(pn::file_view in, const ColorTable& clut) const;
     std::unique_ptr<RasterImage> read_direct_image(pn::file_view in) const;
+
+    // Like read_packed_image() and read_direct_image(), but passes each row of `bounds.width()`
+    // pixels to `row` as soon as it is unpacked, from top to bottom, instead of keeping them.
+    void read_packed_rows(pn::file_view in, const ColorTable& clut, const RowFunc& row) const;
+    void read_direct_rows(pn::file_view in, const RowFunc& row) const;
 };
 void read_from(pn::file_view in, PixMap* out);
 
@@ -0,0 +1,194 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#include <rezin/probe.hpp>
+
+#include <rezin/primitives.hpp>
+#include <sfz/sfz.hpp>
+
+using sfz::range;
+
+namespace rezin {
+
+namespace {
+
+// Reads the frame and version of a 'PICT' resource.
+//
+// The frame follows the 2-byte size field.  After it comes the version opcode: a version 1
+// picture starts with the byte pair $11 $01, while a version 2 picture starts with the word pair
+// $0011 $02FF (which a version 1 parser sees as a no-op followed by $11 $02).
+void probe_pict(pn::data_view in, ResourceInfo* info) {
+    pn::file f = in.open();
+    Rect     frame;
+    f.read(pn::pad(2)).check();
+    read_from(f, &frame);
+    info->width.emplace(frame.width());
+    info->height.emplace(frame.height());
+
+    while (true) {
+        uint8_t op;
+        f.read(&op).check();
+        if (op == 0x00) {
+            continue;
+        } else if (op != 0x11) {
+            throw std::runtime_error("expected version op in 'PICT' resource");
+        }
+        uint8_t version;
+        f.read(&version).check();
+        if ((version != 1) && (version != 2)) {
+            throw std::runtime_error("only version 1 and 2 'PICT' resources are supported");
+        }
+        info->version.emplace(version);
+        return;
+    }
+}
+
+// Reads the PixMap header at the start of a 'cicn' resource.
+void probe_cicn(pn::data_view in, ResourceInfo* info) {
+    pn::file        f = in.open();
+    AddressedPixMap pix_map;
+    read_from(f, &pix_map);
+    info->width.emplace(pix_map.bounds.width());
+    info->height.emplace(pix_map.bounds.height());
+    info->depth.emplace(pix_map.pixel_size);
+    info->pixel_type.emplace(pix_map.pixel_type);
+}
+
+// Reads the sound header referenced by the first sampled-sound command of a 'snd ' resource.
+//
+// The format 1 or 2 header and the command list are skipped without interpretation, except to
+// find a bufferCmd or soundCmd with an offset into the resource.  The sound header it points to
+// starts with the same 22 bytes in standard, extended, and compressed variants; the `encode` byte
+// at offset 20 says which variant it is.
+void probe_snd(pn::data_view in, ResourceInfo* info) {
+    pn::file f = in.open();
+    uint16_t fmt;
+    f.read(&fmt).check();
+    if (fmt == 1) {
+        uint16_t synthesizer_count;
+        f.read(&synthesizer_count).check();
+        f.read(pn::pad(6 * synthesizer_count)).check();
+    } else if (fmt == 2) {
+        f.read(pn::pad(2)).check();
+    } else {
+        throw std::runtime_error(pn::format("unknown 'snd ' format '{0}'", fmt).c_str());
+    }
+
+    uint16_t command_count;
+    f.read(&command_count).check();
+    for (uint16_t i : range(command_count)) {
+        static_cast<void>(i);
+        uint16_t command;
+        uint32_t offset;
+        f.read(&command, pn::pad(2), &offset).check();
+        if ((command != 0x8050) && (command != 0x8051)) {
+            continue;
+        }
+
+        pn::file header = in.slice(offset).open();
+        uint32_t length;
+        uint32_t fixed_sample_rate;
+        uint8_t  encoding;
+        header.read(pn::pad(4), &length, &fixed_sample_rate, pn::pad(8), &encoding, pn::pad(1))
+                .check();
+        info->sample_rate.emplace(fixed_sample_rate / 65536.0);
+
+        if (encoding == 0x00) {
+            info->channels.emplace(1);
+            info->sample_bits.emplace(8);
+            info->samples.emplace(length);
+        } else if (encoding == 0xff) {
+            uint32_t frame_count;
+            uint16_t sample_size;
+            header.read(&frame_count, pn::pad(22), &sample_size).check();
+            info->channels.emplace(length);
+            info->sample_bits.emplace(sample_size);
+            info->samples.emplace(frame_count);
+        } else if (encoding == 0xfe) {
+            // Only IMA4 has a fixed number of samples per packet.
+            uint32_t packet_count;
+            uint32_t format;
+            uint16_t sample_size;
+            header.read(&packet_count, pn::pad(14), &format, pn::pad(18), &sample_size).check();
+            info->channels.emplace(length);
+            info->sample_bits.emplace(sample_size);
+            if (format == 0x696d6134) {  // 'ima4'
+                info->samples.emplace(packet_count * 64);
+            }
+        } else {
+            throw std::runtime_error(
+                    pn::format("unknown 'snd ' encoding {0}", encoding).c_str());
+        }
+        return;
+    }
+}
+
+void probe_strl(pn::data_view in, ResourceInfo* info) {
+    uint16_t count;
+    in.open().read(&count).check();
+    info->strings.emplace(count);
+}
+
+void probe_clut(pn::data_view in, ResourceInfo* info) {
+    uint16_t size;
+    in.open().read(pn::pad(6), &size).check();
+    info->colors.emplace(uint32_t(size) + 1);
+}
+
+}  // namespace
+
+ResourceInfo::ResourceInfo(pn::string_view type, pn::data_view in) {
+    if (type == "PICT") {
+        probe_pict(in, this);
+    } else if (type == "cicn") {
+        probe_cicn(in, this);
+    } else if (type == "snd ") {
+        probe_snd(in, this);
+    } else if (type == "STR#") {
+        probe_strl(in, this);
+    } else if (type == "clut") {
+        probe_clut(in, this);
+    }
+}
+
+pn::value value(const ResourceInfo& info) {
+    pn::map m;
+    if (info.width.has_value()) {
+        m["width"] = *info.width;
+    }
+    if (info.height.has_value()) {
+        m["height"] = *info.height;
+    }
+    if (info.depth.has_value()) {
+        m["depth"] = *info.depth;
+    }
+    if (info.pixel_type.has_value()) {
+        m["pixel_type"] = *info.pixel_type;
+    }
+    if (info.version.has_value()) {
+        m["version"] = int(*info.version);
+    }
+    if (info.channels.has_value()) {
+        m["channels"] = int64_t(*info.channels);
+    }
+    if (info.sample_bits.has_value()) {
+        m["sample_bits"] = int64_t(*info.sample_bits);
+    }
+    if (info.sample_rate.has_value()) {
+        m["sample_rate"] = *info.sample_rate;
+    }
+    if (info.samples.has_value()) {
+        m["samples"] = int64_t(*info.samples);
+    }
+    if (info.strings.has_value()) {
+        m["strings"] = int64_t(*info.strings);
+    }
+    if (info.colors.has_value()) {
+        m["colors"] = int64_t(*info.colors);
+    }
+    return std::move(m);
+}
+
+}  // namespace rezin
@@ -0,0 +1,374 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#include <rezin/quickdraw.hpp>
+
+#include <limits.h>
+#include <math.h>
+#include <algorithm>
+#include <utility>
+
+using std::max;
+using std::min;
+using std::pair;
+using std::vector;
+
+namespace rezin {
+
+namespace {
+
+// Returns the index of the first pixel whose center is at or right of `x`.
+int16_t pixel_edge(double x) { return static_cast<int16_t>(ceil(x - 0.5)); }
+
+Rect inset(const Rect& r, Point pen) {
+    return Rect{int16_t(r.top + pen.v), int16_t(r.left + pen.h), int16_t(r.bottom - pen.v),
+                int16_t(r.right - pen.h)};
+}
+
+bool is_empty(const Rect& r) { return (r.width() <= 0) || (r.height() <= 0); }
+
+// Finds the span of row `y` covered by the oval inscribed in `r`.
+//
+// @returns             false if the oval does not cover any pixels on row `y`.
+bool oval_span(const Rect& r, int16_t y, int16_t* left, int16_t* right) {
+    if (is_empty(r)) {
+        return false;
+    }
+    const double a  = r.width() / 2.0;
+    const double b  = r.height() / 2.0;
+    const double dy = (y + 0.5 - r.top - b) / b;
+    if ((dy * dy) >= 1.0) {
+        return false;
+    }
+    const double dx = a * sqrt(1.0 - (dy * dy));
+    *left           = pixel_edge(r.left + a - dx);
+    *right          = pixel_edge(r.left + a + dx);
+    return *left < *right;
+}
+
+// Finds the span of row `y` covered by the rect `r` with its corners rounded by the quarters of
+// an oval of size `oval`.
+//
+// On rows within half the oval's height of the top or bottom of `r`, the left end of the span is
+// that of the oval placed in the corner, and the right end mirrors it.  Other rows span all of
+// `r`.
+//
+// @returns             false if the rounded rect does not cover any pixels on row `y`.
+bool rrect_span(const Rect& r, Point oval, int16_t y, int16_t* left, int16_t* right) {
+    if (is_empty(r) || (y < r.top) || (y >= r.bottom)) {
+        return false;
+    }
+    const int16_t width  = max<int16_t>(0, min(oval.h, r.width()));
+    const int16_t height = max<int16_t>(0, min(oval.v, r.height()));
+    const double  center = y + 0.5;
+    Rect          corner = {r.top, r.left, int16_t(r.top + height), int16_t(r.left + width)};
+    if (center > (r.bottom - height / 2.0)) {
+        corner.top    = r.bottom - height;
+        corner.bottom = r.bottom;
+    } else if (center >= (r.top + height / 2.0)) {
+        *left  = r.left;
+        *right = r.right;
+        return true;
+    }
+    int16_t corner_right;
+    if (!oval_span(corner, y, left, &corner_right)) {
+        return false;
+    }
+    *right = r.right - (*left - r.left);
+    return *left < *right;
+}
+
+// Emits the part of row `y` covered by a frame: the span of the outer shape, if `outer`, minus the
+// span of the inner one, if `inner`.
+void ring(
+        int16_t y, bool outer, int16_t outer_left, int16_t outer_right, bool inner,
+        int16_t inner_left, int16_t inner_right, const SpanFunc& span) {
+    if (!outer) {
+        return;
+    } else if (!inner) {
+        span(y, outer_left, outer_right);
+        return;
+    }
+    if (outer_left < inner_left) {
+        span(y, outer_left, inner_left);
+    }
+    if (inner_right < outer_right) {
+        span(y, inner_right, outer_right);
+    }
+}
+
+// Emits the part of row `y` covered by the frame of the oval inscribed in `r`: the span of the
+// outer oval, minus the span of the oval inset by the pen size.
+void oval_ring(const Rect& r, Point pen, int16_t y, const SpanFunc& span) {
+    int16_t outer_left = 0, outer_right = 0, inner_left = 0, inner_right = 0;
+    bool    outer = oval_span(r, y, &outer_left, &outer_right);
+    bool    inner = outer && oval_span(inset(r, pen), y, &inner_left, &inner_right);
+    ring(y, outer, outer_left, outer_right, inner, inner_left, inner_right, span);
+}
+
+// The region of the plane between two rays from the center of a rect.
+//
+// Rather than testing each pixel's angle, each span is cut at the (at most two) points where the
+// bounding rays cross its row, and only the midpoint of each piece is tested.
+class Wedge {
+  public:
+    Wedge(const Rect& r, int16_t start, int16_t extent)
+            : _cx(r.left + r.width() / 2.0),
+              _cy(r.top + r.height() / 2.0),
+              _a(max(r.width() / 2.0, 0.5)),
+              _b(max(r.height() / 2.0, 0.5)) {
+        double s = start;
+        double e = extent;
+        if (e < 0) {
+            s += e;
+            e = -e;
+        }
+        s = fmod(s, 360.0);
+        if (s < 0) {
+            s += 360.0;
+        }
+        _start  = s;
+        _extent = min(e, 360.0);
+    }
+
+    void clip(int16_t y, int16_t left, int16_t right, const SpanFunc& span) const {
+        if (_extent >= 360.0) {
+            span(y, left, right);
+            return;
+        }
+
+        int16_t cuts[4] = {left};
+        int     n       = 1;
+        for (double angle : {_start, _start + _extent}) {
+            int16_t cut;
+            if (crossing(angle, y, &cut) && (left < cut) && (cut < right)) {
+                cuts[n++] = cut;
+            }
+        }
+        std::sort(cuts + 1, cuts + n);
+        cuts[n++] = right;
+
+        for (int i = 0; i + 1 < n; ++i) {
+            if ((cuts[i] < cuts[i + 1]) && contains((cuts[i] + cuts[i + 1]) / 2.0, y + 0.5)) {
+                span(y, cuts[i], cuts[i + 1]);
+            }
+        }
+    }
+
+  private:
+    // Finds where the ray at `angle` crosses the center line of row `y`, if it does.
+    bool crossing(double angle, int16_t y, int16_t* x) const {
+        const double radians = angle * M_PI / 180.0;
+        const double dx      = _a * sin(radians);
+        const double dy      = -_b * cos(radians);
+        if (fabs(dy) < 1e-9) {
+            return false;
+        }
+        const double t = (y + 0.5 - _cy) / dy;
+        if (t <= 0) {
+            return false;
+        }
+        *x = pixel_edge(_cx + (dx * t));
+        return true;
+    }
+
+    bool contains(double x, double y) const {
+        double angle = atan2((x - _cx) / _a, (_cy - y) / _b) * 180.0 / M_PI;
+        if (angle < 0) {
+            angle += 360.0;
+        }
+        double offset = angle - _start;
+        if (offset < 0) {
+            offset += 360.0;
+        }
+        return offset < _extent;
+    }
+
+    double _cx, _cy;
+    double _a, _b;
+    double _start, _extent;
+};
+
+}  // namespace
+
+void paint_rect(const Rect& r, const SpanFunc& span) {
+    if (is_empty(r)) {
+        return;
+    }
+    for (int16_t y = r.top; y < r.bottom; ++y) {
+        span(y, r.left, r.right);
+    }
+}
+
+void frame_rect(const Rect& r, Point pen, const SpanFunc& span) {
+    if (is_empty(r) || (pen.h <= 0) || (pen.v <= 0)) {
+        return;
+    } else if ((2 * pen.v >= r.height()) || (2 * pen.h >= r.width())) {
+        paint_rect(r, span);
+        return;
+    }
+    for (int16_t y = r.top; y < r.bottom; ++y) {
+        if ((y < r.top + pen.v) || (y >= r.bottom - pen.v)) {
+            span(y, r.left, r.right);
+        } else {
+            span(y, r.left, r.left + pen.h);
+            span(y, r.right - pen.h, r.right);
+        }
+    }
+}
+
+void paint_oval(const Rect& r, const SpanFunc& span) {
+    for (int16_t y = r.top; y < r.bottom; ++y) {
+        int16_t left, right;
+        if (oval_span(r, y, &left, &right)) {
+            span(y, left, right);
+        }
+    }
+}
+
+void frame_oval(const Rect& r, Point pen, const SpanFunc& span) {
+    if ((pen.h <= 0) || (pen.v <= 0)) {
+        return;
+    }
+    for (int16_t y = r.top; y < r.bottom; ++y) {
+        oval_ring(r, pen, y, span);
+    }
+}
+
+void paint_rrect(const Rect& r, Point oval, const SpanFunc& span) {
+    for (int16_t y = r.top; y < r.bottom; ++y) {
+        int16_t left, right;
+        if (rrect_span(r, oval, y, &left, &right)) {
+            span(y, left, right);
+        }
+    }
+}
+
+void frame_rrect(const Rect& r, Point oval, Point pen, const SpanFunc& span) {
+    if ((pen.h <= 0) || (pen.v <= 0)) {
+        return;
+    }
+    // The inner edge of the frame follows an oval smaller by the pen size on each side, so that
+    // the frame has the same thickness around the corners as along the sides.
+    const Rect  inner_rect = inset(r, pen);
+    const Point inner_oval = {int16_t(oval.v - 2 * pen.v), int16_t(oval.h - 2 * pen.h)};
+    for (int16_t y = r.top; y < r.bottom; ++y) {
+        int16_t outer_left = 0, outer_right = 0, inner_left = 0, inner_right = 0;
+        bool    outer = rrect_span(r, oval, y, &outer_left, &outer_right);
+        bool    inner = outer && rrect_span(inner_rect, inner_oval, y, &inner_left, &inner_right);
+        ring(y, outer, outer_left, outer_right, inner, inner_left, inner_right, span);
+    }
+}
+
+void paint_arc(const Rect& r, int16_t start, int16_t extent, const SpanFunc& span) {
+    const Wedge wedge(r, start, extent);
+    for (int16_t y = r.top; y < r.bottom; ++y) {
+        int16_t left, right;
+        if (oval_span(r, y, &left, &right)) {
+            wedge.clip(y, left, right, span);
+        }
+    }
+}
+
+void frame_arc(const Rect& r, int16_t start, int16_t extent, Point pen, const SpanFunc& span) {
+    if ((pen.h <= 0) || (pen.v <= 0)) {
+        return;
+    }
+    const Wedge    wedge(r, start, extent);
+    const SpanFunc clipped = [&wedge, &span](int16_t y, int16_t left, int16_t right) {
+        wedge.clip(y, left, right, span);
+    };
+    for (int16_t y = r.top; y < r.bottom; ++y) {
+        oval_ring(r, pen, y, clipped);
+    }
+}
+
+void paint_poly(const vector<Point>& points, const SpanFunc& span) {
+    if (points.size() < 3) {
+        return;
+    }
+    int16_t top    = points[0].v;
+    int16_t bottom = points[0].v;
+    for (const Point& p : points) {
+        top    = min(top, p.v);
+        bottom = max(bottom, p.v);
+    }
+
+    // Even-odd fill: on each row, find where the center line crosses the edges of the polygon
+    // (including the implicit closing edge), and fill between alternate pairs of crossings.
+    vector<double> crossings;
+    for (int16_t y = top; y < bottom; ++y) {
+        const double center = y + 0.5;
+        crossings.clear();
+        for (size_t i = 0; i < points.size(); ++i) {
+            const Point& p = points[i];
+            const Point& q = points[(i + 1) % points.size()];
+            if ((p.v <= center) != (q.v <= center)) {
+                crossings.push_back(p.h + (center - p.v) * (q.h - p.h) / double(q.v - p.v));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+            int16_t left  = pixel_edge(crossings[i]);
+            int16_t right = pixel_edge(crossings[i + 1]);
+            if (left < right) {
+                span(y, left, right);
+            }
+        }
+    }
+}
+
+void frame_poly(const vector<Point>& points, Point pen, const SpanFunc& span) {
+    for (size_t i = 0; i + 1 < points.size(); ++i) {
+        line(points[i], points[i + 1], pen, span);
+    }
+}
+
+void line(Point from, Point to, Point pen, const SpanFunc& span) {
+    if ((pen.h <= 0) || (pen.v <= 0)) {
+        return;
+    }
+
+    // Walk the line with Bresenham's algorithm, stamping the pen at each step.  The area swept by
+    // the pen is convex, so it covers a single span on each row; accumulate the extent of each row
+    // and emit it once, rather than emitting a span per stamp.
+    const int              top = min(from.v, to.v);
+    vector<pair<int, int>> rows(abs(to.v - from.v) + pen.v, pair<int, int>(INT_MAX, INT_MIN));
+
+    const int dx    = abs(to.h - from.h);
+    const int dy    = -abs(to.v - from.v);
+    const int sx    = (from.h < to.h) ? 1 : -1;
+    const int sy    = (from.v < to.v) ? 1 : -1;
+    int       error = dx + dy;
+    int       x     = from.h;
+    int       y     = from.v;
+    while (true) {
+        for (int row = y; row < y + pen.v; ++row) {
+            pair<int, int>& extent = rows[row - top];
+            extent.first           = min(extent.first, x);
+            extent.second          = max(extent.second, x + pen.h);
+        }
+        if ((x == to.h) && (y == to.v)) {
+            break;
+        }
+        int e2 = 2 * error;
+        if (e2 >= dy) {
+            error += dy;
+            x += sx;
+        }
+        if (e2 <= dx) {
+            error += dx;
+            y += sy;
+        }
+    }
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (rows[i].first < rows[i].second) {
+            span(top + i, rows[i].first, rows[i].second);
+        }
+    }
+}
+
+}  // namespace rezin
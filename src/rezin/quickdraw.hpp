@@ -0,0 +1,46 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#ifndef REZIN_QUICKDRAW_HPP_
+#define REZIN_QUICKDRAW_HPP_
+
+#include <functional>
+#include <rezin/primitives.hpp>
+#include <vector>
+
+namespace rezin {
+
+// Receives the pixels covered by a shape, as a horizontal run [left, right) on row y.
+//
+// Spans of a single shape never overlap each other on the same row, except for lines, where the
+// pen may be stamped more than once over the same pixels.
+typedef std::function<void(int16_t y, int16_t left, int16_t right)> SpanFunc;
+
+// Scanline rasterization of QuickDraw shapes.
+//
+// Shapes follow QuickDraw's coordinate conventions: rects are half-open, with pixel (x, y)
+// covering the area from (x, y) to (x + 1, y + 1); a pixel belongs to a shape if its center does.
+// Frames are drawn inside the shape's rect with the given pen size.  Arc angles are in degrees,
+// measured clockwise from 12 o'clock, and relative to the rect, so that 45 degrees always passes
+// through the rect's top-right corner.  Rounded rects have their corners cut by the quarters of an
+// oval, `oval.h` wide and `oval.v` high.
+void paint_rect(const Rect& r, const SpanFunc& span);
+void frame_rect(const Rect& r, Point pen, const SpanFunc& span);
+void paint_rrect(const Rect& r, Point oval, const SpanFunc& span);
+void frame_rrect(const Rect& r, Point oval, Point pen, const SpanFunc& span);
+void paint_oval(const Rect& r, const SpanFunc& span);
+void frame_oval(const Rect& r, Point pen, const SpanFunc& span);
+void paint_arc(const Rect& r, int16_t start, int16_t extent, const SpanFunc& span);
+void frame_arc(const Rect& r, int16_t start, int16_t extent, Point pen, const SpanFunc& span);
+void paint_poly(const std::vector<Point>& points, const SpanFunc& span);
+void frame_poly(const std::vector<Point>& points, Point pen, const SpanFunc& span);
+
+// Draws a line by dragging the pen, which hangs below and to the right of its location, from
+// `from` to `to`.  Draws nothing if either dimension of the pen is zero.
+void line(Point from, Point to, Point pen, const SpanFunc& span);
+
+}  // namespace rezin
+
+#endif  // REZIN_QUICKDRAW_HPP_
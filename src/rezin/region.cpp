@@ -0,0 +1,199 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#include <rezin/region.hpp>
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+using std::vector;
+
+namespace rezin {
+
+namespace {
+
+const int16_t kRegionEnd = 0x7fff;
+
+// Returns the edges of the pixels in exactly one of `a` and `b`.
+//
+// Both lists are sorted and each edge toggles between inside and outside, so this is a merge
+// which drops edges present in both.
+vector<int16_t> invert(const vector<int16_t>& a, const vector<int16_t>& b) {
+    vector<int16_t> result;
+    result.reserve(a.size() + b.size());
+    auto i = a.begin(), j = b.begin();
+    while ((i != a.end()) && (j != b.end())) {
+        if (*i < *j) {
+            result.push_back(*i++);
+        } else if (*j < *i) {
+            result.push_back(*j++);
+        } else {
+            ++i, ++j;
+        }
+    }
+    result.insert(result.end(), i, a.end());
+    result.insert(result.end(), j, b.end());
+    return result;
+}
+
+// Returns the edges of the pixels in both `a` and `b`.
+vector<int16_t> intersect_edges(const vector<int16_t>& a, const vector<int16_t>& b) {
+    vector<int16_t> result;
+    size_t          i = 0, j = 0;
+    while ((i < a.size()) && (j < b.size())) {
+        int16_t left  = max(a[i], b[j]);
+        int16_t right = min(a[i + 1], b[j + 1]);
+        if (left < right) {
+            result.push_back(left);
+            result.push_back(right);
+        }
+        if (a[i + 1] < b[j + 1]) {
+            i += 2;
+        } else {
+            j += 2;
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+Region::Region() : _bounds{0, 0, 0, 0} {}
+
+Region::Region(const Rect& rect) : _bounds{0, 0, 0, 0} {
+    add_band(rect.top, rect.bottom, {rect.left, rect.right});
+}
+
+const Rect& Region::bounds() const { return _bounds; }
+
+bool Region::empty() const { return _bands.empty(); }
+
+const vector<Region::Band>& Region::bands() const { return _bands; }
+
+const vector<int16_t>& Region::row(int16_t y) const {
+    static const vector<int16_t> kEmpty;
+    auto band = std::upper_bound(
+            _bands.begin(), _bands.end(), y,
+            [](int16_t y, const Band& band) { return y < band.bottom; });
+    if ((band == _bands.end()) || (y < band->top)) {
+        return kEmpty;
+    }
+    return band->edges;
+}
+
+Region Region::intersect(const Region& other) const {
+    Region result;
+    auto   a = _bands.begin(), b = other._bands.begin();
+    while ((a != _bands.end()) && (b != other._bands.end())) {
+        int16_t top    = max(a->top, b->top);
+        int16_t bottom = min(a->bottom, b->bottom);
+        if (top < bottom) {
+            result.add_band(top, bottom, intersect_edges(a->edges, b->edges));
+        }
+        if (a->bottom < b->bottom) {
+            ++a;
+        } else {
+            ++b;
+        }
+    }
+    return result;
+}
+
+// A pixel stays in the inset region if all pixels within `pen` of it, vertically and
+// horizontally, are in the region: that is, if it is in each row within `pen.v` of its own, once
+// the spans of those rows are shrunk by `pen.h` on each side.  Each row of the frame is then the
+// row of the region, minus that of the inset region; since one contains the other, inverting one
+// by the other leaves the difference.
+Region Region::frame(Point pen) const {
+    Region result;
+    if ((pen.h <= 0) || (pen.v <= 0)) {
+        return result;
+    }
+    for (int16_t y = _bounds.top; y < _bounds.bottom; ++y) {
+        vector<int16_t> inner = row(y);
+        for (int16_t dy = 1; (dy <= pen.v) && !inner.empty(); ++dy) {
+            inner = intersect_edges(inner, row(y - dy));
+            inner = intersect_edges(inner, row(y + dy));
+        }
+        vector<int16_t> shrunk;
+        for (size_t i = 0; i < inner.size(); i += 2) {
+            if ((inner[i + 1] - inner[i]) > (2 * pen.h)) {
+                shrunk.push_back(inner[i] + pen.h);
+                shrunk.push_back(inner[i + 1] - pen.h);
+            }
+        }
+        result.add_band(y, y + 1, invert(row(y), shrunk));
+    }
+    return result;
+}
+
+// Appends a band below the existing ones, merging it into the last band if they are adjacent
+// with the same contents.  Empty bands are dropped.
+void Region::add_band(int16_t top, int16_t bottom, vector<int16_t> edges) {
+    if ((top >= bottom) || edges.empty() || (edges.front() >= edges.back())) {
+        return;
+    }
+    if (_bands.empty()) {
+        _bounds = Rect{top, edges.front(), bottom, edges.back()};
+    } else {
+        _bounds.left   = min(_bounds.left, edges.front());
+        _bounds.bottom = bottom;
+        _bounds.right  = max(_bounds.right, edges.back());
+        if ((_bands.back().bottom == top) && (_bands.back().edges == edges)) {
+            _bands.back().bottom = bottom;
+            return;
+        }
+    }
+    _bands.push_back(Band{top, bottom, std::move(edges)});
+}
+
+void read_from(pn::file_view in, Region* out) {
+    uint16_t size;
+    Rect     bbox;
+    in.read(&size).check();
+    read_from(in, &bbox);
+    *out = Region();
+    if (size == 10) {
+        *out = Region(bbox);
+        return;
+    } else if (size < 10) {
+        throw std::runtime_error(pn::format("invalid region size {0}", size).c_str());
+    }
+
+    vector<int16_t> edges;
+    int16_t         y;
+    in.read(&y).check();
+    while (y != kRegionEnd) {
+        vector<int16_t> inversions;
+        int16_t         x;
+        in.read(&x).check();
+        while (x != kRegionEnd) {
+            if (!inversions.empty() && (x <= inversions.back())) {
+                throw std::runtime_error("region inversion points out of order");
+            }
+            inversions.push_back(x);
+            in.read(&x).check();
+        }
+        if ((inversions.size() % 2) != 0) {
+            throw std::runtime_error("region scanline has odd number of inversion points");
+        }
+
+        int16_t next_y;
+        in.read(&next_y).check();
+        if (next_y <= y) {
+            throw std::runtime_error("region scanlines out of order");
+        }
+        edges = invert(edges, inversions);
+        if (next_y != kRegionEnd) {
+            out->add_band(y, next_y, edges);
+        } else if (!edges.empty()) {
+            throw std::runtime_error("region is not closed");
+        }
+        y = next_y;
+    }
+}
+
+}  // namespace rezin
@@ -0,0 +1,70 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#ifndef REZIN_REGION_HPP_
+#define REZIN_REGION_HPP_
+
+#include <rezin/primitives.hpp>
+#include <sfz/sfz.hpp>
+#include <vector>
+
+namespace rezin {
+
+// A QuickDraw region: an arbitrary set of pixels.
+//
+// The region is stored as a list of bands, sorted from top to bottom, each of which covers a range
+// of rows with identical contents.  The contents of a band are a sorted list of edges, where each
+// pair of edges [left, right) is a span of pixels inside the region.  Rows which are not covered
+// by any band are empty.
+class Region {
+  public:
+    struct Band {
+        int16_t              top;
+        int16_t              bottom;
+        std::vector<int16_t> edges;
+    };
+
+    // Constructs an empty region.
+    Region();
+
+    // Constructs a region covering all of `rect`.
+    explicit Region(const Rect& rect);
+
+    const Rect&              bounds() const;
+    bool                     empty() const;
+    const std::vector<Band>& bands() const;
+
+    // Returns the edges of row `y`, or an empty list if the row is outside of the region.
+    const std::vector<int16_t>& row(int16_t y) const;
+
+    // Returns the pixels inside both `this` and `other`.
+    Region intersect(const Region& other) const;
+
+    // Returns the pixels which the pen, `pen.h` wide and `pen.v` high, covers when it is dragged
+    // around the inside of the region's outline: the region, minus the region inset by the pen.
+    Region frame(Point pen) const;
+
+  private:
+    friend void read_from(pn::file_view in, Region* out);
+
+    void add_band(int16_t top, int16_t bottom, std::vector<int16_t> edges);
+
+    Rect              _bounds;
+    std::vector<Band> _bands;
+};
+
+// Reads a region in QuickDraw's format.
+//
+// The format is a 10-byte header (size and bounding box), followed, for non-rectangular regions,
+// by a list of inversion scanlines.  Each scanline holds a row number and a list of x coordinates
+// terminated by $7FFF; the contents of that row are the contents of the previous row, inverted
+// between each pair of x coordinates.  The list of scanlines is also terminated by $7FFF.
+//
+// @throws std::runtime_error    If the region is malformed.
+void read_from(pn::file_view in, Region* out);
+
+}  // namespace rezin
+
+#endif  // REZIN_REGION_HPP_
@@ -0,0 +1,159 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#include <rezin/snd.hpp>
+
+#include <math.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using std::max;
+using std::min;
+using std::vector;
+
+namespace rezin {
+
+namespace {
+
+// The number of fractional positions between input samples for which a set of filter
+// coefficients is precomputed.  Output samples use the coefficients of the nearest phase.
+const int kPhases = 256;
+
+// The number of input samples on each side of an output sample which contribute to it, when not
+// reducing the sample rate.  When reducing it, the filter is widened in proportion.
+const int kHalfWidth    = 16;
+const int kMaxHalfWidth = 256;
+
+// The number of partial sums kept by the dot product of each output sample.
+const int kLanes = 8;
+
+// A windowed-sinc low-pass filter, sampled at kPhases fractional offsets.
+//
+// `taps` is the number of coefficients in each phase; the coefficients of phase p are for the
+// input samples at offsets [1 - taps / 2, taps / 2] from the one before the output sample, when
+// the output sample is p / kPhases of the way to the next one.  Each phase is padded with zeros
+// to `stride` coefficients, a multiple of kLanes.
+class PolyphaseFilter {
+  public:
+    PolyphaseFilter(double cutoff)
+            : _half_width(min(int(ceil(kHalfWidth / cutoff)), kMaxHalfWidth)),
+              _coefficients((kPhases + 1) * stride(), 0.0f) {
+        for (int p = 0; p <= kPhases; ++p) {
+            const double fraction = double(p) / kPhases;
+            float*       phase    = &_coefficients[p * stride()];
+            double       sum      = 0;
+            for (int k = 0; k < taps(); ++k) {
+                const double x = (k - _half_width + 1) - fraction;
+                phase[k]       = kernel(x, cutoff);
+                sum += phase[k];
+            }
+            // Normalize each phase to unit gain, so that a constant signal stays constant.
+            for (int k = 0; k < taps(); ++k) {
+                phase[k] /= sum;
+            }
+        }
+    }
+
+    int taps() const { return 2 * _half_width; }
+    int stride() const { return ((taps() + kLanes - 1) / kLanes) * kLanes; }
+    int half_width() const { return _half_width; }
+
+    const float* phase(int p) const { return &_coefficients[p * stride()]; }
+
+  private:
+    double kernel(double x, double cutoff) const {
+        const double u = x / _half_width;
+        if (fabs(u) >= 1.0) {
+            return 0.0;
+        }
+        const double window = 0.42 + 0.5 * cos(M_PI * u) + 0.08 * cos(2 * M_PI * u);
+        const double t      = M_PI * cutoff * x;
+        const double sinc   = (fabs(t) < 1e-9) ? 1.0 : (sin(t) / t);
+        return cutoff * sinc * window;
+    }
+
+    const int     _half_width;
+    vector<float> _coefficients;
+};
+
+// Returns the sample of `channel` in `frame` of `sound`, scaled to [-1, 1).
+float sample_at(const Sound& sound, size_t frame, size_t channel) {
+    const size_t   i = (frame * sound.channels) + channel;
+    const uint8_t* s = sound.samples.data();
+    if (sound.sample_bits == 8) {
+        return (int(s[i]) - 0x80) / 128.0f;
+    }
+    return int16_t((s[2 * i] << 8) | s[2 * i + 1]) / 32768.0f;
+}
+
+}  // namespace
+
+Sound resample(const Sound& sound, double sample_rate) {
+    if ((sample_rate <= 0) || (sound.sample_rate <= 0)) {
+        throw std::runtime_error("sample rate must be positive");
+    } else if (sample_rate == sound.sample_rate) {
+        return sound;
+    }
+
+    const double          step = sound.sample_rate / sample_rate;
+    const PolyphaseFilter filter(min(1.0, 1.0 / step));
+    const size_t          in_frames  = sound.frames();
+    const size_t          out_frames = ceil(in_frames / step);
+    const int             pad        = filter.half_width();
+
+    std::shared_ptr<vector<uint8_t>> out(
+            new vector<uint8_t>(out_frames * sound.channels * 2));
+    vector<float> channel(in_frames + 2 * pad + kLanes);
+    for (size_t ch = 0; ch < sound.channels; ++ch) {
+        // Deinterleave the channel into a contiguous, zero-padded array, so that the inner loop
+        // below is a plain dot product.  The padding at the end also covers the zeros at the end
+        // of each phase of the filter.
+        for (size_t i = 0; i < in_frames; ++i) {
+            channel[pad + i] = sample_at(sound, i, ch);
+        }
+
+        for (size_t n = 0; n < out_frames; ++n) {
+            const double t     = n * step;
+            size_t       i     = size_t(t);
+            int          phase = lround((t - i) * kPhases);
+
+            // Input samples [i + 1 - half_width, i + half_width] contribute to this output.
+            //
+            // A single running sum would be a chain of dependent adds, which the compiler may not
+            // reorder without -ffast-math, so it couldn't vectorize the loop.  Instead, kLanes
+            // independent sums are kept, and added together at the end.
+            const float* in     = &channel[pad + i + 1 - filter.half_width()];
+            const float* coeffs = filter.phase(phase);
+
+            float partial[kLanes] = {};
+            for (int k = 0; k < filter.stride(); k += kLanes) {
+                for (int j = 0; j < kLanes; ++j) {
+                    partial[j] += in[k + j] * coeffs[k + j];
+                }
+            }
+            float sum = 0;
+            for (float p : partial) {
+                sum += p;
+            }
+
+            const int32_t value  = max(-32768L, min(lround(sum * 32768.0f), 32767L));
+            uint8_t*      sample = &(*out)[2 * ((n * sound.channels) + ch)];
+            sample[0]            = uint16_t(value) >> 8;
+            sample[1]            = uint16_t(value);
+        }
+    }
+
+    Sound result;
+    result.fmt         = sound.fmt;
+    result.channels    = sound.channels;
+    result.sample_bits = 16;
+    result.sample_rate = sample_rate;
+    result.decoded     = out;
+    result.samples     = pn::data_view{out->data(), int(out->size())};
+    return result;
+}
+
+}  // namespace rezin
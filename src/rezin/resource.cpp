@@ -5,6 +5,7 @@
 
 #include <rezin/resource.hpp>
 
+#include <rezin/endian.hpp>
 #include <rezin/options.hpp>
 #include <sfz/sfz.hpp>
 
@@ -17,38 +18,96 @@ namespace macroman = sfz::macroman;
 
 namespace rezin {
 
+namespace {
+
+struct ResourceHeader {
+    be<uint32_t> data_offset;
+    be<uint32_t> map_offset;
+    be<uint32_t> data_length;
+    be<uint32_t> map_length;
+};
+
+struct MapHeader {
+    uint8_t      reserved[24];  // copy of ResourceHeader, next map handle, file ref, attributes.
+    be<uint16_t> type_offset;
+    be<uint16_t> name_offset;
+    be<uint16_t> type_count;  // minus one.
+};
+
+struct TypeListEntry {
+    uint8_t      code[4];
+    be<uint16_t> count;  // minus one.
+    be<uint16_t> offset;
+};
+
+struct ReferenceListEntry {
+    be<int16_t>  id;
+    be<uint16_t> name_offset;
+    be<uint32_t> data_offset;  // high byte holds attributes.
+    be<uint32_t> handle;
+};
+
+}  // namespace
+
+// The resource data section of a fork: either `data`, in memory, or the section at `offset` within
+// the fork read by `reader`.
+struct ResourceData {
+    pn::data_view data;
+    ForkReader*   reader;
+    uint64_t      offset;
+};
+
 ResourceFork::ResourceFork(const pn::data_view& data, const Options& options) {
-    // Resource header.
-    pn::file header = data.slice(0, 16).open();
-    uint32_t data_offset;
-    uint32_t map_offset;
-    uint32_t data_length;
-    uint32_t map_length;
-    header.read(&data_offset, &map_offset, &data_length, &map_length);
-
-    pn::data_view map_data  = data.slice(map_offset, map_length);
-    pn::data_view data_data = data.slice(data_offset, data_length);
-
-    // Map header.
-    pn::file map = map_data.slice(16, 14).open();
-    uint16_t type_offset;
-    uint16_t name_offset;
-    uint16_t type_count;
-    map.read(pn::pad(8), &type_offset, &name_offset, &type_count);
-    ++type_count;
-
-    pn::data_view type_data = map_data.slice(type_offset);
-    pn::data_view name_data = map_data.slice(name_offset);
-
-    for (uint16_t i : range(type_count)) {
+    const ResourceHeader& header   = overlay<ResourceHeader>(data);
+    pn::data_view         map_data = data.slice(header.map_offset, header.map_length);
+    read_types(
+            map_data, ResourceData{data.slice(header.data_offset, header.data_length), nullptr, 0},
+            options);
+}
+
+ResourceFork::ResourceFork(std::unique_ptr<ForkReader> reader, const Options& options)
+        : _reader(std::move(reader)) {
+    ResourceHeader header;
+    _reader->read(0, sizeof(header), reinterpret_cast<uint8_t*>(&header));
+
+    // Check the map against the fork before allocating it, since its length is untrusted.
+    if ((uint64_t(header.map_offset) + header.map_length) > _reader->size()) {
+        throw std::runtime_error("resource map extends past end of fork");
+    }
+    _map.resize(header.map_length);
+    _reader->read(header.map_offset, _map.size(), _map.data());
+    read_types(_map, ResourceData{pn::data_view{}, _reader.get(), header.data_offset}, options);
+}
+
+void ResourceFork::read_types(
+        const pn::data_view& map_data, const ResourceData& data, const Options& options) {
+    const MapHeader& map        = overlay<MapHeader>(map_data);
+    const uint32_t   type_count = map.type_count + 1;
+
+    pn::data_view type_data = map_data.slice(map.type_offset);
+    pn::data_view name_data = map_data.slice(map.name_offset);
+
+    for (uint32_t i : range(type_count)) {
         unique_ptr<ResourceType> type(
-                new ResourceType(type_data, i, name_data, data_data, options));
+                new ResourceType(type_data, i, name_data, data, options));
         _types[pn::string_view(type->code())] = std::move(type);
     }
 }
 
 ResourceFork::~ResourceFork() {}
 
+bool ResourceFork::has_header(const pn::data_view& data, uint64_t size) {
+    if (data.size() < int(sizeof(ResourceHeader))) {
+        return false;
+    }
+    const ResourceHeader& header   = overlay<ResourceHeader>(data);
+    const uint64_t        data_end = uint64_t(header.data_offset) + header.data_length;
+    const uint64_t        map_end  = uint64_t(header.map_offset) + header.map_length;
+    return (header.data_offset >= sizeof(ResourceHeader)) &&
+           (header.map_length >= (sizeof(MapHeader) + 2)) && (data_end <= size) &&
+           (map_end <= size) && ((data_end <= header.map_offset) || (map_end <= header.data_offset));
+}
+
 const ResourceType& ResourceFork::at(const pn::string_view& code) const {
     StringMap<unique_ptr<ResourceType>>::const_iterator it = _types.find(code);
     if (it == _types.end()) {
@@ -63,18 +122,16 @@ ResourceFork::const_iterator ResourceFork::end() const { return const_iterator(_
 
 ResourceType::ResourceType(
         const pn::data_view& type_data, int index, const pn::data_view& name_data,
-        const pn::data_view& data_data, const Options& options) {
-    _code         = macroman::decode(type_data.slice(2 + index * 8, 4));
-    pn::file type = type_data.slice(6 + index * 8, 4).open();
-    uint16_t count;
-    uint16_t offset;
-    type.read(&count, &offset).check();
-    ++count;
-
-    pn::data_view entry_data = type_data.slice(offset);
-    for (uint16_t i : range(count)) {
+        const ResourceData& data, const Options& options) {
+    // The type list starts with the count of types, already read by ResourceFork.
+    const TypeListEntry& type = overlay<TypeListEntry>(type_data, 2 + index * 8);
+    _code                     = macroman::decode(pn::data_view{type.code, 4});
+    const uint32_t count      = type.count + 1;
+
+    pn::data_view entry_data = type_data.slice(type.offset);
+    for (uint32_t i : range(count)) {
         unique_ptr<ResourceEntry> entry(
-                new ResourceEntry(entry_data, i, name_data, data_data, options));
+                new ResourceEntry(entry_data, i, name_data, data, options));
         _entries[entry->id()] = std::move(entry);
     }
 }
@@ -91,6 +148,8 @@ const ResourceEntry& ResourceType::at(int16_t i) const {
     return *it->second;
 }
 
+size_t ResourceType::size() const { return _entries.size(); }
+
 ResourceType::const_iterator ResourceType::begin() const {
     return const_iterator(_entries.begin());
 }
@@ -101,26 +160,52 @@ int16_t ResourceEntry::id() const { return _id; }
 
 const pn::string& ResourceEntry::name() const { return _name; }
 
-const pn::data_view& ResourceEntry::data() const { return _data; }
+const pn::data_view& ResourceEntry::data() const {
+    if (_reader && !_loaded) {
+        // The size is untrusted, so check it against the fork before allocating.  Reading it
+        // succeeded, so `_offset + 4` is within the fork, and the sum can't overflow.
+        uint8_t size_data[4];
+        _reader->read(_offset, sizeof(size_data), size_data);
+        const uint32_t size = overlay<be<uint32_t>>(pn::data_view{size_data, sizeof(size_data)});
+        if (size > (_reader->size() - (_offset + sizeof(size_data)))) {
+            throw std::runtime_error("resource extends past end of fork");
+        }
+        _owned.resize(size);
+        _reader->read(_offset + sizeof(size_data), _owned.size(), _owned.data());
+        _data   = _owned;
+        _loaded = true;
+    }
+    return _data;
+}
+
+void ResourceEntry::release() const {
+    if (_reader) {
+        _data   = pn::data_view{};
+        _owned  = pn::data{};
+        _loaded = false;
+    }
+}
 
 ResourceEntry::ResourceEntry(
         const pn::data_view& entry_data, int index, const pn::data_view& name_data,
-        const pn::data_view& data_data, const Options& options) {
-    pn::file entry_remainder = entry_data.slice(index * 12, 12).open();
-    uint16_t name_offset;
-    uint32_t data_offset;
-    entry_remainder.read(&_id, &name_offset, &data_offset, pn::pad(4));
-    data_offset &= 0x00FFFFFF;
+        const ResourceData& data, const Options& options)
+        : _loaded(false), _reader(data.reader), _offset(0) {
+    const ReferenceListEntry& entry       = overlay<ReferenceListEntry>(entry_data, index * 12);
+    const uint16_t            name_offset = entry.name_offset;
+    const uint32_t            data_offset = entry.data_offset & 0x00FFFFFF;
+    _id                                   = entry.id;
 
     if (name_offset != (uint16_t)-1) {
-        uint8_t name_size = name_data[name_offset];
+        uint8_t name_size = overlay<uint8_t>(name_data, name_offset);
         _name             = options.decode(name_data.slice(name_offset + 1, name_size));
     }
 
-    pn::file data_remainder = data_data.slice(data_offset, 4).open();
-    uint32_t data_size;
-    data_remainder.read(&data_size).check();
-    _data = data_data.slice(data_offset + 4, data_size);
+    if (_reader) {
+        _offset = data.offset + data_offset;
+    } else {
+        const uint32_t data_size = overlay<be<uint32_t>>(data.data, data_offset);
+        _data                    = data.data.slice(data_offset + 4, data_size);
+    }
 }
 
 }  // namespace rezin
@@ -5,7 +5,11 @@
 
 #include <rezin/snd.hpp>
 
+#include <math.h>
 #include <string.h>
+#include <algorithm>
+#include <memory>
+#include <rezin/endian.hpp>
 #include <sfz/sfz.hpp>
 
 using sfz::StringMap;
@@ -19,126 +23,572 @@ namespace rezin {
 
 namespace {
 
+const uint16_t SAMPLED_SYNTH = 5;
+
+// Sound commands which refer to a sound header.  When the data pointer flag is set on a command,
+// its second parameter is the offset of the sound header within the resource.
+enum {
+    DATA_POINTER_FLAG = 0x8000,
+    SOUND_CMD         = 0x0050,
+    BUFFER_CMD        = 0x0051,
+};
+
+// Initialization options of a format 1 'snd ' resource.
+//
+// These are hints to the Sound Manager about how to set up the sound channel.  The format of the
+// samples themselves, including the number of channels, is given by the sound header, so none of
+// them change how the resource is read; but other bits are reserved, and signal a resource which
+// is probably not a 'snd ' at all.
+enum {
+    INIT_CHANNEL_MASK = 0x0003,  // initChanLeft, initChanRight
+    INIT_NO_INTERP    = 0x0004,
+    INIT_NO_DROP      = 0x0008,
+    INIT_STEREO_MASK  = 0x00c0,  // initMono, initStereo
+    INIT_MACE_MASK    = 0x0700,  // initMACE3, initMACE6
+
+    INIT_KNOWN_OPTIONS =
+            INIT_CHANNEL_MASK | INIT_NO_INTERP | INIT_NO_DROP | INIT_STEREO_MASK | INIT_MACE_MASK,
+};
+
+struct SynthesizerRecord {
+    be<uint16_t> type;
+    be<uint32_t> init_options;
+};
+
+struct SoundCommandRecord {
+    be<uint16_t> command;
+    be<uint16_t> param1;
+    be<uint32_t> param2;
+};
+
 // Read the header of a format 1 'snd ' resource.
 //
-// @param [in] in       The pn::file_view to read from.
-void read_snd_format_1_header(pn::file_view in) {
-    uint16_t synthesizer_count;
-    in.read(&synthesizer_count).check();
-    if (synthesizer_count != 1) {
-        throw std::runtime_error(
-                pn::format("can only handle 1 synthesizer; {0} found", synthesizer_count).c_str());
+// The header lists the synthesizers the sound is meant to be played with.  Only the init options
+// of sampledSynth are checked; other synthesizers don't affect the sampled sound commands.
+//
+// @param [in] in       The content of the 'snd ' resource.
+// @param [in,out] offset The offset of the header, following the format; advanced past it.
+void read_snd_format_1_header(pn::data_view in, uint64_t* offset) {
+    const uint16_t synthesizer_count = overlay<be<uint16_t>>(in, *offset);
+    *offset += 2;
+    for (uint16_t i : range(synthesizer_count)) {
+        static_cast<void>(i);
+        const SynthesizerRecord& synth   = overlay<SynthesizerRecord>(in, *offset);
+        const uint32_t           options = synth.init_options;
+        *offset += sizeof(SynthesizerRecord);
+        if ((synth.type == SAMPLED_SYNTH) && ((options & INIT_KNOWN_OPTIONS) != options)) {
+            throw std::runtime_error(
+                    pn::format("unknown init options 0x{0}", hex(options & ~INIT_KNOWN_OPTIONS))
+                            .c_str());
+        }
     }
+}
 
-    uint16_t type;
-    in.read(&type).check();
-    if (type != 5) {
-        throw std::runtime_error(
-                pn::format("can only handle sampledSynth; {0} found", type).c_str());
-    }
+// Read the header of a format 2 'snd ' resource.
+//
+// @param [in] in       The content of the 'snd ' resource.
+// @param [in,out] offset The offset of the header, following the format; advanced past it.
+void read_snd_format_2_header(pn::data_view in, uint64_t* offset) {
+    overlay<be<uint16_t>>(in, *offset);  // reference count.
+    *offset += 2;
+}
 
-    uint32_t options;
-    in.read(&options).check();
-    if ((options & 0x00F0) != options) {
-        throw std::runtime_error(
-                pn::format("can only handle initMono and initStereo, not 0x{0}", hex(options))
-                        .c_str());
+enum SoundHeaderEncoding {
+    STANDARD_SOUND_HEADER   = 0x00,
+    COMPRESSED_SOUND_HEADER = 0xfe,
+    EXTENDED_SOUND_HEADER   = 0xff,
+};
+
+// The variants of the sound header.  The standard header is the prefix of the other two.
+struct SoundHeaderRecord {
+    be<uint32_t> sample_ptr;
+    be<uint32_t> length;  // samples if standard, channels otherwise.
+    be<uint32_t> sample_rate;
+    be<uint32_t> loop_start;
+    be<uint32_t> loop_end;
+    uint8_t      encode;
+    uint8_t      base_frequency;
+};
+
+struct ExtendedSoundHeaderRecord {
+    SoundHeaderRecord header;
+    be<uint32_t>      num_frames;
+    uint8_t           aiff_sample_rate[10];
+    be<uint32_t>      marker_chunk;
+    be<uint32_t>      instrument_chunks;
+    be<uint32_t>      aes_recording;
+    be<uint16_t>      sample_size;
+    uint8_t           future_use[14];
+};
+
+struct CompressedSoundHeaderRecord {
+    SoundHeaderRecord header;
+    be<uint32_t>      num_frames;
+    uint8_t           aiff_sample_rate[10];
+    be<uint32_t>      marker_chunk;
+    be<uint32_t>      format;
+    be<uint32_t>      future_use_2;
+    be<uint32_t>      state_vars;
+    be<uint32_t>      left_over_samples;
+    be<int16_t>       compression_id;
+    be<uint16_t>      packet_size;
+    be<uint16_t>      snth_id;
+    be<uint16_t>      sample_size;
+};
+
+// Compression formats of compressed sound headers.
+const uint32_t kIma4Format  = 0x696d6134;  // 'ima4'
+const uint32_t kMace3Format = 0x4d414333;  // 'MAC3'
+const uint32_t kMace6Format = 0x4d414336;  // 'MAC6'
+
+// Legacy compression IDs, used when the format field is not filled in.
+const int16_t kThreeToOne = 3;
+const int16_t kSixToOne   = 4;
+
+// Returns `size` bytes of sample data, starting `offset` bytes into `in`.
+//
+// @throws std::runtime_error    If the sample data extends past the end of `in`.
+pn::data_view sample_data(pn::data_view in, uint64_t offset, uint64_t size) {
+    if ((offset + size) > static_cast<uint64_t>(in.size())) {
+        throw std::runtime_error("sample data extends past end of 'snd ' resource");
     }
+    return in.slice(offset, size);
 }
 
-// Read the header of a format 2 'snd ' resource.
+// The IMA ADPCM step size and step index adjustment tables.
+const int16_t kImaStepSizes[89] = {
+        7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,
+        25,    28,    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,
+        88,    97,    107,   118,   130,   143,   157,   173,   190,   209,   230,   253,   279,
+        307,   337,   371,   408,   449,   494,   544,   598,   658,   724,   796,   876,   963,
+        1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,  2272,  2499,  2749,  3024,  3327,
+        3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487,
+        12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+const int8_t kImaIndexAdjustments[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+const size_t kIma4PacketSize    = 34;
+const size_t kIma4PacketSamples = 64;
+
+// Decodes a single packet of Apple IMA4 data.
 //
-// @param [in] in       The pn::file_view to read from.
-void read_snd_format_2_header(pn::file_view in) { in.read(pn::pad(2)).check(); }
-
-// Read an individual command from a 'snd ' resource.
+// Each packet is a 2-byte header holding the initial predictor (high 9 bits) and step index
+// (low 7 bits), followed by 64 4-bit codes, low nibble first.  Packets carry their own state, so
+// each can be decoded independently of the others.
 //
-// @param [in] in       The pn::file_view to read from.
-// @param [out] command The sound command.
-// @param [out] param1  The first parameter to the sound command.
-// @param [out] param2  The second parameter to the sound command.
-void read_snd_command(pn::file_view in, uint16_t* command, uint16_t* param1, uint32_t* param2) {
-    in.read(command, param1, param2).check();
+// @param [in] in       The kIma4PacketSize bytes of the packet.
+// @param [in] stride   The distance, in samples, between consecutive samples of the output.
+// @param [out] out     Receives kIma4PacketSamples 16-bit big-endian samples.
+void decode_ima4_packet(const uint8_t* in, size_t stride, uint8_t* out) {
+    const uint16_t header    = (in[0] << 8) | in[1];
+    int32_t        predictor = int16_t(header & 0xff80);
+    int32_t        index     = std::min<int32_t>(header & 0x007f, 88);
+    for (size_t i = 0; i < kIma4PacketSamples; ++i) {
+        const uint8_t code = (in[2 + (i / 2)] >> ((i % 2) * 4)) & 0x0f;
+        const int32_t step = kImaStepSizes[index];
+        int32_t       diff = step >> 3;
+        if (code & 1) {
+            diff += step >> 2;
+        }
+        if (code & 2) {
+            diff += step >> 1;
+        }
+        if (code & 4) {
+            diff += step;
+        }
+        predictor += (code & 8) ? -diff : diff;
+        predictor = std::max(-32768, std::min(predictor, 32767));
+        index     = std::max(0, std::min(index + kImaIndexAdjustments[code & 7], 88));
+
+        uint8_t* sample = out + (2 * i * stride);
+        sample[0]       = uint16_t(predictor) >> 8;
+        sample[1]       = uint16_t(predictor);
+    }
 }
 
-// Read the definition for a block of sampled sound data.
+// Decodes Apple IMA4 data into 16-bit big-endian samples.
 //
-// Much of the data from the table is discarded: loop_start; loop_end; encoding; and
-// base_frequency.  Hopefully this information is not important.
+// The packets of the channels of a multi-channel sound are interleaved: for stereo, a packet of
+// the left channel, then one of the right.  The samples of each packet are written directly to
+// their interleaved positions in the output.
+std::shared_ptr<const vector<uint8_t>> decode_ima4(
+        pn::data_view in, uint32_t channels, uint32_t packets) {
+    std::shared_ptr<vector<uint8_t>> out(
+            new vector<uint8_t>(size_t(packets) * kIma4PacketSamples * channels * 2));
+    const uint8_t* packet = in.data();
+    for (size_t i = 0; i < packets; ++i) {
+        for (size_t ch = 0; ch < channels; ++ch) {
+            uint8_t* frame = out->data() + (2 * ((i * kIma4PacketSamples * channels) + ch));
+            decode_ima4_packet(packet, channels, frame);
+            packet += kIma4PacketSize;
+        }
+    }
+    return out;
+}
+
+// The MACE prediction tables.  kMaceTable1 and kMaceTable3 adjust the step index after each code;
+// kMaceTable2 and kMaceTable4 give the magnitude of the step for each step index, by code.
+const int16_t kMaceTable1[8] = {-13, 8, 76, 222, 222, 76, 8, -13};
+const int16_t kMaceTable2[128][4] = {
+        {37, 116, 206, 330}, {39, 121, 216, 346}, {41, 127, 225, 361}, {42, 132, 235, 377},
+        {44, 137, 245, 392}, {46, 144, 256, 410}, {48, 150, 267, 428}, {51, 157, 280, 449},
+        {53, 165, 293, 470}, {55, 172, 306, 490}, {58, 179, 319, 511}, {60, 187, 333, 534},
+        {63, 195, 348, 557}, {66, 205, 364, 583}, {69, 214, 380, 609}, {72, 223, 396, 635},
+        {75, 233, 414, 663}, {79, 244, 433, 694}, {82, 254, 453, 725}, {86, 265, 472, 756},
+        {90, 278, 495, 792}, {94, 290, 516, 826}, {98, 303, 538, 862}, {102, 316, 562, 901},
+        {107, 331, 588, 942}, {112, 345, 614, 983}, {117, 361, 641, 1027}, {122, 377, 670, 1074},
+        {127, 394, 701, 1123}, {133, 411, 732, 1172}, {139, 430, 764, 1224}, {145, 449, 799, 1280},
+        {152, 469, 835, 1337}, {159, 490, 872, 1397}, {166, 512, 911, 1459}, {173, 535, 951, 1523},
+        {181, 558, 993, 1590}, {189, 584, 1038, 1663}, {197, 610, 1085, 1738},
+        {206, 637, 1133, 1815}, {215, 665, 1183, 1895}, {225, 695, 1237, 1980},
+        {235, 726, 1291, 2068}, {246, 759, 1349, 2161}, {257, 792, 1409, 2257},
+        {268, 828, 1472, 2357}, {280, 865, 1538, 2463}, {293, 903, 1606, 2572},
+        {306, 944, 1678, 2688}, {319, 986, 1753, 2807}, {334, 1030, 1832, 2933},
+        {349, 1076, 1914, 3065}, {364, 1124, 1999, 3202}, {380, 1174, 2088, 3344},
+        {398, 1227, 2182, 3494}, {415, 1281, 2278, 3649}, {434, 1339, 2380, 3811},
+        {453, 1398, 2486, 3982}, {473, 1461, 2598, 4160}, {495, 1526, 2714, 4346},
+        {517, 1594, 2835, 4540}, {540, 1665, 2961, 4741}, {564, 1740, 3093, 4953},
+        {589, 1818, 3232, 5175}, {615, 1898, 3375, 5405}, {643, 1984, 3527, 5647},
+        {671, 2072, 3683, 5898}, {701, 2164, 3848, 6161}, {733, 2261, 4020, 6438},
+        {766, 2362, 4199, 6724}, {800, 2467, 4386, 7024}, {836, 2578, 4583, 7339},
+        {873, 2692, 4786, 7664}, {912, 2813, 5001, 8008}, {952, 2938, 5223, 8364},
+        {995, 3070, 5457, 8739}, {1039, 3207, 5701, 9129}, {1086, 3350, 5956, 9537},
+        {1134, 3499, 6220, 9960}, {1185, 3655, 6497, 10404}, {1238, 3818, 6788, 10869},
+        {1293, 3989, 7091, 11355}, {1351, 4166, 7407, 11861}, {1411, 4352, 7738, 12390},
+        {1474, 4547, 8084, 12946}, {1540, 4750, 8444, 13522}, {1609, 4962, 8821, 14126},
+        {1680, 5183, 9215, 14756}, {1756, 5415, 9626, 15415}, {1834, 5657, 10057, 16104},
+        {1916, 5909, 10505, 16822}, {2001, 6173, 10975, 17574}, {2091, 6448, 11463, 18356},
+        {2184, 6736, 11974, 19175}, {2282, 7037, 12510, 20032}, {2383, 7351, 13068, 20926},
+        {2490, 7679, 13652, 21861}, {2601, 8021, 14260, 22834}, {2717, 8380, 14897, 23854},
+        {2838, 8753, 15561, 24918}, {2965, 9144, 16256, 26031}, {3097, 9553, 16982, 27193},
+        {3236, 9979, 17740, 28407}, {3380, 10424, 18532, 29675}, {3531, 10890, 19359, 31000},
+        {3688, 11375, 20222, 32382}, {3853, 11883, 21125, 32767}, {4025, 12414, 22069, 32767},
+        {4205, 12967, 23053, 32767}, {4392, 13546, 24082, 32767}, {4589, 14151, 25157, 32767},
+        {4793, 14783, 26280, 32767}, {5007, 15442, 27452, 32767}, {5231, 16132, 28678, 32767},
+        {5464, 16851, 29957, 32767}, {5708, 17603, 31294, 32767}, {5963, 18389, 32691, 32767},
+        {6229, 19210, 32767, 32767}, {6507, 20067, 32767, 32767}, {6797, 20963, 32767, 32767},
+        {7101, 21899, 32767, 32767}, {7418, 22876, 32767, 32767}, {7749, 23897, 32767, 32767},
+        {8095, 24964, 32767, 32767}, {8456, 26078, 32767, 32767}, {8833, 27242, 32767, 32767},
+        {9228, 28457, 32767, 32767}, {9639, 29727, 32767, 32767},
+};
+const int16_t kMaceTable3[4] = {-18, 140, 140, -18};
+const int16_t kMaceTable4[128][2] = {
+        {64, 216}, {67, 226}, {70, 236}, {74, 246}, {77, 257}, {80, 268}, {84, 280}, {88, 294},
+        {92, 307}, {96, 321}, {100, 334}, {104, 350}, {109, 365}, {114, 382}, {119, 399},
+        {124, 416}, {130, 434}, {136, 454}, {142, 475}, {148, 495}, {155, 519}, {162, 541},
+        {169, 564}, {176, 590}, {185, 617}, {193, 644}, {201, 673}, {210, 703}, {220, 735},
+        {230, 767}, {240, 801}, {251, 838}, {262, 876}, {274, 914}, {286, 955}, {299, 997},
+        {312, 1041}, {326, 1089}, {341, 1138}, {356, 1188}, {372, 1241}, {388, 1297}, {406, 1354},
+        {424, 1415}, {443, 1478}, {462, 1544}, {483, 1613}, {505, 1684}, {527, 1760}, {551, 1838},
+        {576, 1921}, {601, 2007}, {628, 2097}, {656, 2190}, {686, 2288}, {716, 2389}, {748, 2496},
+        {781, 2607}, {816, 2724}, {853, 2846}, {891, 2973}, {930, 3104}, {972, 3243}, {1016, 3389},
+        {1061, 3539}, {1108, 3698}, {1158, 3862}, {1209, 4035}, {1264, 4216}, {1320, 4403},
+        {1379, 4599}, {1441, 4806}, {1505, 5019}, {1572, 5244}, {1642, 5477}, {1715, 5722},
+        {1792, 5978}, {1872, 6245}, {1955, 6522}, {2043, 6813}, {2134, 7118}, {2229, 7436},
+        {2329, 7767}, {2432, 8114}, {2541, 8477}, {2655, 8854}, {2773, 9250}, {2897, 9663},
+        {3026, 10094}, {3162, 10546}, {3303, 11016}, {3450, 11508}, {3604, 12020}, {3765, 12556},
+        {3933, 13118}, {4108, 13703}, {4292, 14315}, {4483, 14953}, {4683, 15621}, {4892, 16318},
+        {5111, 17046}, {5339, 17807}, {5577, 18602}, {5826, 19433}, {6086, 20300}, {6358, 21205},
+        {6642, 22152}, {6938, 23141}, {7248, 24173}, {7571, 25252}, {7909, 26380}, {8262, 27557},
+        {8631, 28786}, {9016, 30072}, {9419, 31413}, {9839, 32767}, {10278, 32767}, {10737, 32767},
+        {11216, 32767}, {11717, 32767}, {12240, 32767}, {12786, 32767}, {13356, 32767},
+        {13953, 32767}, {14576, 32767}, {15226, 32767}, {15906, 32767}, {16615, 32767},
+};
+
+// The three codes packed into each byte of MACE data take 3, 2, and 3 bits; each is read with its
+// own pair of tables.
+struct MaceTables {
+    const int16_t* index_adjustments;
+    const int16_t* steps;
+    int            codes;  // half the number of codes; the other half are negative.
+};
+const MaceTables kMaceTables[3] = {
+        {kMaceTable1, kMaceTable2[0], 4},
+        {kMaceTable3, kMaceTable4[0], 2},
+        {kMaceTable1, kMaceTable2[0], 4},
+};
+
+const size_t kMacePacketSamples = 6;
+
+// The state carried from one MACE code to the next, for a single channel.
+struct MaceChannel {
+    int16_t index    = 0;
+    int16_t factor   = 0;
+    int16_t prev2    = 0;
+    int16_t previous = 0;
+    int16_t level    = 0;
+};
+
+// Clips `value` to a 16-bit sample, as the Sound Manager does: -32768 itself becomes -32767.
+int16_t mace_clip(int32_t value) {
+    return (value > 32767) ? 32767 : (value < -32768) ? -32767 : value;
+}
+
+// MACE only keeps 8 bits of precision in its output; the high byte is repeated in the low one.
+int16_t mace_sample(int32_t value) { return (value & 0xff00) | ((value >> 8) & 0x00ff); }
+
+// Reads the step for `code` from `tables`, and adjusts the step index of `channel`.
+int16_t mace_step(MaceChannel* channel, uint8_t code, const MaceTables& tables) {
+    const int16_t* steps = tables.steps + (((channel->index & 0x7f0) >> 4) * tables.codes);
+    const int16_t  step  = (code < tables.codes) ? steps[code]
+                                                 : (-1 - steps[(2 * tables.codes) - code - 1]);
+    channel->index += tables.index_adjustments[code] - (channel->index >> 5);
+    if (channel->index < 0) {
+        channel->index = 0;
+    }
+    return step;
+}
+
+// Decodes one code of MACE 3:1 data into one sample.
+int16_t decode_mace3_code(MaceChannel* channel, uint8_t code, const MaceTables& tables) {
+    const int16_t current = mace_clip(mace_step(channel, code, tables) + channel->level);
+    channel->level        = current - (current >> 3);
+    return mace_sample(current);
+}
+
+// Decodes one code of MACE 6:1 data into two samples, interpolating between the previous ones.
+void decode_mace6_code(
+        MaceChannel* channel, uint8_t code, const MaceTables& tables, int16_t* out) {
+    int16_t current = mace_step(channel, code, tables);
+    if ((channel->previous ^ current) >= 0) {
+        channel->factor = std::min(channel->factor + 506, 32767);
+    } else if ((channel->factor - 314) < -32768) {
+        channel->factor = -32767;
+    } else {
+        channel->factor -= 314;
+    }
+    current        = mace_clip(current + channel->level);
+    channel->level = (current * channel->factor) >> 15;
+
+    current >>= 1;
+    const int32_t delta = (channel->prev2 - current) >> 2;
+    out[0]              = mace_sample(channel->previous + channel->prev2 - delta);
+    out[1]              = mace_sample(channel->previous + current + delta);
+    channel->prev2      = channel->previous;
+    channel->previous   = current;
+}
+
+// Decodes MACE 3:1 or 6:1 data into 16-bit big-endian samples.
 //
-// @param [in] in       The pn::file_view to read from.
-// @param [out] pointer Where to look for the block of sampled sound data.
-// @param [out] size    The size of the sampled sound data.
-// @param [out] rate    The sample rate of the sound in Hz, e.g. 44100, 22050, 11025.
-void read_snd_data_table(pn::file_view in, uint32_t* pointer, uint32_t* size, double* rate) {
-    uint32_t fixed_sample_rate;
-    uint32_t loop_start;
-    uint32_t loop_end;
-    uint8_t  encoding;
-    uint8_t  base_frequency;
+// A packet is 2 bytes of MACE 3:1 data, or 1 byte of MACE 6:1 data, and decodes to
+// kMacePacketSamples samples.  Unlike IMA4, packets don't carry their own state: each channel's
+// state runs from the start of the sound to the end.  As with IMA4, the packets of the channels
+// of a multi-channel sound are interleaved.
+std::shared_ptr<const vector<uint8_t>> decode_mace(
+        pn::data_view in, uint32_t channels, uint32_t packets, bool three_to_one) {
+    std::shared_ptr<vector<uint8_t>> out(
+            new vector<uint8_t>(size_t(packets) * kMacePacketSamples * channels * 2));
+    vector<MaceChannel> state(channels);
+    const uint8_t*      packet = in.data();
+    for (size_t i = 0; i < packets; ++i) {
+        for (size_t ch = 0; ch < channels; ++ch) {
+            int16_t samples[kMacePacketSamples];
+            if (three_to_one) {
+                for (size_t j = 0; j < 2; ++j) {
+                    const uint8_t byte     = *(packet++);
+                    const uint8_t codes[3] = {uint8_t(byte & 7), uint8_t((byte >> 3) & 3),
+                                              uint8_t(byte >> 5)};
+                    for (size_t k = 0; k < 3; ++k) {
+                        samples[(3 * j) + k] =
+                                decode_mace3_code(&state[ch], codes[k], kMaceTables[k]);
+                    }
+                }
+            } else {
+                const uint8_t byte     = *(packet++);
+                const uint8_t codes[3] = {uint8_t(byte >> 5), uint8_t((byte >> 3) & 3),
+                                          uint8_t(byte & 7)};
+                for (size_t k = 0; k < 3; ++k) {
+                    decode_mace6_code(&state[ch], codes[k], kMaceTables[k], samples + (2 * k));
+                }
+            }
+
+            uint8_t* frame = out->data() + (2 * ((i * kMacePacketSamples * channels) + ch));
+            for (size_t k = 0; k < kMacePacketSamples; ++k) {
+                uint8_t* sample = frame + (2 * k * channels);
+                sample[0]       = uint16_t(samples[k]) >> 8;
+                sample[1]       = uint16_t(samples[k]);
+            }
+        }
+    }
+    return out;
+}
 
-    in.read(pointer, size, &fixed_sample_rate, &loop_start, &loop_end, &encoding, &base_frequency)
-            .check();
-    *rate = fixed_sample_rate / 65536.0;
+// Reads a compressed sound header and decodes its samples.
+//
+// @param [in] in       The content of the 'snd ' resource.
+// @param [in] offset   The offset of the sample data within `in`, less the size of the header.
+// @param [in] header   The compressed header.
+// @param [out] sound   Receives the decoded samples.
+void read_compressed_sound(
+        pn::data_view in, uint64_t offset, const CompressedSoundHeaderRecord& header,
+        Sound* sound) {
+    const uint32_t packets        = header.num_frames;
+    const uint32_t format         = header.format;
+    const int16_t  compression_id = header.compression_id;
+
+    if (format == kIma4Format) {
+        pn::data_view data = sample_data(
+                in, offset + sizeof(CompressedSoundHeaderRecord),
+                uint64_t(packets) * sound->channels * kIma4PacketSize);
+        sound->sample_bits = 16;
+        sound->decoded     = decode_ima4(data, sound->channels, packets);
+        sound->samples = pn::data_view{sound->decoded->data(), int(sound->decoded->size())};
+    } else if ((format == kMace3Format) || (format == kMace6Format) ||
+               (compression_id == kThreeToOne) || (compression_id == kSixToOne)) {
+        // An explicit format takes precedence over the legacy compression ID.
+        const bool three_to_one = (format == kMace3Format) ||
+                                  ((format != kMace6Format) && (compression_id == kThreeToOne));
+        pn::data_view data = sample_data(
+                in, offset + sizeof(CompressedSoundHeaderRecord),
+                uint64_t(packets) * sound->channels * (three_to_one ? 2 : 1));
+        sound->sample_bits = 16;
+        sound->decoded     = decode_mace(data, sound->channels, packets, three_to_one);
+        sound->samples = pn::data_view{sound->decoded->data(), int(sound->decoded->size())};
+    } else {
+        throw std::runtime_error(
+                pn::format("unsupported 'snd ' compression format 0x{0}", hex(format, 8))
+                        .c_str());
+    }
 }
 
-// Reads the samples for a sound into a JSON array.
+// Reads a sound header, and the samples it refers to.
 //
-// @param [in] in       The pn::file_view to read from.
-// @param [in] sample_count The number of samples to read.
-// @param [out] samples The array to read the samples into.
-void read_snd_samples(pn::file_view in, uint32_t sample_count, vector<uint8_t>* samples) {
-    for (uint32_t i : range(sample_count)) {
-        static_cast<void>(i);
-        uint8_t sample;
-        in.read(&sample).check();
-        samples->push_back(sample);
+// The standard, extended, and compressed variants of the header share their first 22 bytes, and
+// the `encode` byte at offset 20 says which variant it is.  loop_start, loop_end, and
+// base_frequency are discarded.
+//
+// @param [in] in       The content of the 'snd ' resource.
+// @param [in] offset   The offset of the sound header within `in`.
+// @param [out] sound   Receives the format and samples of the sound.
+void read_sound_header(pn::data_view in, uint64_t offset, Sound* sound) {
+    const SoundHeaderRecord& header   = overlay<SoundHeaderRecord>(in, offset);
+    const uint32_t           pointer  = header.sample_ptr;
+    const uint32_t           length   = header.length;
+    const uint8_t            encoding = header.encode;
+    sound->sample_rate                = header.sample_rate / 65536.0;
+
+    switch (encoding) {
+        case STANDARD_SOUND_HEADER: {
+            // `length` is the number of samples, which are mono and 8-bit.
+            sound->channels    = 1;
+            sound->sample_bits = 8;
+            sound->samples =
+                    sample_data(in, offset + sizeof(SoundHeaderRecord) + pointer, length);
+            break;
+        }
+
+        case EXTENDED_SOUND_HEADER: {
+            // `length` is the number of channels.
+            const ExtendedSoundHeaderRecord& extended =
+                    overlay<ExtendedSoundHeaderRecord>(in, offset);
+            const uint32_t frames      = extended.num_frames;
+            const uint16_t sample_size = extended.sample_size;
+            if ((sample_size != 8) && (sample_size != 16)) {
+                throw std::runtime_error(
+                        pn::format("unsupported 'snd ' sample size {0}", sample_size).c_str());
+            }
+            sound->channels    = length;
+            sound->sample_bits = sample_size;
+            sound->samples     = sample_data(
+                    in, offset + sizeof(ExtendedSoundHeaderRecord) + pointer,
+                    uint64_t(frames) * length * (sample_size / 8));
+            break;
+        }
+
+        case COMPRESSED_SOUND_HEADER: {
+            sound->channels = length;
+            read_compressed_sound(
+                    in, offset + pointer, overlay<CompressedSoundHeaderRecord>(in, offset),
+                    sound);
+            break;
+        }
+
+        default: {
+            throw std::runtime_error(
+                    pn::format("unknown 'snd ' encoding {0}", encoding).c_str());
+        }
+    }
+    if (sound->channels == 0) {
+        throw std::runtime_error("'snd ' resource has no channels");
     }
 }
 
 }  // namespace
 
-Sound::Sound(pn::data_view in) {
-    pn::file header = in.open();
-    header.read(&fmt).check();
+SoundList::SoundList(pn::data_view in) {
+    uint64_t pos = 2;
+    fmt          = overlay<be<uint16_t>>(in);
     if (fmt == 1) {
-        read_snd_format_1_header(header);
+        read_snd_format_1_header(in, &pos);
     } else if (fmt == 2) {
-        read_snd_format_2_header(header);
+        read_snd_format_2_header(in, &pos);
     } else {
         throw std::runtime_error(pn::format("unknown 'snd ' format '{0}'", fmt).c_str());
     }
 
-    uint16_t command_count;
-    header.read(&command_count).check();
-    if (command_count != 1) {
-        throw std::runtime_error(
-                pn::format("can only handle 1 command; {0} found", command_count).c_str());
+    const uint16_t command_count = overlay<be<uint16_t>>(in, pos);
+    pos += 2;
+    vector<uint32_t> offsets;
+    for (uint16_t i : range(command_count)) {
+        static_cast<void>(i);
+        const SoundCommandRecord& record  = overlay<SoundCommandRecord>(in, pos);
+        const uint16_t            command = record.command;
+        const uint32_t            offset  = record.param2;
+        pos += sizeof(SoundCommandRecord);
+        if (!(command & DATA_POINTER_FLAG)) {
+            continue;
+        }
+        switch (command & ~DATA_POINTER_FLAG) {
+            case SOUND_CMD:
+            case BUFFER_CMD: break;
+            default: continue;
+        }
+
+        // A soundCmd which installs a sound is usually followed by a bufferCmd which plays the
+        // same one, so only the first command referring to each header makes a track.
+        if (std::find(offsets.begin(), offsets.end(), offset) != offsets.end()) {
+            continue;
+        }
+        offsets.push_back(offset);
+        tracks.emplace_back();
+        tracks.back().fmt = fmt;
+        read_sound_header(in, offset, &tracks.back());
     }
+}
 
-    uint16_t command;
-    uint16_t zero;
-    uint32_t offset;
-    read_snd_command(header, &command, &zero, &offset);
-    if (command != 0x8051) {
-        throw std::runtime_error(
-                pn::format("can only handle bufferCmd; 0x{0} found", hex(command, 4)).c_str());
+Sound::Sound() : fmt(0), channels(0), sample_bits(0), sample_rate(0) {}
+
+Sound::Sound(pn::data_view in) {
+    SoundList list(in);
+    if (list.tracks.empty()) {
+        throw std::runtime_error("'snd ' resource has no sampled sound");
     }
-    if (zero != 0) {
-        throw std::runtime_error(pn::format("param1 must be zero; {0} found", zero).c_str());
+    *this = list.tracks[0];
+    if (list.tracks.size() == 1) {
+        return;
     }
 
-    pn::file sound = in.slice(offset).open();
-    uint32_t pointer;
-    uint32_t sample_count;
-    read_snd_data_table(sound, &pointer, &sample_count, &sample_rate);
-    channels    = 1;
-    sample_bits = 8;
-
-    pn::file sample = in.slice(offset + 22 + pointer, sample_count).open();
-    read_snd_samples(sample, sample_count, &samples);
+    size_t size = 0;
+    for (const Sound& track : list.tracks) {
+        if ((track.channels != channels) || (track.sample_bits != sample_bits) ||
+            (track.sample_rate != sample_rate)) {
+            throw std::runtime_error("can't concatenate sounds with different sample formats");
+        }
+        size += track.samples.size();
+    }
+    std::shared_ptr<vector<uint8_t>> concatenated(new vector<uint8_t>);
+    concatenated->reserve(size);
+    for (const Sound& track : list.tracks) {
+        concatenated->insert(
+                concatenated->end(), track.samples.data(),
+                track.samples.data() + track.samples.size());
+    }
+    decoded = concatenated;
+    samples = pn::data_view{decoded->data(), int(decoded->size())};
 }
 
+uint32_t Sound::frames() const { return samples.size() / (channels * (sample_bits / 8)); }
+
 namespace {
 
 // Write `d` as an IEEE 754 80-bit floating point (extended precision) number.
@@ -169,15 +619,20 @@ void write_float80(pn::file_view out, double d) {
             .check();
 }
 
-// Write an IFF chunk.
+// Write the header of an IFF chunk.
 //
-// @param [out] out     The pn::file_view to write the chunk to.
+// The content of the chunk, `size` bytes long, must be written immediately afterwards.
+//
+// @param [out] out     The pn::file_view to write the chunk header to.
 // @param [in] name     A four-byte chunk name.
-// @param [in] data     The content of the chunk.
-void write_chunk(pn::file_view out, const char* name, const pn::data_view& data) {
-    out.write<pn::string_view, uint32_t, pn::data_view>({name, 4}, data.size(), data).check();
+// @param [in] size     The size of the content of the chunk.
+void write_chunk_header(pn::file_view out, const char* name, uint32_t size) {
+    out.write<pn::string_view, uint32_t>({name, 4}, size).check();
 }
 
+const uint32_t kCommSize       = 18;
+const uint32_t kSsndHeaderSize = 8;
+
 // Write an AIFF "COMM" chunk.
 //
 // The "COMM" (common) chunk specifies how to interpret samples from the "SSND" chunk.
@@ -185,57 +640,177 @@ void write_chunk(pn::file_view out, const char* name, const pn::data_view& data)
 // @param [out] out     The pn::file_view to write the chunk to.
 // @param [in] info     Contains the information to write.
 void write_comm(pn::file_view out, const Sound& sound) {
-    pn::data comm;
-    pn::file f = comm.open("w");
-    f.write<int16_t, uint32_t, int16_t>(sound.channels, sound.samples.size(), sound.sample_bits)
+    write_chunk_header(out, "COMM", kCommSize);
+    out.write<int16_t, uint32_t, int16_t>(sound.channels, sound.frames(), sound.sample_bits)
             .check();
-    write_float80(f, sound.sample_rate);
+    write_float80(out, sound.sample_rate);
+}
 
-    write_chunk(out, "COMM", comm);
+// Converts unsigned 8-bit samples to signed ones.
+//
+// Subtracting 0x80 from a byte is the same as flipping its high bit, so this works on 8 samples
+// at a time as a single 64-bit XOR.
+void flip_sign_bits(const uint8_t* in, uint8_t* out, size_t size) {
+    const uint64_t kHighBits = 0x8080808080808080ull;
+    size_t         i         = 0;
+    for (; (i + 8) <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, in + i, 8);
+        word ^= kHighBits;
+        memcpy(out + i, &word, 8);
+    }
+    for (; i < size; ++i) {
+        out[i] = in[i] ^ 0x80;
+    }
+}
+
+// Swaps the bytes of 16-bit samples, converting between big- and little-endian.
+//
+// As with flip_sign_bits(), this works on 4 samples at a time within a 64-bit word.
+void swap_bytes(const uint8_t* in, uint8_t* out, size_t size) {
+    const uint64_t kLowBytes = 0x00ff00ff00ff00ffull;
+    size_t         i         = 0;
+    for (; (i + 8) <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, in + i, 8);
+        word = ((word >> 8) & kLowBytes) | ((word & kLowBytes) << 8);
+        memcpy(out + i, &word, 8);
+    }
+    for (; (i + 2) <= size; i += 2) {
+        out[i]     = in[i + 1];
+        out[i + 1] = in[i];
+    }
+}
+
+// Writes `in` to `out`, passing it through `convert` a fixed-size buffer at a time, so no copy of
+// the whole sound is made.  Buffers hold a whole number of 16-bit samples.
+void write_converted(
+        pn::file_view out, pn::data_view in,
+        void (*convert)(const uint8_t* in, uint8_t* out, size_t size)) {
+    uint8_t        buffer[4096];
+    const uint8_t* samples = in.data();
+    size_t         size    = in.size();
+    while (size > 0) {
+        size_t n = std::min(size, sizeof(buffer));
+        convert(samples, buffer, n);
+        out.write(pn::data_view{buffer, static_cast<int>(n)}).check();
+        samples += n;
+        size -= n;
+    }
 }
 
 // Write an AIFF "SSND" chunk.
 //
-// The "SSND" (sampled sound) chunk is an array of samples from the sound.
+// The "SSND" (sampled sound) chunk is an array of samples from the sound.  AIFF samples are
+// signed, so 8-bit samples are converted; 16-bit samples are already signed and big-endian.
 //
 // @param [out] out     The pn::file_view to write the chunk to.
 // @param [in] sound    Contains the samples to write.
 void write_ssnd(pn::file_view out, const Sound& sound) {
-    pn::data ssnd;
-    pn::file f = ssnd.open("w");
-    f.write<uint32_t, uint32_t>(0, 0).check();
-    for (uint8_t sample : sound.samples) {
-        f.write<int8_t>(sample - 0x80).check();
+    write_chunk_header(out, "SSND", kSsndHeaderSize + sound.samples.size());
+    out.write<uint32_t, uint32_t>(0, 0).check();
+    if (sound.sample_bits == 8) {
+        write_converted(out, sound.samples, flip_sign_bits);
+    } else {
+        out.write(sound.samples).check();
     }
-
-    write_chunk(out, "SSND", ssnd);
 }
 
-// Write an AIFF file.
+const uint32_t kFmtSize = 16;
+
+// Write a WAV "fmt " chunk.
 //
-// IFF files (including AIFF files) are structured as a hierarchy of chunks.  Given `sound`, which
-// contains sound data, this function writes the "FORM" chunk which is at the top level of every
-// IFF file, which consists of the identifier "AIFF", followed by the two chunks, "COMM" and
-// "SSND", which define the content of the sound.
+// The "fmt " chunk is the RIFF counterpart of AIFF's "COMM" chunk.  WAV has no way to express a
+// fractional sample rate, so the rate is rounded to the nearest integer.
 //
-// @param [out] out     The pn::file_view to write the sound data to.
-// @param [in] sound    Contains the sound to write.
-void write_form(pn::file_view out, const Sound& sound) {
-    pn::data form;
-    pn::file f = form.open("w");
-    f.write(pn::string_view{"AIFF", 4}).check();
-    write_comm(f, sound);
-    write_ssnd(f, sound);
-
-    write_chunk(out, "FORM", form);
+// @param [out] out     The pn::file_view to write the chunk to.
+// @param [in] sound    Contains the information to write.
+void write_fmt(pn::file_view out, const Sound& sound) {
+    const uint32_t rate        = lround(sound.sample_rate);
+    const uint16_t block_align = sound.channels * ((sound.sample_bits + 7) / 8);
+    out.write(pn::string_view{"fmt ", 4}).check();
+    write_le32(out, kFmtSize);
+    write_le16(out, 1);  // WAVE_FORMAT_PCM
+    write_le16(out, sound.channels);
+    write_le32(out, rate);
+    write_le32(out, rate * block_align);
+    write_le16(out, block_align);
+    write_le16(out, sound.sample_bits);
 }
 
 }  // namespace
 
+void write_aiff(pn::file_view out, const Sound& sound) {
+    // The "FORM" chunk is at the top level of every IFF file (including AIFF files), and holds the
+    // identifier "AIFF", followed by the two chunks, "COMM" and "SSND", which define the content
+    // of the sound.  The sizes of all three are known in advance, so each chunk can be written
+    // directly to `out` without first being assembled in memory.
+    const uint32_t ssnd_size = kSsndHeaderSize + sound.samples.size();
+    write_chunk_header(out, "FORM", 4 + (8 + kCommSize) + (8 + ssnd_size));
+    out.write(pn::string_view{"AIFF", 4}).check();
+    write_comm(out, sound);
+    write_ssnd(out, sound);
+}
+
 pn::data aiff(const Sound& sound) {
     pn::data d;
-    write_form(d.open("w"), sound);
+    write_aiff(d.open("w"), sound);
     return d;
 }
 
+void write_wav(pn::file_view out, const Sound& sound) {
+    // Like AIFF, a WAV file is a tree of chunks: a "RIFF" chunk holding the identifier "WAVE",
+    // followed by the "fmt " and "data" chunks.  Unlike AIFF, integers are little-endian, and
+    // chunks are padded to an even size.  8-bit WAV samples are unsigned, like those of a 'snd '
+    // resource, so they are written without conversion; 16-bit samples are byte-swapped.
+    const uint32_t data_size = sound.samples.size();
+    const uint32_t padding   = data_size % 2;
+    out.write(pn::string_view{"RIFF", 4}).check();
+    write_le32(out, 4 + (8 + kFmtSize) + (8 + data_size + padding));
+    out.write(pn::string_view{"WAVE", 4}).check();
+    write_fmt(out, sound);
+    out.write(pn::string_view{"data", 4}).check();
+    write_le32(out, data_size);
+    write_pcm(out, sound);
+    if (padding) {
+        out.write<uint8_t>(0).check();
+    }
+}
+
+pn::data wav(const Sound& sound) {
+    pn::data d;
+    write_wav(d.open("w"), sound);
+    return d;
+}
+
+void write_pcm(pn::file_view out, const Sound& sound) {
+    if (sound.sample_bits == 8) {
+        out.write(sound.samples).check();
+    } else {
+        write_converted(out, sound.samples, swap_bytes);
+    }
+}
+
+void write_pcm16(pn::file_view out, const Sound& sound) {
+    if (sound.sample_bits == 16) {
+        write_converted(out, sound.samples, swap_bytes);
+        return;
+    }
+
+    // Widen each unsigned 8-bit sample into the high byte of a signed 16-bit one.
+    uint8_t        buffer[4096];
+    const uint8_t* samples = sound.samples.data();
+    size_t         size    = sound.samples.size();
+    while (size > 0) {
+        size_t n = std::min(size, sizeof(buffer) / 2);
+        for (size_t i = 0; i < n; ++i) {
+            buffer[2 * i]     = 0;
+            buffer[2 * i + 1] = samples[i] ^ 0x80;
+        }
+        out.write(pn::data_view{buffer, static_cast<int>(2 * n)}).check();
+        samples += n;
+        size -= n;
+    }
+}
+
 }  // namespace rezin
@@ -0,0 +1,20 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#include <rezin/source.hpp>
+
+#include <rezin/resource.hpp>
+
+namespace rezin {
+
+std::unique_ptr<ResourceFork> Source::open(size_t index, const Options& options) const {
+    pn::data_view rsrc = data(index);
+    if (!name(index).empty() && (rsrc.size() == 0)) {
+        return nullptr;
+    }
+    return std::unique_ptr<ResourceFork>(new ResourceFork(rsrc, options));
+}
+
+}  // namespace rezin
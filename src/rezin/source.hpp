@@ -6,7 +6,9 @@
 #ifndef REZIN_SOURCE_HPP_
 #define REZIN_SOURCE_HPP_
 
-#include <pn/fwd>
+#include <stddef.h>
+#include <memory>
+#include <pn/string>
 
 namespace rezin {
 
@@ -16,8 +18,27 @@ class ResourceFork;
 class Source {
   public:
     virtual ~Source() {}
-    virtual void          load()       = 0;
-    virtual pn::data_view data() const = 0;
+    virtual void load() = 0;
+
+    // Most sources hold a single resource fork.  Containers, such as archives, hold one for each
+    // file within them, and override size() and name() to list them.
+    virtual size_t          size() const { return 1; }
+    virtual pn::string_view name(size_t index) const { return ""; }
+
+    // Returns the content of fork `index`, which must be less than size().
+    //
+    // Sources which decode forks lazily must allow this to be called from several threads at
+    // once, for different forks.
+    virtual pn::data_view data(size_t index) const = 0;
+
+    // Parses fork `index`, or returns nullptr if it is a named fork with no content: files within
+    // an archive need not have resource forks.  By default, the fork is parsed from data(); sources
+    // which can read a fork piecemeal override this to avoid holding all of it in memory.
+    virtual std::unique_ptr<ResourceFork> open(size_t index, const Options& options) const;
+
+    // Releases anything held for fork `index` by data() or open(), once the fork is no longer
+    // used.  Called once for each fork of a container, even if open() failed.
+    virtual void close(size_t index) const {}
 };
 
 }  // namespace rezin
@@ -19,7 +19,7 @@ void AppleSingleSource::load() {
     _apple_single.reset(new AppleSingle(_file->data()));
 }
 
-pn::data_view AppleSingleSource::data() const {
+pn::data_view AppleSingleSource::data(size_t index) const {
     return _apple_single->at(AppleSingle::RESOURCE_FORK);
 }
 
@@ -19,7 +19,7 @@ class AppleSingleSource : public Source {
     ~AppleSingleSource();
 
     void          load() override;
-    pn::data_view data() const override;
+    pn::data_view data(size_t index) const override;
 
   private:
     const pn::string                  _path;
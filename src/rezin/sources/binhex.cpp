@@ -0,0 +1,25 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#include <rezin/sources/binhex.hpp>
+
+#include <rezin/binhex.hpp>
+#include <sfz/sfz.hpp>
+
+namespace rezin {
+
+BinHexSource::BinHexSource(pn::string_view path) : _path(path.copy()) {}
+
+BinHexSource::~BinHexSource() {}
+
+void BinHexSource::load() {
+    // The text is only needed while it is decoded.
+    sfz::mapped_file file(_path);
+    _binhex.reset(new BinHex(file.data()));
+}
+
+pn::data_view BinHexSource::data(size_t index) const { return _binhex->resource_fork(); }
+
+}  // namespace rezin
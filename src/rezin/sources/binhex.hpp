@@ -0,0 +1,34 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#ifndef REZIN_SOURCES_BINHEX_HPP_
+#define REZIN_SOURCES_BINHEX_HPP_
+
+#include <rezin/source.hpp>
+#include <sfz/sfz.hpp>
+
+namespace rezin {
+
+class BinHex;
+
+class BinHexSource : public Source {
+  public:
+    BinHexSource(pn::string_view path);
+    ~BinHexSource();
+
+    void          load() override;
+    pn::data_view data(size_t index) const override;
+
+  private:
+    const pn::string        _path;
+    std::unique_ptr<BinHex> _binhex;
+
+    BinHexSource(const BinHexSource&) = delete;
+    BinHexSource& operator=(const BinHexSource&) = delete;
+};
+
+}  // namespace rezin
+
+#endif  // REZIN_SOURCES_BINHEX_HPP_
@@ -0,0 +1,77 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#include <rezin/sources/detect.hpp>
+
+#include <algorithm>
+#include <rezin/apple-single.hpp>
+#include <rezin/binhex.hpp>
+#include <rezin/mac-binary.hpp>
+#include <rezin/resource.hpp>
+
+namespace rezin {
+
+ForkFormat detect_format(pn::data_view header, uint64_t size) {
+    // MacBinary is checked before flat resource forks: the first byte of a flat fork is the high
+    // byte of the offset of its data, which is always 0, but so is the second byte, whereas in
+    // MacBinary the second byte is the nonzero length of the file's name.
+    if (AppleSingle::has_magic(header)) {
+        return APPLE_SINGLE;
+    } else if (BinHex::has_header(header)) {
+        return BINHEX;
+    } else if (MacBinary::has_header(header, size)) {
+        return MAC_BINARY;
+    } else if (ResourceFork::has_header(header, size)) {
+        return FLAT_FILE;
+    }
+    return NOT_A_FORK;
+}
+
+ForkFile::ForkFile(ForkFormat format, pn::data_view data) {
+    switch (format) {
+        case APPLE_SINGLE: {
+            AppleSingle apple_single(data);
+            if (apple_single.contains(AppleSingle::RESOURCE_FORK)) {
+                _resource_fork = apple_single.at(AppleSingle::RESOURCE_FORK);
+            }
+        } break;
+
+        case MAC_BINARY: _resource_fork = MacBinary(data).resource_fork(); break;
+
+        case BINHEX:
+            _binhex.reset(new BinHex(data));
+            _resource_fork = _binhex->resource_fork();
+            break;
+
+        case FLAT_FILE: _resource_fork = data; break;
+
+        case NOT_A_FORK: throw std::runtime_error("unrecognized file format");
+    }
+}
+
+ForkFile::~ForkFile() {}
+
+pn::data_view ForkFile::resource_fork() const { return _resource_fork; }
+
+DetectedFileSource::DetectedFileSource(pn::string_view path) : _path(path.copy()) {}
+
+DetectedFileSource::~DetectedFileSource() {}
+
+void DetectedFileSource::load() {
+    _file.reset(new sfz::mapped_file(_path));
+    pn::data_view data   = _file->data();
+    pn::data_view header = data.slice(0, std::min<int>(data.size(), kDetectSize));
+    _fork.reset(new ForkFile(detect_format(header, data.size()), data));
+}
+
+pn::data_view DetectedFileSource::data(size_t index) const {
+    pn::data_view rsrc = _fork->resource_fork();
+    if (rsrc.size() == 0) {
+        throw std::runtime_error("file has no resource fork");
+    }
+    return rsrc;
+}
+
+}  // namespace rezin
@@ -0,0 +1,78 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#ifndef REZIN_SOURCES_DETECT_HPP_
+#define REZIN_SOURCES_DETECT_HPP_
+
+#include <memory>
+#include <rezin/source.hpp>
+#include <sfz/sfz.hpp>
+
+namespace rezin {
+
+class BinHex;
+
+// The formats a file can hold a resource fork in.
+enum ForkFormat {
+    NOT_A_FORK,
+    APPLE_SINGLE,  // AppleSingle or AppleDouble.
+    MAC_BINARY,
+    BINHEX,
+    FLAT_FILE,
+};
+
+// The number of bytes from the start of a file that detect_format() needs.
+const size_t kDetectSize = 256;
+
+// Tells which format a file holds a resource fork in, from its first bytes.
+//
+// @param [in] header   The first kDetectSize bytes of the file, or all of it if it is shorter.
+// @param [in] size     The size of the whole file.
+// @returns             The format of the file, or NOT_A_FORK if it is in none of them.
+ForkFormat detect_format(pn::data_view header, uint64_t size);
+
+// A file holding a resource fork, in any of the formats detect_format() recognizes.
+class ForkFile {
+  public:
+    // @param [in] format   The format of `data`.  Must not be NOT_A_FORK.
+    // @param [in] data     The content of the file.  The block of memory must remain valid for the
+    //                      lifetime of this object: except in BinHex files, which are decoded, the
+    //                      resource fork is a slice of it.
+    // @throws std::runtime_error    If the file could not be parsed.
+    ForkFile(ForkFormat format, pn::data_view data);
+    ~ForkFile();
+
+    // @returns             The resource fork, or an empty block if the file has none.
+    pn::data_view resource_fork() const;
+
+  private:
+    pn::data_view           _resource_fork;
+    std::unique_ptr<BinHex> _binhex;
+
+    ForkFile(const ForkFile&) = delete;
+    ForkFile& operator=(const ForkFile&) = delete;
+};
+
+// Reads the resource fork of a file in any format detect_format() recognizes.
+class DetectedFileSource : public Source {
+  public:
+    DetectedFileSource(pn::string_view path);
+    ~DetectedFileSource();
+
+    void          load() override;
+    pn::data_view data(size_t index) const override;
+
+  private:
+    const pn::string                  _path;
+    std::unique_ptr<sfz::mapped_file> _file;
+    std::unique_ptr<ForkFile>         _fork;
+
+    DetectedFileSource(const DetectedFileSource&) = delete;
+    DetectedFileSource& operator=(const DetectedFileSource&) = delete;
+};
+
+}  // namespace rezin
+
+#endif  // REZIN_SOURCES_DETECT_HPP_
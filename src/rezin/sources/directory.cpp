@@ -0,0 +1,217 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#include <rezin/sources/directory.hpp>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <rezin/options.hpp>
+#include <rezin/resource.hpp>
+#include <rezin/sources/detect.hpp>
+
+using std::unique_ptr;
+
+namespace rezin {
+
+namespace {
+
+// Reads the first bytes of the file at `path` to detect its format, and sets `size` to the size
+// of the file.
+//
+// @throws std::runtime_error    If the file could not be read.
+ForkFormat probe(pn::string_view path, uint64_t* size) {
+    int fd = ::open(path.copy().c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(strerror(errno));
+    }
+    struct stat st;
+    uint8_t     header[kDetectSize];
+    ssize_t     header_size = -1;
+    if (fstat(fd, &st) == 0) {
+        header_size = read(fd, header, sizeof(header));
+    }
+    const int error = errno;
+    ::close(fd);
+    if (header_size < 0) {
+        throw std::runtime_error(strerror(error));
+    }
+
+    *size = st.st_size;
+    return detect_format(pn::data_view{header, static_cast<int>(header_size)}, *size);
+}
+
+}  // namespace
+
+// `format` is set by open(), and reset by close(); while it is set, the fork holds budget for
+// `size` bytes.
+struct DirectorySource::Fork {
+    pn::string                   path;
+    pn::string                   name;
+    ForkFormat                   format;
+    uint64_t                     size;
+    unique_ptr<sfz::mapped_file> file;
+    unique_ptr<ForkFile>         fork_file;
+};
+
+// Limits the number of files mapped at once, and their total size.
+//
+// Forks take their turns in order of index, whether or not they map anything, so a later fork
+// never holds budget that an earlier one is waiting for: forks are used and closed in order, so
+// the earliest fork holding budget is always the next to release it.
+class DirectorySource::Budget {
+  public:
+    Budget() : _turn(0), _files(0), _bytes(0) {}
+
+    // Waits for the turn of fork `index`, then, if `map`, for room to map `size` bytes.
+    void acquire(size_t index, bool map, uint64_t size, const Options& options) {
+        const uint64_t               max_bytes = uint64_t(options.max_mapped) << 20;
+        std::unique_lock<std::mutex> lock(_mutex);
+        _changed.wait(lock, [&]() {
+            return (_turn == index) &&
+                   (!map || (_files == 0) ||
+                    ((_files < options.max_open) && ((_bytes + size) <= max_bytes)));
+        });
+        if (map) {
+            ++_files;
+            _bytes += size;
+        }
+        ++_turn;
+        _changed.notify_all();
+    }
+
+    void release(uint64_t size) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        --_files;
+        _bytes -= size;
+        _changed.notify_all();
+    }
+
+  private:
+    std::mutex              _mutex;
+    std::condition_variable _changed;
+    size_t                  _turn;
+    int                     _files;
+    uint64_t                _bytes;
+};
+
+DirectorySource::DirectorySource(pn::string_view path)
+        : _path(path.copy()), _budget(new Budget) {}
+
+DirectorySource::~DirectorySource() {}
+
+void DirectorySource::load() {
+    struct stat st;
+    if (stat(_path.c_str(), &st) != 0) {
+        throw std::runtime_error(pn::format("{0}: {1}", _path, strerror(errno)).c_str());
+    } else if (!S_ISDIR(st.st_mode)) {
+        throw std::runtime_error(pn::format("{0}: not a directory", _path).c_str());
+    }
+    list(_path, "");
+}
+
+// Lists the files within `dir`, sorted by name, and recursively those within its subdirectories.
+// Symbolic links are not followed.  Subdirectories which can't be read are skipped with a warning.
+void DirectorySource::list(pn::string_view dir, pn::string_view prefix) {
+    std::vector<pn::string> names;
+    DIR*                    d = opendir(dir.copy().c_str());
+    if (!d) {
+        pn::format(stderr, "warning: {0}: {1}\n", dir, strerror(errno));
+        return;
+    }
+    while (struct dirent* entry = readdir(d)) {
+        if ((strcmp(entry->d_name, ".") != 0) && (strcmp(entry->d_name, "..") != 0)) {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end(), [](const pn::string& x, const pn::string& y) {
+        return pn::string_view{x} < pn::string_view{y};
+    });
+
+    for (const pn::string& name : names) {
+        pn::string path = dir.copy();
+        path += "/";
+        path += name;
+        pn::string rel = prefix.copy();
+        if (!rel.empty()) {
+            rel += "/";
+        }
+        rel += name;
+
+        struct stat st;
+        if (lstat(path.c_str(), &st) != 0) {
+            continue;
+        } else if (S_ISDIR(st.st_mode)) {
+            list(path, rel);
+        } else if (S_ISREG(st.st_mode)) {
+            _forks.emplace_back(
+                    new Fork{std::move(path), std::move(rel), NOT_A_FORK, 0, nullptr, nullptr});
+        }
+    }
+}
+
+size_t DirectorySource::size() const { return _forks.size(); }
+
+pn::string_view DirectorySource::name(size_t index) const { return _forks[index]->name; }
+
+pn::data_view DirectorySource::data(size_t index) const {
+    Fork& fork = *_forks[index];
+    if (!fork.fork_file) {
+        fork.file.reset(new sfz::mapped_file(fork.path));
+        fork.fork_file.reset(new ForkFile(fork.format, fork.file->data()));
+    }
+    return fork.fork_file->resource_fork();
+}
+
+unique_ptr<ResourceFork> DirectorySource::open(size_t index, const Options& options) const {
+    Fork& fork = *_forks[index];
+
+    // Files are probed before taking a turn, so that they can be probed in parallel.  The turn is
+    // taken even if probing fails, so as not to hold up the forks after this one.
+    std::exception_ptr error;
+    try {
+        fork.format = probe(fork.path, &fork.size);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    _budget->acquire(index, fork.format != NOT_A_FORK, fork.size, options);
+    if (error) {
+        std::rethrow_exception(error);
+    } else if (fork.format == NOT_A_FORK) {
+        return nullptr;
+    }
+
+    try {
+        pn::data_view rsrc = data(index);
+        if (rsrc.size() == 0) {
+            close(index);
+            return nullptr;
+        }
+        return unique_ptr<ResourceFork>(new ResourceFork(rsrc, options));
+    } catch (...) {
+        close(index);
+        throw;
+    }
+}
+
+void DirectorySource::close(size_t index) const {
+    Fork& fork = *_forks[index];
+    if (fork.format != NOT_A_FORK) {
+        fork.fork_file.reset();
+        fork.file.reset();
+        fork.format = NOT_A_FORK;
+        _budget->release(fork.size);
+    }
+}
+
+}  // namespace rezin
@@ -0,0 +1,53 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#ifndef REZIN_SOURCES_DIRECTORY_HPP_
+#define REZIN_SOURCES_DIRECTORY_HPP_
+
+#include <memory>
+#include <rezin/source.hpp>
+#include <sfz/sfz.hpp>
+#include <vector>
+
+namespace rezin {
+
+// Reads the resource forks of every file within a directory tree.
+//
+// The tree is listed once, when loaded.  Each file is only opened when its fork is requested,
+// which may happen on several threads at once: its first bytes are read to tell whether it holds
+// a resource fork in any format detect_format() recognizes, such as the "._" AppleDouble files
+// which macOS writes to foreign filesystems.  Other files are skipped.
+//
+// Files which do hold a fork are mapped until closed, within the limits of
+// `Options::max_open` and `Options::max_mapped`.
+class DirectorySource : public Source {
+  public:
+    DirectorySource(pn::string_view path);
+    ~DirectorySource();
+
+    void                          load() override;
+    size_t                        size() const override;
+    pn::string_view               name(size_t index) const override;
+    pn::data_view                 data(size_t index) const override;
+    std::unique_ptr<ResourceFork> open(size_t index, const Options& options) const override;
+    void                          close(size_t index) const override;
+
+  private:
+    struct Fork;
+    class Budget;
+
+    void list(pn::string_view dir, pn::string_view prefix);
+
+    const pn::string                   _path;
+    std::vector<std::unique_ptr<Fork>> _forks;
+    std::unique_ptr<Budget>            _budget;
+
+    DirectorySource(const DirectorySource&) = delete;
+    DirectorySource& operator=(const DirectorySource&) = delete;
+};
+
+}  // namespace rezin
+
+#endif  // REZIN_SOURCES_DIRECTORY_HPP_
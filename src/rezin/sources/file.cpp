@@ -13,6 +13,6 @@ FlatFileSource::FlatFileSource(pn::string_view path) : _path(path.copy()) {}
 
 void FlatFileSource::load() { _file.reset(new sfz::mapped_file(_path)); }
 
-pn::data_view FlatFileSource::data() const { return _file->data(); }
+pn::data_view FlatFileSource::data(size_t index) const { return _file->data(); }
 
 }  // namespace rezin
@@ -16,7 +16,7 @@ class FlatFileSource : public Source {
     FlatFileSource(pn::string_view path);
 
     void          load() override;
-    pn::data_view data() const override;
+    pn::data_view data(size_t index) const override;
 
   private:
     const pn::string                  _path;
@@ -0,0 +1,755 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#include <rezin/sources/hfs.hpp>
+
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <rezin/endian.hpp>
+#include <rezin/options.hpp>
+#include <rezin/resource.hpp>
+#include <tuple>
+
+using std::unique_ptr;
+using std::vector;
+
+namespace macroman = sfz::macroman;
+
+namespace rezin {
+
+namespace {
+
+const uint16_t kHfsSignature              = 0x4244;  // "BD"
+const uint16_t kHfsPlusSignature          = 0x482b;  // "H+"
+const uint16_t kHfsxSignature             = 0x4858;  // "HX"
+const uint16_t kDriverDescriptorSignature = 0x4552;  // "ER"
+const uint16_t kPartitionSignature        = 0x504d;  // "PM"
+const uint16_t kDiskCopySignature         = 0x0100;
+
+const uint64_t kVolumeHeaderOffset = 1024;
+const uint64_t kSectorSize         = 512;
+
+const uint32_t kRootFolderId = 2;
+const uint32_t kCatalogId    = 4;
+
+const uint8_t kDataFork     = 0x00;
+const uint8_t kResourceFork = 0xff;
+
+const uint8_t kLeafNode = 0xff;
+
+// Catalog record types.  HFS stores them in the high byte of the field, and HFS+ in the low byte.
+enum {
+    HFS_FOLDER_RECORD      = 0x0100,
+    HFS_FILE_RECORD        = 0x0200,
+    HFS_PLUS_FOLDER_RECORD = 0x0001,
+    HFS_PLUS_FILE_RECORD   = 0x0002,
+};
+
+struct DiskCopyHeader {
+    uint8_t      name[64];
+    be<uint32_t> data_size;
+    be<uint32_t> tag_size;
+    be<uint32_t> data_checksum;
+    be<uint32_t> tag_checksum;
+    uint8_t      disk_format;
+    uint8_t      format_byte;
+    be<uint16_t> signature;
+};
+static_assert(sizeof(DiskCopyHeader) == 84, "DiskCopyHeader must be 84 bytes");
+
+struct DriverDescriptor {
+    be<uint16_t> signature;
+    be<uint16_t> block_size;
+};
+
+struct PartitionEntry {
+    be<uint16_t> signature;
+    be<uint16_t> reserved;
+    be<uint32_t> map_size;
+    be<uint32_t> start;
+    be<uint32_t> size;
+    uint8_t      name[32];
+    uint8_t      type[32];
+};
+
+struct HfsExtent {
+    be<uint16_t> start;
+    be<uint16_t> count;
+};
+
+struct HfsPlusExtent {
+    be<uint32_t> start;
+    be<uint32_t> count;
+};
+
+struct MasterDirectoryBlock {
+    be<uint16_t> signature;
+    be<uint32_t> create_date;
+    be<uint32_t> modify_date;
+    be<uint16_t> attributes;
+    be<uint16_t> root_files;
+    be<uint16_t> bitmap_start;
+    be<uint16_t> next_allocation;
+    be<uint16_t> total_blocks;
+    be<uint32_t> block_size;
+    be<uint32_t> clump_size;
+    be<uint16_t> first_block;  // in sectors.
+    be<uint32_t> next_id;
+    be<uint16_t> free_blocks;
+    uint8_t      name[28];
+    be<uint32_t> backup_date;
+    be<uint16_t> backup_sequence;
+    be<uint32_t> write_count;
+    be<uint32_t> extents_clump_size;
+    be<uint32_t> catalog_clump_size;
+    be<uint16_t> root_folders;
+    be<uint32_t> file_count;
+    be<uint32_t> folder_count;
+    uint8_t      finder_info[32];
+    be<uint16_t> embedded_signature;
+    HfsExtent    embedded_extent;
+    be<uint32_t> extents_size;
+    HfsExtent    extents_extents[3];
+    be<uint32_t> catalog_size;
+    HfsExtent    catalog_extents[3];
+};
+static_assert(sizeof(MasterDirectoryBlock) == 162, "MasterDirectoryBlock must be 162 bytes");
+
+struct HfsPlusFork {
+    be<uint64_t>  size;
+    be<uint32_t>  clump_size;
+    be<uint32_t>  total_blocks;
+    HfsPlusExtent extents[8];
+};
+
+struct HfsPlusVolumeHeader {
+    be<uint16_t> signature;
+    be<uint16_t> version;
+    be<uint32_t> attributes;
+    be<uint32_t> last_mounted_version;
+    be<uint32_t> journal_info_block;
+    be<uint32_t> create_date;
+    be<uint32_t> modify_date;
+    be<uint32_t> backup_date;
+    be<uint32_t> checked_date;
+    be<uint32_t> file_count;
+    be<uint32_t> folder_count;
+    be<uint32_t> block_size;
+    be<uint32_t> total_blocks;
+    be<uint32_t> free_blocks;
+    be<uint32_t> next_allocation;
+    be<uint32_t> rsrc_clump_size;
+    be<uint32_t> data_clump_size;
+    be<uint32_t> next_id;
+    be<uint32_t> write_count;
+    be<uint64_t> encodings;
+    uint8_t      finder_info[32];
+    HfsPlusFork  allocation_file;
+    HfsPlusFork  extents_file;
+    HfsPlusFork  catalog_file;
+    HfsPlusFork  attributes_file;
+    HfsPlusFork  startup_file;
+};
+static_assert(sizeof(HfsPlusVolumeHeader) == 512, "HfsPlusVolumeHeader must be 512 bytes");
+
+struct NodeDescriptor {
+    be<uint32_t> next;
+    be<uint32_t> previous;
+    uint8_t      kind;
+    uint8_t      height;
+    be<uint16_t> records;
+    be<uint16_t> reserved;
+};
+
+struct HeaderRecord {
+    be<uint16_t> depth;
+    be<uint32_t> root;
+    be<uint32_t> leaf_records;
+    be<uint32_t> first_leaf;
+    be<uint32_t> last_leaf;
+    be<uint16_t> node_size;
+    be<uint16_t> max_key_size;
+    be<uint32_t> total_nodes;
+    be<uint32_t> free_nodes;
+};
+
+struct HfsExtentKey {
+    uint8_t      key_size;
+    uint8_t      fork_type;
+    be<uint32_t> id;
+    be<uint16_t> start;
+};
+
+struct HfsPlusExtentKey {
+    be<uint16_t> key_size;
+    uint8_t      fork_type;
+    uint8_t      pad;
+    be<uint32_t> id;
+    be<uint32_t> start;
+};
+
+struct HfsCatalogKey {
+    uint8_t      key_size;
+    uint8_t      reserved;
+    be<uint32_t> parent;
+    uint8_t      name_size;
+};
+
+struct HfsPlusCatalogKey {
+    be<uint16_t> key_size;
+    be<uint32_t> parent;
+    be<uint16_t> name_size;
+};
+
+struct HfsFolderRecord {
+    be<uint16_t> type;
+    be<uint16_t> flags;
+    be<uint16_t> valence;
+    be<uint32_t> id;
+};
+
+struct HfsFileRecord {
+    be<uint16_t> type;
+    uint8_t      flags;
+    uint8_t      file_type;
+    uint8_t      finder_info[16];
+    be<uint32_t> id;
+    be<uint16_t> data_start;
+    be<uint32_t> data_size;
+    be<uint32_t> data_physical_size;
+    be<uint16_t> rsrc_start;
+    be<uint32_t> rsrc_size;
+    be<uint32_t> rsrc_physical_size;
+    be<uint32_t> create_date;
+    be<uint32_t> modify_date;
+    be<uint32_t> backup_date;
+    uint8_t      extended_finder_info[16];
+    be<uint16_t> clump_size;
+    HfsExtent    data_extents[3];
+    HfsExtent    rsrc_extents[3];
+    be<uint32_t> reserved;
+};
+static_assert(sizeof(HfsFileRecord) == 102, "HfsFileRecord must be 102 bytes");
+
+struct HfsPlusFolderRecord {
+    be<uint16_t> type;
+    be<uint16_t> flags;
+    be<uint32_t> valence;
+    be<uint32_t> id;
+};
+
+struct HfsPlusFileRecord {
+    be<uint16_t> type;
+    be<uint16_t> flags;
+    be<uint32_t> reserved;
+    be<uint32_t> id;
+    be<uint32_t> create_date;
+    be<uint32_t> content_modify_date;
+    be<uint32_t> attribute_modify_date;
+    be<uint32_t> access_date;
+    be<uint32_t> backup_date;
+    uint8_t      permissions[16];
+    uint8_t      finder_info[16];
+    uint8_t      extended_finder_info[16];
+    be<uint32_t> text_encoding;
+    be<uint32_t> reserved2;
+    HfsPlusFork  data_fork;
+    HfsPlusFork  rsrc_fork;
+};
+static_assert(sizeof(HfsPlusFileRecord) == 248, "HfsPlusFileRecord must be 248 bytes");
+
+// A run of allocation blocks, as a start block and a count.
+typedef std::pair<uint32_t, uint32_t> Run;
+
+// The runs recorded in the extents overflow file, by file ID, fork type, and the index within
+// the fork of their first block.
+typedef std::map<std::tuple<uint32_t, uint8_t, uint32_t>, vector<Run>> Overflow;
+
+template <typename Extent, size_t N>
+vector<Run> runs(const Extent (&extents)[N]) {
+    vector<Run> result;
+    for (const Extent& extent : extents) {
+        result.emplace_back(extent.start, extent.count);
+    }
+    return result;
+}
+
+// Where allocation blocks are within the image.
+struct Layout {
+    uint64_t first_block;  // the offset of block 0.
+    uint32_t block_size;
+
+    // Finds the extents of a fork, given the runs in its catalog record, followed by any in the
+    // extents overflow file.  Adjacent runs are merged, and the extents are trimmed to `size`.  If
+    // the runs don't cover the fork, the extents are left short, and reading past them fails.
+    vector<HfsVolume::Extent> extents(
+            const vector<Run>& initial, uint64_t size, uint32_t id, uint8_t fork_type,
+            const Overflow& overflow) const {
+        vector<HfsVolume::Extent> result;
+        uint64_t                  remaining = size;
+        uint32_t                  blocks    = 0;
+
+        auto add = [&](const vector<Run>& runs) {
+            for (const Run& run : runs) {
+                if ((remaining == 0) || (run.second == 0)) {
+                    return;
+                }
+                const uint64_t offset = first_block + uint64_t(run.first) * block_size;
+                const uint64_t bytes  = std::min(remaining, uint64_t(run.second) * block_size);
+                if (!result.empty() && (result.back().offset + result.back().size == offset)) {
+                    result.back().size += bytes;
+                } else {
+                    result.push_back(HfsVolume::Extent{offset, bytes});
+                }
+                remaining -= bytes;
+                blocks += run.second;
+            }
+        };
+
+        add(initial);
+        while (remaining > 0) {
+            auto it = overflow.find(std::make_tuple(id, fork_type, blocks));
+            if (it == overflow.end()) {
+                break;
+            }
+            const uint32_t before = blocks;
+            add(it->second);
+            if (blocks == before) {
+                break;
+            }
+        }
+        return result;
+    }
+};
+
+// Copies `size` bytes from `offset` within the fork made of `extents` to `out`.
+//
+// @throws std::runtime_error    If the range extends past the end of the extents, or of the image.
+void read_extents(
+        pn::data_view image, const vector<HfsVolume::Extent>& extents, uint64_t offset,
+        uint64_t size, uint8_t* out) {
+    for (const HfsVolume::Extent& extent : extents) {
+        if (size == 0) {
+            return;
+        } else if (offset >= extent.size) {
+            offset -= extent.size;
+            continue;
+        } else if (
+                (extent.offset > uint64_t(image.size())) ||
+                (extent.size > (image.size() - extent.offset))) {
+            throw std::runtime_error("fork extends past end of image");
+        }
+        const uint64_t n = std::min(size, extent.size - offset);
+        memcpy(out, image.data() + extent.offset + offset, n);
+        out += n;
+        size -= n;
+        offset = 0;
+    }
+    if (size > 0) {
+        throw std::runtime_error("unexpected end of fork");
+    }
+}
+
+// Reads the whole of a fork, such as a B-tree file.
+pn::data read_fork(
+        pn::data_view image, const vector<HfsVolume::Extent>& extents, uint64_t size) {
+    if (size > uint64_t(image.size())) {
+        throw std::runtime_error("fork extends past end of image");
+    }
+    pn::data tree;
+    tree.resize(size);
+    read_extents(image, extents, 0, size, tree.data());
+    return tree;
+}
+
+// Calls `visit(record)` for each record in the leaf nodes of a B-tree, in order of key.
+template <typename Visitor>
+void each_leaf_record(pn::data_view tree, const Visitor& visit) {
+    const HeaderRecord& header    = overlay<HeaderRecord>(tree, sizeof(NodeDescriptor));
+    const uint64_t      node_size = header.node_size;
+    if ((node_size < kSectorSize) || (node_size & 1)) {
+        throw std::runtime_error("invalid B-tree node size");
+    }
+
+    // The leaves are linked in order.  A corrupt tree could link them in a loop, so no more
+    // nodes are visited than the tree holds.
+    uint64_t remaining = tree.size() / node_size;
+    for (uint32_t node = header.first_leaf; node != 0; --remaining) {
+        if ((remaining == 0) || (node >= (tree.size() / node_size))) {
+            throw std::runtime_error("invalid B-tree node");
+        }
+        pn::data_view         data = tree.slice(node * node_size, node_size);
+        const NodeDescriptor& desc = overlay<NodeDescriptor>(data);
+        if (desc.kind != kLeafNode) {
+            throw std::runtime_error("invalid B-tree leaf node");
+        }
+
+        // Record offsets are stored backwards from the end of the node, followed by the offset of
+        // the free space after the last record.
+        const uint64_t end = node_size - 2 * (uint64_t(desc.records) + 1);
+        if (end < sizeof(NodeDescriptor)) {
+            throw std::runtime_error("invalid B-tree leaf node");
+        }
+        for (uint64_t i = 0; i < desc.records; ++i) {
+            const uint16_t start = overlay<be<uint16_t>>(data, node_size - 2 * (i + 1));
+            const uint16_t stop  = overlay<be<uint16_t>>(data, node_size - 2 * (i + 2));
+            if ((start < sizeof(NodeDescriptor)) || (stop < start) || (stop > end)) {
+                throw std::runtime_error("invalid B-tree record");
+            }
+            visit(data.slice(start, stop - start));
+        }
+        node = desc.next;
+    }
+}
+
+// Returns the offset of the data which follows the key at the start of `record`.  Keys are padded
+// to an even length.
+uint64_t key_end(pn::data_view record, bool plus) {
+    const uint64_t size = plus ? uint64_t(overlay<be<uint16_t>>(record)) + 2
+                               : uint64_t(overlay<uint8_t>(record)) + 1;
+    return (size + 1) & ~uint64_t(1);
+}
+
+Overflow read_overflow(pn::data_view tree, bool plus) {
+    Overflow overflow;
+    if (tree.size() == 0) {
+        return overflow;
+    }
+    each_leaf_record(tree, [&overflow, plus](pn::data_view record) {
+        const uint64_t offset = key_end(record, plus);
+        if (plus) {
+            const HfsPlusExtentKey& key = overlay<HfsPlusExtentKey>(record);
+            overflow[std::make_tuple(uint32_t(key.id), key.fork_type, uint32_t(key.start))] =
+                    runs(overlay<HfsPlusExtent[8]>(record, offset));
+        } else {
+            const HfsExtentKey& key = overlay<HfsExtentKey>(record);
+            overflow[std::make_tuple(uint32_t(key.id), key.fork_type, uint32_t(key.start))] =
+                    runs(overlay<HfsExtent[3]>(record, offset));
+        }
+    });
+    return overflow;
+}
+
+// HFS names are MacRoman; HFS+ names are UTF-16.  Either way, slashes are replaced by colons, as
+// macOS does, so that names can be joined into paths.
+pn::string hfs_name(pn::data_view in) {
+    pn::string out;
+    for (int i = 0; i < in.size(); ++i) {
+        if (in.data()[i] == '/') {
+            out += ":";
+        } else {
+            out += macroman::decode(in.slice(i, 1));
+        }
+    }
+    return out;
+}
+
+pn::string hfs_plus_name(pn::data_view in) {
+    pn::string out;
+    for (int i = 0; (i + 1) < in.size(); i += 2) {
+        uint32_t rune = (in.data()[i] << 8) | in.data()[i + 1];
+        if ((0xd800 <= rune) && (rune < 0xdc00) && ((i + 3) < in.size())) {
+            const uint32_t low = (in.data()[i + 2] << 8) | in.data()[i + 3];
+            if ((0xdc00 <= low) && (low < 0xe000)) {
+                rune = 0x10000 + ((rune - 0xd800) << 10) + (low - 0xdc00);
+                i += 2;
+            }
+        }
+        if ((0xd800 <= rune) && (rune < 0xe000)) {
+            rune = 0xfffd;
+        } else if (rune == '/') {
+            rune = ':';
+        }
+        out += pn::rune{rune};
+    }
+    return out;
+}
+
+// Finds the volume within a disk image, returning the offset of its first sector.
+//
+// @throws std::runtime_error    If there is no HFS or HFS+ volume in the image.
+uint64_t find_volume(pn::data_view image) {
+    const uint64_t   size       = image.size();
+    vector<uint64_t> candidates = {0};
+    if (size >= sizeof(DiskCopyHeader)) {
+        if (overlay<DiskCopyHeader>(image).signature == kDiskCopySignature) {
+            candidates.push_back(sizeof(DiskCopyHeader));
+        }
+    }
+    if (size >= kSectorSize) {
+        const DriverDescriptor& ddm = overlay<DriverDescriptor>(image);
+        if (ddm.signature == kDriverDescriptorSignature) {
+            const uint64_t block_size = ddm.block_size ? uint64_t(ddm.block_size) : kSectorSize;
+            uint64_t       count      = 1;
+            for (uint64_t i = 1; (i <= count) && ((i + 1) * block_size <= size); ++i) {
+                const PartitionEntry& entry = overlay<PartitionEntry>(image, i * block_size);
+                if (entry.signature != kPartitionSignature) {
+                    break;
+                }
+                count = entry.map_size;
+                if (strncmp(reinterpret_cast<const char*>(entry.type), "Apple_HFS", 32) == 0) {
+                    candidates.push_back(entry.start * block_size);
+                }
+            }
+        }
+    }
+
+    for (uint64_t offset : candidates) {
+        if ((offset + kVolumeHeaderOffset + sizeof(HfsPlusVolumeHeader)) > size) {
+            continue;
+        }
+        const uint16_t signature = overlay<be<uint16_t>>(image, offset + kVolumeHeaderOffset);
+        if ((signature == kHfsSignature) || (signature == kHfsPlusSignature) ||
+            (signature == kHfsxSignature)) {
+            return offset;
+        }
+    }
+    throw std::runtime_error("not an HFS disk image");
+}
+
+// The parts of the catalog needed to find the path of each file.
+struct Catalog {
+    struct Entry {
+        uint32_t   parent;
+        pn::string name;
+        bool       hidden;  // e.g. the directory which holds the targets of HFS+ hard links.
+    };
+    struct File {
+        Entry       entry;
+        uint32_t    id;
+        uint64_t    size;
+        vector<Run> runs;
+    };
+
+    std::map<uint32_t, Entry> folders;
+    vector<File>              files;
+
+    void read(pn::data_view tree, bool plus) {
+        each_leaf_record(tree, [this, plus](pn::data_view record) {
+            const uint64_t offset = key_end(record, plus);
+            const uint16_t type   = overlay<be<uint16_t>>(record, offset);
+            Entry          entry  = plus ? plus_entry(record) : hfs_entry(record);
+            if (type == HFS_FOLDER_RECORD) {
+                folders[overlay<HfsFolderRecord>(record, offset).id] = std::move(entry);
+            } else if (type == HFS_PLUS_FOLDER_RECORD) {
+                folders[overlay<HfsPlusFolderRecord>(record, offset).id] = std::move(entry);
+            } else if (type == HFS_FILE_RECORD) {
+                const HfsFileRecord& file = overlay<HfsFileRecord>(record, offset);
+                if (file.rsrc_size > 0) {
+                    files.push_back(
+                            File{std::move(entry), file.id, file.rsrc_size,
+                                 runs(file.rsrc_extents)});
+                }
+            } else if (type == HFS_PLUS_FILE_RECORD) {
+                const HfsPlusFileRecord& file = overlay<HfsPlusFileRecord>(record, offset);
+                if (file.rsrc_fork.size > 0) {
+                    files.push_back(
+                            File{std::move(entry), file.id, file.rsrc_fork.size,
+                                 runs(file.rsrc_fork.extents)});
+                }
+            }
+        });
+    }
+
+    static Entry hfs_entry(pn::data_view record) {
+        const HfsCatalogKey& key = overlay<HfsCatalogKey>(record);
+        pn::data_view        name = key_name(record, false, sizeof(key), key.name_size);
+        return Entry{key.parent, hfs_name(name), false};
+    }
+
+    static Entry plus_entry(pn::data_view record) {
+        const HfsPlusCatalogKey& key  = overlay<HfsPlusCatalogKey>(record);
+        pn::data_view            name = key_name(record, true, sizeof(key), 2 * key.name_size);
+        const bool hidden = (name.size() >= 2) && (name.data()[0] == 0) && (name.data()[1] == 0);
+        return Entry{key.parent, hfs_plus_name(name), hidden};
+    }
+
+    // @throws std::runtime_error    If the name extends past the end of the key.
+    static pn::data_view key_name(
+            pn::data_view record, bool plus, uint64_t offset, uint64_t size) {
+        if ((offset + size) > std::min<uint64_t>(key_end(record, plus), record.size())) {
+            throw std::runtime_error("invalid catalog key");
+        }
+        return record.slice(offset, size);
+    }
+
+    // @returns             The path of `entry`, or an empty string if it is hidden.
+    // @throws std::runtime_error    If the folders containing `entry` are not in the catalog.
+    pn::string path(const Entry& entry) const {
+        vector<const Entry*> entries = {&entry};
+        while (entries.back()->parent != kRootFolderId) {
+            auto it = folders.find(entries.back()->parent);
+            if ((it == folders.end()) || (entries.size() > folders.size())) {
+                throw std::runtime_error("catalog is inconsistent");
+            }
+            entries.push_back(&it->second);
+        }
+
+        pn::string result;
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            if ((*it)->hidden) {
+                return "";
+            } else if (!result.empty()) {
+                result += "/";
+            }
+            result += (*it)->name;
+        }
+        return result;
+    }
+};
+
+}  // namespace
+
+HfsVolume::HfsVolume(pn::data_view image) : _image(image) {
+    uint64_t    volume = find_volume(image);
+    Layout      layout;
+    vector<Run> extents_runs, catalog_runs;
+    uint64_t    extents_size, catalog_size;
+
+    // An HFS+ volume embedded in an HFS wrapper occupies a single extent of the wrapper.
+    const MasterDirectoryBlock& mdb =
+            overlay<MasterDirectoryBlock>(image, volume + kVolumeHeaderOffset);
+    bool plus = (mdb.signature != kHfsSignature);
+    if (!plus && (mdb.embedded_signature == kHfsPlusSignature)) {
+        volume += (mdb.first_block * kSectorSize) +
+                  (uint64_t(mdb.embedded_extent.start) * mdb.block_size);
+        plus = true;
+    }
+
+    if (!plus) {
+        layout       = Layout{volume + (mdb.first_block * kSectorSize), mdb.block_size};
+        extents_runs = runs(mdb.extents_extents);
+        extents_size = mdb.extents_size;
+        catalog_runs = runs(mdb.catalog_extents);
+        catalog_size = mdb.catalog_size;
+    } else {
+        const HfsPlusVolumeHeader& header =
+                overlay<HfsPlusVolumeHeader>(image, volume + kVolumeHeaderOffset);
+        if ((header.signature != kHfsPlusSignature) && (header.signature != kHfsxSignature)) {
+            throw std::runtime_error("not an HFS disk image");
+        }
+        layout       = Layout{volume, header.block_size};
+        extents_runs = runs(header.extents_file.extents);
+        extents_size = header.extents_file.size;
+        catalog_runs = runs(header.catalog_file.extents);
+        catalog_size = header.catalog_file.size;
+    }
+    if ((layout.block_size == 0) || (layout.block_size % kSectorSize)) {
+        throw std::runtime_error("invalid allocation block size");
+    }
+
+    // The extents overflow file never overflows itself, but the catalog file can.
+    const pn::data extents_tree =
+            read_fork(image, layout.extents(extents_runs, extents_size, 0, kDataFork, {}),
+                      extents_size);
+    const Overflow overflow =
+            read_overflow(pn::data_view{extents_tree.data(), extents_tree.size()}, plus);
+    const pn::data catalog_tree = read_fork(
+            image, layout.extents(catalog_runs, catalog_size, kCatalogId, kDataFork, overflow),
+            catalog_size);
+    Catalog catalog;
+    catalog.read(pn::data_view{catalog_tree.data(), catalog_tree.size()}, plus);
+
+    for (Catalog::File& file : catalog.files) {
+        pn::string path = catalog.path(file.entry);
+        if (path.empty()) {
+            continue;
+        }
+        _files.push_back(File{
+                std::move(path), file.size,
+                layout.extents(file.runs, file.size, file.id, kResourceFork, overflow)});
+    }
+    std::sort(_files.begin(), _files.end(), [](const File& x, const File& y) {
+        return pn::string_view{x.path} < pn::string_view{y.path};
+    });
+}
+
+const vector<HfsVolume::File>& HfsVolume::files() const { return _files; }
+
+pn::data_view HfsVolume::contiguous(const File& file) const {
+    if ((file.extents.size() != 1) || (file.extents[0].size != file.size)) {
+        return pn::data_view{};
+    }
+    const Extent& extent = file.extents[0];
+    if ((extent.offset > uint64_t(_image.size())) ||
+        (extent.size > (_image.size() - extent.offset))) {
+        throw std::runtime_error("fork extends past end of image");
+    }
+    return _image.slice(extent.offset, extent.size);
+}
+
+void HfsVolume::read(const File& file, uint64_t offset, uint64_t size, uint8_t* out) const {
+    if ((offset > file.size) || (size > (file.size - offset))) {
+        throw std::runtime_error("unexpected end of fork");
+    }
+    read_extents(_image, file.extents, offset, size, out);
+}
+
+namespace {
+
+// Reads a fragmented fork, copying only the ranges which are requested.
+class FragmentedFork : public ForkReader {
+  public:
+    FragmentedFork(const HfsVolume& volume, const HfsVolume::File& file)
+            : _volume(volume), _file(file) {}
+
+    uint64_t size() const override { return _file.size; }
+    void     read(uint64_t offset, uint64_t size, uint8_t* out) override {
+        _volume.read(_file, offset, size, out);
+    }
+
+  private:
+    const HfsVolume&       _volume;
+    const HfsVolume::File& _file;
+};
+
+}  // namespace
+
+// `copy` holds the fork if it is fragmented, and data() has been called.
+struct HfsSource::Fork {
+    const HfsVolume::File* file;
+    mutable pn::data       copy;
+};
+
+HfsSource::HfsSource(pn::string_view path) : _path(path.copy()) {}
+
+HfsSource::~HfsSource() {}
+
+void HfsSource::load() {
+    _file.reset(new sfz::mapped_file(_path));
+    _volume.reset(new HfsVolume(_file->data()));
+    for (const HfsVolume::File& file : _volume->files()) {
+        _forks.emplace_back(new Fork{&file, pn::data{}});
+    }
+}
+
+size_t HfsSource::size() const { return _forks.size(); }
+
+pn::string_view HfsSource::name(size_t index) const { return _forks[index]->file->path; }
+
+pn::data_view HfsSource::data(size_t index) const {
+    const Fork&   fork = *_forks[index];
+    pn::data_view rsrc = _volume->contiguous(*fork.file);
+    if (rsrc.size() > 0) {
+        return rsrc;
+    } else if (fork.copy.size() == 0) {
+        fork.copy = read_fork(_file->data(), fork.file->extents, fork.file->size);
+    }
+    return pn::data_view{fork.copy.data(), fork.copy.size()};
+}
+
+unique_ptr<ResourceFork> HfsSource::open(size_t index, const Options& options) const {
+    const Fork& fork = *_forks[index];
+    if (_volume->contiguous(*fork.file).size() > 0) {
+        return Source::open(index, options);
+    }
+    unique_ptr<ForkReader> reader(new FragmentedFork(*_volume, *fork.file));
+    return unique_ptr<ResourceFork>(new ResourceFork(std::move(reader), options));
+}
+
+void HfsSource::close(size_t index) const { _forks[index]->copy = pn::data{}; }
+
+}  // namespace rezin
@@ -0,0 +1,99 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#ifndef REZIN_SOURCES_HFS_HPP_
+#define REZIN_SOURCES_HFS_HPP_
+
+#include <memory>
+#include <rezin/source.hpp>
+#include <sfz/sfz.hpp>
+#include <vector>
+
+namespace rezin {
+
+// An HFS or HFS+ volume, read from a disk image in memory.
+//
+// The volume may fill the image, or be preceded by a Disk Copy 4.2 header, or be a partition
+// within an Apple partition map, as on CDs.  An HFS+ volume may also be embedded within an HFS
+// wrapper volume.  The volume is only read, never modified; in particular, the journal of a
+// journaled HFS+ volume is not replayed.
+//
+// The catalog is walked once, on construction, to find every file with a resource fork.  The
+// forks themselves are not copied: each is described by the extents which it occupies within the
+// image.
+class HfsVolume {
+  public:
+    // A run of bytes within the image.
+    struct Extent {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct File {
+        pn::string          path;
+        uint64_t            size;     // of the resource fork.
+        std::vector<Extent> extents;  // of the resource fork, trimmed to `size`.
+    };
+
+    // @param [in] image    The content of a disk image.  The block of memory must remain valid
+    //                      for the lifetime of this object; it is not copied.
+    // @throws std::runtime_error    If the image does not hold an HFS or HFS+ volume, or its
+    //                               catalog could not be read.
+    explicit HfsVolume(pn::data_view image);
+
+    // The files with resource forks, sorted by path.  Paths are relative to the root of the
+    // volume, and separated by slashes; slashes within names are replaced by colons.
+    const std::vector<File>& files() const;
+
+    // Returns the resource fork of `file` without copying it, if it is stored contiguously.
+    //
+    // @returns             The resource fork, or an empty block if it is fragmented.
+    // @throws std::runtime_error    If the fork extends past the end of the image.
+    pn::data_view contiguous(const File& file) const;
+
+    // Copies `size` bytes from `offset` within the resource fork of `file` to `out`.  May be
+    // called from several threads at once.
+    //
+    // @throws std::runtime_error    If the range extends past the end of the fork, or of the
+    //                               image.
+    void read(const File& file, uint64_t offset, uint64_t size, uint8_t* out) const;
+
+  private:
+    pn::data_view     _image;
+    std::vector<File> _files;
+};
+
+// Reads the resource forks of every file on an HFS or HFS+ disk image.
+//
+// The image is mapped and its catalog is read once, when loaded.  A fork stored in a single run
+// of blocks is read in place; a fragmented fork is read piece by piece, as its resources are
+// read, rather than being copied whole.
+class HfsSource : public Source {
+  public:
+    HfsSource(pn::string_view path);
+    ~HfsSource();
+
+    void                          load() override;
+    size_t                        size() const override;
+    pn::string_view               name(size_t index) const override;
+    pn::data_view                 data(size_t index) const override;
+    std::unique_ptr<ResourceFork> open(size_t index, const Options& options) const override;
+    void                          close(size_t index) const override;
+
+  private:
+    struct Fork;
+
+    const pn::string                   _path;
+    std::unique_ptr<sfz::mapped_file>  _file;
+    std::unique_ptr<HfsVolume>         _volume;
+    std::vector<std::unique_ptr<Fork>> _forks;
+
+    HfsSource(const HfsSource&) = delete;
+    HfsSource& operator=(const HfsSource&) = delete;
+};
+
+}  // namespace rezin
+
+#endif  // REZIN_SOURCES_HFS_HPP_
@@ -0,0 +1,24 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#include <rezin/sources/mac-binary.hpp>
+
+#include <rezin/mac-binary.hpp>
+#include <sfz/sfz.hpp>
+
+namespace rezin {
+
+MacBinarySource::MacBinarySource(pn::string_view path) : _path(path.copy()) {}
+
+MacBinarySource::~MacBinarySource() {}
+
+void MacBinarySource::load() {
+    _file.reset(new sfz::mapped_file(_path));
+    _mac_binary.reset(new MacBinary(_file->data()));
+}
+
+pn::data_view MacBinarySource::data(size_t index) const { return _mac_binary->resource_fork(); }
+
+}  // namespace rezin
@@ -0,0 +1,35 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#ifndef REZIN_SOURCES_MAC_BINARY_HPP_
+#define REZIN_SOURCES_MAC_BINARY_HPP_
+
+#include <rezin/source.hpp>
+#include <sfz/sfz.hpp>
+
+namespace rezin {
+
+class MacBinary;
+
+class MacBinarySource : public Source {
+  public:
+    MacBinarySource(pn::string_view path);
+    ~MacBinarySource();
+
+    void          load() override;
+    pn::data_view data(size_t index) const override;
+
+  private:
+    const pn::string                  _path;
+    std::unique_ptr<sfz::mapped_file> _file;
+    std::unique_ptr<MacBinary>        _mac_binary;
+
+    MacBinarySource(const MacBinarySource&) = delete;
+    MacBinarySource& operator=(const MacBinarySource&) = delete;
+};
+
+}  // namespace rezin
+
+#endif  // REZIN_SOURCES_MAC_BINARY_HPP_
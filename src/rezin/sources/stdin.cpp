@@ -0,0 +1,145 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#include <rezin/sources/stdin.hpp>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <limits>
+#include <rezin/options.hpp>
+#include <rezin/sources/detect.hpp>
+
+namespace rezin {
+
+namespace {
+
+const size_t kInitialSize = 64 << 10;
+
+}  // namespace
+
+// Memory mapped directly from the system, in whole pages.  Pages are only committed as they are
+// written, so a generous size costs little.
+//
+// On Linux, the buffer grows by remapping its pages, so what has been read is never copied.
+// Elsewhere, each time it grows, it is copied to a new mapping.
+class StdinSource::Buffer {
+  public:
+    Buffer()
+            : _data(nullptr),
+              _size(0),
+              _capacity(0),
+              _page(sysconf(_SC_PAGESIZE)),
+              _max_capacity((size_t(std::numeric_limits<int>::max()) / _page) * _page) {}
+    ~Buffer() {
+        if (_data) {
+            munmap(_data, _capacity);
+        }
+    }
+
+    pn::data_view data() const { return pn::data_view{_data, static_cast<int>(_size)}; }
+
+    // Reads `fd` to its end.
+    //
+    // @param [in] fd       The file descriptor to read.
+    // @param [in] hint     The number of bytes to allocate up front, if `fd` isn't a regular
+    //                      file, or zero for the default.
+    // @throws std::runtime_error    If `fd` could not be read, or holds more than fits in a
+    //                               pn::data_view.
+    void read_all(int fd, size_t hint) {
+        // If `fd` is a regular file, one more byte than remains in it is allocated, so that the
+        // end of the file is found without growing the buffer.
+        if (hint == 0) {
+            hint = kInitialSize;
+        }
+        struct stat st;
+        if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode)) {
+            const off_t offset = lseek(fd, 0, SEEK_CUR);
+            if ((offset >= 0) && (offset <= st.st_size)) {
+                hint = (st.st_size - offset) + 1;
+            }
+        }
+        reserve(hint);
+
+        while (true) {
+            if (_size == _capacity) {
+                if (_capacity == _max_capacity) {
+                    throw std::runtime_error("input is too large");
+                }
+                reserve(_capacity * 2);
+            }
+            const ssize_t n = ::read(fd, _data + _size, _capacity - _size);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(strerror(errno));
+            } else if (n == 0) {
+                return;
+            }
+            _size += n;
+        }
+    }
+
+  private:
+    // Grows the buffer to hold at least `capacity` bytes, rounded up to a whole number of pages,
+    // but no more than _max_capacity.
+    void reserve(size_t capacity) {
+        capacity = std::min(capacity, _max_capacity);
+        capacity = ((capacity + _page - 1) / _page) * _page;
+        if (capacity <= _capacity) {
+            return;
+        }
+        void* data = MAP_FAILED;
+        if (!_data) {
+            data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        } else {
+#ifdef __linux__
+            data = mremap(_data, _capacity, capacity, MREMAP_MAYMOVE);
+#else
+            data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+            if (data != MAP_FAILED) {
+                memcpy(data, _data, _size);
+                munmap(_data, _capacity);
+            }
+#endif
+        }
+        if (data == MAP_FAILED) {
+            throw std::runtime_error(strerror(errno));
+        }
+        _data     = static_cast<uint8_t*>(data);
+        _capacity = capacity;
+    }
+
+    uint8_t*     _data;
+    size_t       _size;
+    size_t       _capacity;
+    const size_t _page;
+    const size_t _max_capacity;  // the most whole pages a pn::data_view can hold.
+};
+
+StdinSource::StdinSource(const Options& options) : _options(options), _buffer(new Buffer) {}
+
+StdinSource::~StdinSource() {}
+
+void StdinSource::load() {
+    _buffer->read_all(STDIN_FILENO, size_t(_options.stdin_size) << 20);
+    pn::data_view data   = _buffer->data();
+    pn::data_view header = data.slice(0, std::min<int>(data.size(), kDetectSize));
+    _fork.reset(new ForkFile(detect_format(header, data.size()), data));
+}
+
+pn::data_view StdinSource::data(size_t index) const {
+    pn::data_view rsrc = _fork->resource_fork();
+    if (rsrc.size() == 0) {
+        throw std::runtime_error("file has no resource fork");
+    }
+    return rsrc;
+}
+
+}  // namespace rezin
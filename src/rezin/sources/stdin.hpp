@@ -0,0 +1,46 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of rezin, a free software project.  You can redistribute it and/or modify it
+// under the terms of the MIT License.
+
+#ifndef REZIN_SOURCES_STDIN_HPP_
+#define REZIN_SOURCES_STDIN_HPP_
+
+#include <memory>
+#include <rezin/source.hpp>
+#include <sfz/sfz.hpp>
+
+namespace rezin {
+
+class ForkFile;
+struct Options;
+
+// Reads a resource fork from standard input, in any format detect_format() recognizes.
+//
+// Input is read to its end when loaded, directly into a page-aligned buffer.  If standard input
+// is a regular file, the buffer is allocated once, at the size of the file.  Otherwise, it starts
+// at `options.stdin_size` MiB, if given, and doubles in size as it fills.
+class StdinSource : public Source {
+  public:
+    // @param [in] options  The options of the command line.  They are only read when loaded, so
+    //                      they may be given after the source, but must outlive it.
+    explicit StdinSource(const Options& options);
+    ~StdinSource();
+
+    void          load() override;
+    pn::data_view data(size_t index) const override;
+
+  private:
+    class Buffer;
+
+    const Options&            _options;
+    std::unique_ptr<Buffer>   _buffer;
+    std::unique_ptr<ForkFile> _fork;
+
+    StdinSource(const StdinSource&) = delete;
+    StdinSource& operator=(const StdinSource&) = delete;
+};
+
+}  // namespace rezin
+
+#endif  // REZIN_SOURCES_STDIN_HPP_
@@ -5,14 +5,475 @@
 
 #include <rezin/sources/zip.hpp>
 
+#include <string.h>
+#include <zlib.h>
+#include <algorithm>
+#include <map>
 #include <rezin/apple-single.hpp>
+#include <rezin/endian.hpp>
+#include <rezin/options.hpp>
+#include <rezin/resource.hpp>
 
-using zipxx::ZipArchive;
-using zipxx::ZipFileReader;
+using std::unique_ptr;
+using std::vector;
 
 namespace rezin {
 
-ZipSource::ZipSource(pn::string_view arg) {
+namespace {
+
+const uint32_t kEndOfCentralDirectorySignature = 0x06054b50;
+const uint32_t kCentralDirectorySignature      = 0x02014b50;
+const uint32_t kLocalHeaderSignature           = 0x04034b50;
+
+enum {
+    STORED   = 0,
+    DEFLATED = 8,
+};
+
+enum {
+    ENCRYPTED = 0x0001,
+};
+
+struct EndOfCentralDirectory {
+    le<uint32_t> signature;
+    le<uint16_t> disk;
+    le<uint16_t> directory_disk;
+    le<uint16_t> disk_entries;
+    le<uint16_t> entries;
+    le<uint32_t> directory_size;
+    le<uint32_t> directory_offset;
+    le<uint16_t> comment_size;
+};
+
+struct CentralDirectoryHeader {
+    le<uint32_t> signature;
+    le<uint16_t> version_made_by;
+    le<uint16_t> version_needed;
+    le<uint16_t> flags;
+    le<uint16_t> method;
+    le<uint16_t> time;
+    le<uint16_t> date;
+    le<uint32_t> crc;
+    le<uint32_t> compressed_size;
+    le<uint32_t> size;
+    le<uint16_t> name_size;
+    le<uint16_t> extra_size;
+    le<uint16_t> comment_size;
+    le<uint16_t> disk;
+    le<uint16_t> internal_attributes;
+    le<uint32_t> external_attributes;
+    le<uint32_t> local_offset;
+};
+
+struct LocalHeader {
+    le<uint32_t> signature;
+    le<uint16_t> version_needed;
+    le<uint16_t> flags;
+    le<uint16_t> method;
+    le<uint16_t> time;
+    le<uint16_t> date;
+    le<uint32_t> crc;
+    le<uint32_t> compressed_size;
+    le<uint32_t> size;
+    le<uint16_t> name_size;
+    le<uint16_t> extra_size;
+};
+
+// Finds the end of central directory record, which is at the end of the archive, followed only by
+// a comment of up to 64 KiB.
+const EndOfCentralDirectory& find_end_of_central_directory(pn::data_view data) {
+    const int64_t last  = int64_t(data.size()) - int64_t(sizeof(EndOfCentralDirectory));
+    const int64_t first = std::max<int64_t>(0, last - 0xffff);
+    for (int64_t offset = last; offset >= first; --offset) {
+        const EndOfCentralDirectory& end = overlay<EndOfCentralDirectory>(data, offset);
+        if ((end.signature == kEndOfCentralDirectorySignature) &&
+            ((offset + sizeof(EndOfCentralDirectory) + end.comment_size) == size_t(data.size()))) {
+            return end;
+        }
+    }
+    throw std::runtime_error("not a zip archive");
+}
+
+// Returns the path of the file whose AppleDouble file is at `path`, or an empty string if `path`
+// is not an AppleDouble file.  "__MACOSX/dir/._FILE" becomes "dir/FILE".
+pn::string apple_double_target(pn::string_view path) {
+    pn::string_view prefix = "__MACOSX/";
+    if ((path.size() <= prefix.size()) || (path.substr(0, prefix.size()) != prefix)) {
+        return "";
+    }
+    path                  = path.substr(prefix.size());
+    const int       slash = path.rfind(pn::rune{'/'});
+    pn::string_view dir   = (slash < 0) ? pn::string_view{} : path.substr(0, slash + 1);
+    pn::string_view base  = path.substr(slash + 1);
+    if ((base.size() <= 2) || (base.substr(0, 2) != "._")) {
+        return "";
+    }
+    pn::string target = dir.copy();
+    target += base.substr(2);
+    return target;
+}
+
+// @throws std::runtime_error    If `entry` can't be decompressed by ZipArchive.
+void check_supported(const ZipArchive::Entry& entry) {
+    if (entry.flags & ENCRYPTED) {
+        throw std::runtime_error("encrypted zip entries are not supported");
+    } else if ((entry.method != STORED) && (entry.method != DEFLATED)) {
+        throw std::runtime_error(
+                pn::format("unsupported zip compression method {0}", entry.method).c_str());
+    }
+}
+
+const uint32_t kBlockSize      = 64 << 10;
+const uint32_t kCheckpoints    = 64;
+const size_t   kCheckpointSize = 40 << 10;  // zlib's inflate state, and its 32 KiB window.
+
+// Returns the number of checkpoints to save within `cache_size` bytes: as many as fit in half of
+// it, up to kCheckpoints, and at least the one at the start of the entry.
+uint32_t checkpoint_count(size_t cache_size) {
+    return std::max<size_t>(1, std::min<size_t>(kCheckpoints, cache_size / (2 * kCheckpointSize)));
+}
+
+// Returns the number of blocks to cache within what's left of `cache_size` bytes once the
+// checkpoints are saved, and at least one.
+size_t cache_block_count(size_t cache_size) {
+    const size_t checkpoints = checkpoint_count(cache_size) * kCheckpointSize;
+    return std::max<size_t>(1, (cache_size - std::min(cache_size, checkpoints)) / kBlockSize);
+}
+
+// Decompresses a deflated zip entry piecemeal, keeping a bounded amount of its output.
+//
+// Output is produced in blocks of kBlockSize bytes, and cached, evicting the least recently used.
+// Inflating is inherently sequential, so as the decompressor first passes each of a number of
+// evenly-spaced blocks, its state is saved; a block which is no longer cached is decompressed
+// again from the nearest checkpoint before it, rather than from the start of the entry.
+//
+// The checkpoints and the cache share `cache_size` bytes.  Each checkpoint costs about
+// kCheckpointSize, so a smaller budget saves fewer of them, and the blocks get what's left.
+//
+// Unlike ZipArchive::read(), this can't check the CRC of the entry, which covers all of it.
+class Inflater {
+  public:
+    Inflater(pn::data_view in, uint32_t size, size_t cache_size);
+    ~Inflater();
+
+    // @throws std::runtime_error    If the range extends past the end of the entry, or the entry
+    //                               is corrupt.
+    void read(uint64_t offset, uint64_t size, uint8_t* out);
+
+  private:
+    struct Block {
+        pn::data data;
+        uint64_t last_use;
+    };
+
+    struct Checkpoint {
+        explicit Checkpoint(z_stream* z);
+        ~Checkpoint();
+        z_stream z;
+    };
+
+    uint32_t        block_size(uint32_t index) const;
+    const pn::data& block(uint32_t index);
+    void            seek(uint32_t index);
+    void            inflate_block(uint8_t* out);
+
+    const uint32_t                 _size;
+    const size_t                   _cache_blocks;
+    uint32_t                       _span;  // blocks between checkpoints.
+    z_stream                       _z;
+    uint32_t                       _next;  // block that _z will produce next.
+    vector<unique_ptr<Checkpoint>> _checkpoints;
+    std::map<uint32_t, Block>      _cache;
+    uint64_t                       _clock;
+    pn::data                       _scratch;
+
+    Inflater(const Inflater&) = delete;
+    Inflater& operator=(const Inflater&) = delete;
+};
+
+Inflater::Checkpoint::Checkpoint(z_stream* from) {
+    if (inflateCopy(&z, from) != Z_OK) {
+        throw std::runtime_error("couldn't copy zlib state");
+    }
+}
+
+Inflater::Checkpoint::~Checkpoint() { inflateEnd(&z); }
+
+Inflater::Inflater(pn::data_view in, uint32_t size, size_t cache_size)
+        : _size(size),
+          _cache_blocks(cache_block_count(cache_size)),
+          _next(0),
+          _clock(0) {
+    const uint32_t blocks      = (uint64_t(size) + kBlockSize - 1) / kBlockSize;
+    const uint32_t checkpoints = checkpoint_count(cache_size);
+    _span                      = std::max<uint32_t>(1, (blocks + checkpoints - 1) / checkpoints);
+    _scratch.resize(kBlockSize);
+
+    memset(&_z, 0, sizeof(_z));
+    if (inflateInit2(&_z, -MAX_WBITS) != Z_OK) {
+        throw std::runtime_error("couldn't initialize zlib");
+    }
+    _z.next_in  = const_cast<Bytef*>(in.data());
+    _z.avail_in = in.size();
+}
+
+Inflater::~Inflater() { inflateEnd(&_z); }
+
+void Inflater::read(uint64_t offset, uint64_t size, uint8_t* out) {
+    if ((offset > _size) || (size > (_size - offset))) {
+        throw std::runtime_error("unexpected end of data");
+    }
+    while (size > 0) {
+        const pn::data& data  = block(offset / kBlockSize);
+        const uint32_t  start = offset % kBlockSize;
+        const uint32_t  n     = std::min<uint64_t>(size, data.size() - start);
+        memcpy(out, data.data() + start, n);
+        out += n;
+        offset += n;
+        size -= n;
+    }
+}
+
+uint32_t Inflater::block_size(uint32_t index) const {
+    return std::min<uint64_t>(kBlockSize, _size - (uint64_t(index) * kBlockSize));
+}
+
+const pn::data& Inflater::block(uint32_t index) {
+    auto it = _cache.find(index);
+    if (it == _cache.end()) {
+        if (_cache.size() >= _cache_blocks) {
+            auto lru = std::min_element(
+                    _cache.begin(), _cache.end(),
+                    [](const std::pair<const uint32_t, Block>& x,
+                       const std::pair<const uint32_t, Block>& y) {
+                        return x.second.last_use < y.second.last_use;
+                    });
+            _cache.erase(lru);
+        }
+        seek(index);
+        Block block;
+        block.data.resize(block_size(index));
+        inflate_block(block.data.data());
+        it = _cache.insert(std::make_pair(index, std::move(block))).first;
+    }
+    it->second.last_use = ++_clock;
+    return it->second.data;
+}
+
+void Inflater::seek(uint32_t index) {
+    // If the checkpoint before `index` has been saved, and the decompressor isn't already between
+    // it and `index`, then restart from the checkpoint.  Otherwise, the decompressor hasn't yet
+    // reached `index`, and can simply continue.
+    const uint32_t checkpoint = index / _span;
+    if ((checkpoint < _checkpoints.size()) &&
+        ((_next > index) || (_next < (checkpoint * _span)))) {
+        inflateEnd(&_z);
+        if (inflateCopy(&_z, &_checkpoints[checkpoint]->z) != Z_OK) {
+            throw std::runtime_error("couldn't copy zlib state");
+        }
+        _next = checkpoint * _span;
+    }
+    while (_next < index) {
+        inflate_block(_scratch.data());
+    }
+}
+
+void Inflater::inflate_block(uint8_t* out) {
+    if (((_next % _span) == 0) && ((_next / _span) == _checkpoints.size())) {
+        _checkpoints.emplace_back(new Checkpoint(&_z));
+    }
+    _z.next_out      = out;
+    _z.avail_out     = block_size(_next);
+    const int result = inflate(&_z, Z_NO_FLUSH);
+    if (((result != Z_OK) && (result != Z_STREAM_END)) || (_z.avail_out != 0)) {
+        throw std::runtime_error("zip entry is corrupt");
+    }
+    ++_next;
+}
+
+// The resource fork of an AppleDouble file within a zip archive, decompressed as it is read.
+class StreamedFork : public ForkReader {
+  public:
+    StreamedFork(const ZipArchive& archive, const ZipArchive::Entry& entry, size_t cache_size);
+
+    bool     has_resource_fork() const { return _has_resource_fork; }
+    uint64_t size() const override { return _size; }
+    void     read(uint64_t offset, uint64_t size, uint8_t* out) override;
+
+  private:
+    void read_entry(uint64_t offset, uint64_t size, uint8_t* out);
+
+    pn::data_view        _stored;  // if the entry is stored, rather than deflated.
+    unique_ptr<Inflater> _inflater;
+    uint64_t             _offset;
+    uint64_t             _size;
+    bool                 _has_resource_fork;
+};
+
+StreamedFork::StreamedFork(
+        const ZipArchive& archive, const ZipArchive::Entry& entry, size_t cache_size)
+        : _offset(0), _size(0) {
+    check_supported(entry);
+    pn::data_view in = archive.compressed(entry);
+    if (entry.method == DEFLATED) {
+        _inflater.reset(new Inflater(in, entry.size, cache_size));
+    } else if (uint32_t(in.size()) != entry.size) {
+        throw std::runtime_error("zip entry has wrong size");
+    } else {
+        _stored = in;
+    }
+
+    pn::data header;
+    header.resize(AppleDouble::kMinHeaderSize);
+    read_entry(0, header.size(), header.data());
+    header.resize(AppleDouble::header_size(header));
+    read_entry(0, header.size(), header.data());
+    _has_resource_fork = AppleDouble::locate(header, AppleDouble::RESOURCE_FORK, &_offset, &_size);
+    if ((_offset > entry.size) || (_size > (entry.size - _offset))) {
+        throw std::runtime_error("resource fork extends past end of file");
+    }
+}
+
+void StreamedFork::read(uint64_t offset, uint64_t size, uint8_t* out) {
+    if ((offset > _size) || (size > (_size - offset))) {
+        throw std::runtime_error("unexpected end of data");
+    }
+    read_entry(_offset + offset, size, out);
+}
+
+void StreamedFork::read_entry(uint64_t offset, uint64_t size, uint8_t* out) {
+    if (_inflater) {
+        _inflater->read(offset, size, out);
+    } else if ((offset > uint64_t(_stored.size())) || (size > (_stored.size() - offset))) {
+        throw std::runtime_error("unexpected end of data");
+    } else {
+        memcpy(out, _stored.data() + offset, size);
+    }
+}
+
+// @returns             The resource fork of the AppleDouble file in `entry`, decompressed as it
+//                      is read, or nullptr if the file has no resource fork.
+unique_ptr<ResourceFork> open_streamed(
+        const ZipArchive& archive, const ZipArchive::Entry& entry, const Options& options) {
+    unique_ptr<StreamedFork> fork(
+            new StreamedFork(archive, entry, size_t(options.window) << 20));
+    if (!fork->has_resource_fork()) {
+        return nullptr;
+    }
+    return unique_ptr<ResourceFork>(new ResourceFork(std::move(fork), options));
+}
+
+}  // namespace
+
+ZipArchive::ZipArchive(pn::data_view data) : _data(data) {
+    const EndOfCentralDirectory& end = find_end_of_central_directory(data);
+    if ((end.entries == 0xffff) || (end.directory_offset == 0xffffffff)) {
+        throw std::runtime_error("zip64 archives are not supported");
+    } else if ((end.disk != 0) || (end.directory_disk != 0) || (end.disk_entries != end.entries)) {
+        throw std::runtime_error("multi-disk zip archives are not supported");
+    }
+
+    uint64_t offset = end.directory_offset;
+    _entries.reserve(end.entries);
+    for (uint16_t i = 0; i < end.entries; ++i) {
+        const CentralDirectoryHeader& header = overlay<CentralDirectoryHeader>(data, offset);
+        if (header.signature != kCentralDirectorySignature) {
+            throw std::runtime_error("invalid zip central directory");
+        }
+        offset += sizeof(CentralDirectoryHeader);
+        if ((offset + header.name_size) > uint64_t(data.size())) {
+            throw std::runtime_error("invalid zip central directory");
+        }
+        pn::string_view name{
+                reinterpret_cast<const char*>(data.data() + offset), header.name_size};
+        offset += header.name_size + header.extra_size + header.comment_size;
+
+        _index[name] = _entries.size();
+        _entries.push_back(
+                Entry{name.copy(), header.flags, header.method, header.crc, header.compressed_size,
+                      header.size, header.local_offset});
+    }
+}
+
+const vector<ZipArchive::Entry>& ZipArchive::entries() const { return _entries; }
+
+const ZipArchive::Entry& ZipArchive::at(pn::string_view name) const {
+    auto it = _index.find(name);
+    if (it == _index.end()) {
+        throw std::runtime_error(pn::format("no such file in zip archive: {0}", name).c_str());
+    }
+    return _entries[it->second];
+}
+
+pn::data_view ZipArchive::compressed(const Entry& entry) const {
+    const LocalHeader& header = overlay<LocalHeader>(_data, entry.local_offset);
+    if (header.signature != kLocalHeaderSignature) {
+        throw std::runtime_error("invalid zip local header");
+    }
+    const uint64_t offset = uint64_t(entry.local_offset) + sizeof(LocalHeader) +
+                            header.name_size + header.extra_size;
+    if ((offset + entry.compressed_size) > uint64_t(_data.size())) {
+        throw std::runtime_error("zip entry extends past end of archive");
+    }
+    return _data.slice(offset, entry.compressed_size);
+}
+
+pn::data ZipArchive::read(const Entry& entry) const {
+    check_supported(entry);
+    pn::data_view in = compressed(entry);
+    pn::data      out;
+    out.resize(entry.size);
+
+    switch (entry.method) {
+        case STORED: {
+            if (in.size() != out.size()) {
+                throw std::runtime_error("zip entry has wrong size");
+            }
+            memcpy(out.data(), in.data(), in.size());
+            break;
+        }
+
+        case DEFLATED: {
+            // The whole entry is inflated in a single call: the sizes of both the input and the
+            // output are known up front.
+            z_stream z;
+            memset(&z, 0, sizeof(z));
+            if (inflateInit2(&z, -MAX_WBITS) != Z_OK) {
+                throw std::runtime_error("couldn't initialize zlib");
+            }
+            z.next_in   = const_cast<Bytef*>(in.data());
+            z.avail_in  = in.size();
+            z.next_out  = out.data();
+            z.avail_out = out.size();
+            const int result = inflate(&z, Z_FINISH);
+            const uLong size = z.total_out;
+            inflateEnd(&z);
+            if ((result != Z_STREAM_END) || (size != entry.size)) {
+                throw std::runtime_error("zip entry is corrupt");
+            }
+            break;
+        }
+    }
+
+    if (crc32(crc32(0, nullptr, 0), out.data(), out.size()) != entry.crc) {
+        throw std::runtime_error("zip entry has wrong CRC");
+    }
+    return out;
+}
+
+ZippedAppleDouble::ZippedAppleDouble(const ZipArchive& archive, const ZipArchive::Entry& entry)
+        : _data(archive.read(entry)), _apple_double(new AppleDouble(_data)) {}
+
+ZippedAppleDouble::~ZippedAppleDouble() {}
+
+pn::data_view ZippedAppleDouble::resource_fork() const {
+    if (!_apple_double->contains(AppleDouble::RESOURCE_FORK)) {
+        return pn::data_view{};
+    }
+    return _apple_double->at(AppleDouble::RESOURCE_FORK);
+}
+
+ZipSource::ZipSource(pn::string_view arg) : _entry(nullptr) {
     pn::string_view zip_path;
     if (!partition(zip_path, ",", arg)) {
         throw std::runtime_error(
@@ -28,21 +489,76 @@ ZipSource::ZipSource(pn::string_view arg) {
 
 ZipSource::~ZipSource() {}
 
-struct ZipSource::Contents {
-    Contents(pn::string_view zip_file, pn::string_view file_path);
+void ZipSource::load() {
+    _file.reset(new sfz::mapped_file(_zip_path));
+    _archive.reset(new ZipArchive(_file->data()));
+    _entry = &_archive->at(_file_path);
+}
+
+pn::data_view ZipSource::data(size_t index) const {
+    if (!_apple_double) {
+        _apple_double.reset(new ZippedAppleDouble(*_archive, *_entry));
+    }
+    pn::data_view rsrc = _apple_double->resource_fork();
+    if (rsrc.size() == 0) {
+        throw std::runtime_error("file has no resource fork");
+    }
+    return rsrc;
+}
+
+unique_ptr<ResourceFork> ZipSource::open(size_t index, const Options& options) const {
+    if (!options.window) {
+        return Source::open(index, options);
+    }
+    unique_ptr<ResourceFork> rsrc = open_streamed(*_archive, *_entry, options);
+    if (!rsrc) {
+        throw std::runtime_error("file has no resource fork");
+    }
+    return rsrc;
+}
 
-    zipxx::ZipArchive    archive;
-    zipxx::ZipFileReader file;
-    AppleSingle          apple_single;
+// Each fork is inflated by the first call to data(), and kept until it is closed.
+struct ZipArchiveSource::Fork {
+    const ZipArchive::Entry*              entry;
+    pn::string                            name;
+    mutable unique_ptr<ZippedAppleDouble> apple_double;
 };
 
-ZipSource::Contents::Contents(pn::string_view zip_file, pn::string_view file_path)
-        : archive(zip_file, 0), file(archive, file_path), apple_single(file.data()) {}
+ZipArchiveSource::ZipArchiveSource(pn::string_view path) : _path(path.copy()) {}
+
+ZipArchiveSource::~ZipArchiveSource() {}
+
+void ZipArchiveSource::load() {
+    _file.reset(new sfz::mapped_file(_path));
+    _archive.reset(new ZipArchive(_file->data()));
+    for (const ZipArchive::Entry& entry : _archive->entries()) {
+        pn::string name = apple_double_target(entry.name);
+        if (name.size() == 0) {
+            continue;
+        }
+        _forks.emplace_back(new Fork{&entry, std::move(name), nullptr});
+    }
+}
+
+size_t ZipArchiveSource::size() const { return _forks.size(); }
+
+pn::string_view ZipArchiveSource::name(size_t index) const { return _forks[index]->name; }
 
-void ZipSource::load() { _contents.reset(new Contents(_zip_path, _file_path)); }
+pn::data_view ZipArchiveSource::data(size_t index) const {
+    const Fork& fork = *_forks[index];
+    if (!fork.apple_double) {
+        fork.apple_double.reset(new ZippedAppleDouble(*_archive, *fork.entry));
+    }
+    return fork.apple_double->resource_fork();
+}
 
-pn::data_view ZipSource::data() const {
-    return _contents->apple_single.at(AppleDouble::RESOURCE_FORK);
+unique_ptr<ResourceFork> ZipArchiveSource::open(size_t index, const Options& options) const {
+    if (!options.window) {
+        return Source::open(index, options);
+    }
+    return open_streamed(*_archive, *_forks[index]->entry, options);
 }
 
+void ZipArchiveSource::close(size_t index) const { _forks[index]->apple_double.reset(); }
+
 }  // namespace rezin
@@ -6,30 +6,128 @@
 #ifndef REZIN_SOURCES_ZIP_HPP_
 #define REZIN_SOURCES_ZIP_HPP_
 
+#include <memory>
 #include <rezin/source.hpp>
 #include <sfz/sfz.hpp>
-#include <zipxx/zipxx.hpp>
+#include <vector>
 
 namespace rezin {
 
+class AppleSingle;
+
+// A zip archive, read from a block of memory.
+//
+// The central directory is parsed once, on construction; the contents of an entry are only
+// decompressed when read.  Stored and deflated entries are supported, but not zip64 archives or
+// encrypted entries.
+class ZipArchive {
+  public:
+    struct Entry {
+        pn::string name;
+        uint16_t   flags;
+        uint16_t   method;
+        uint32_t   crc;
+        uint32_t   compressed_size;
+        uint32_t   size;
+        uint32_t   local_offset;
+    };
+
+    // @param [in] data     The content of a zip archive.  The block of memory must remain valid
+    //                      for the lifetime of this object; it is not copied.
+    // @throws std::runtime_error    If the central directory could not be read.
+    explicit ZipArchive(pn::data_view data);
+
+    const std::vector<Entry>& entries() const;
+
+    // @throws std::runtime_error    If there is no entry named `name`.
+    const Entry& at(pn::string_view name) const;
+
+    // Returns the compressed content of `entry`, as stored in the archive.
+    //
+    // @throws std::runtime_error    If the entry's local header could not be read.
+    pn::data_view compressed(const Entry& entry) const;
+
+    // Decompresses `entry`, checking its size and CRC.  May be called from several threads at
+    // once.
+    //
+    // @throws std::runtime_error    If the entry could not be decompressed.
+    pn::data read(const Entry& entry) const;
+
+  private:
+    pn::data_view          _data;
+    std::vector<Entry>     _entries;
+    sfz::StringMap<size_t> _index;
+};
+
+// An AppleDouble file within a zip archive, as created by the Finder's "Compress" command: the
+// resource fork of "dir/FILE" is stored in the entry "__MACOSX/dir/._FILE".
+class ZippedAppleDouble {
+  public:
+    ZippedAppleDouble(const ZipArchive& archive, const ZipArchive::Entry& entry);
+    ~ZippedAppleDouble();
+
+    // @returns             The resource fork, or an empty block if the file has none.
+    pn::data_view resource_fork() const;
+
+  private:
+    pn::data                     _data;
+    std::unique_ptr<AppleSingle> _apple_double;
+};
+
+// Reads the resource fork of a single file from a zip archive.
+//
+// By default, the file is decompressed in full.  If `Options::window` is set, it is instead
+// decompressed as its resources are read, keeping only a bounded amount in memory.
 class ZipSource : public Source {
   public:
     ZipSource(pn::string_view arg);
     ~ZipSource();
 
-    void          load() override;
-    pn::data_view data() const override;
+    void                          load() override;
+    pn::data_view                 data(size_t index) const override;
+    std::unique_ptr<ResourceFork> open(size_t index, const Options& options) const override;
 
   private:
-    pn::string _zip_path;
-    pn::string _file_path;
-    struct Contents;
-    std::unique_ptr<Contents> _contents;
+    pn::string                                 _zip_path;
+    pn::string                                 _file_path;
+    std::unique_ptr<sfz::mapped_file>          _file;
+    std::unique_ptr<ZipArchive>                _archive;
+    const ZipArchive::Entry*                   _entry;
+    mutable std::unique_ptr<ZippedAppleDouble> _apple_double;
 
     ZipSource(const ZipSource&) = delete;
     ZipSource& operator=(const ZipSource&) = delete;
 };
 
+// Reads the resource forks of every file in a zip archive.
+//
+// The archive is indexed once, when loaded, and each fork is only decompressed when its data is
+// first requested.  As with ZipSource, `Options::window` makes each fork be decompressed
+// incrementally instead.
+class ZipArchiveSource : public Source {
+  public:
+    ZipArchiveSource(pn::string_view path);
+    ~ZipArchiveSource();
+
+    void                          load() override;
+    size_t                        size() const override;
+    pn::string_view               name(size_t index) const override;
+    pn::data_view                 data(size_t index) const override;
+    std::unique_ptr<ResourceFork> open(size_t index, const Options& options) const override;
+    void                          close(size_t index) const override;
+
+  private:
+    struct Fork;
+
+    const pn::string                   _path;
+    std::unique_ptr<sfz::mapped_file>  _file;
+    std::unique_ptr<ZipArchive>        _archive;
+    std::vector<std::unique_ptr<Fork>> _forks;
+
+    ZipArchiveSource(const ZipArchiveSource&) = delete;
+    ZipArchiveSource& operator=(const ZipArchiveSource&) = delete;
+};
+
 }  // namespace rezin
 
 #endif  // REZIN_SOURCES_ZIP_HPP_
@@ -9,38 +9,67 @@
 #include <sfz/sfz.hpp>
 #include <vector>
 
-using sfz::range;
 using std::vector;
 
 namespace rezin {
 
-StringList::StringList(pn::data_view in, const Options& options) {
-    pn::file f = in.open();
-    uint16_t array_size;
-    f.read(&array_size).check();
-
-    for (uint16_t i : range(array_size)) {
-        uint8_t size;
-        f.read(&size).check();
-
-        pn::data data;
-        data.resize(size);
-        f.read(&data).check();
+StringList::StringList(pn::data_view in, const Options& options)
+        : _data(in), _options(options) {
+    const size_t size = in.size();
+    if (size < 2) {
+        throw std::runtime_error("'STR#' resource too short");
+    }
+    const uint16_t array_size = (in[0] << 8) | in[1];
+    _offsets.reserve(array_size);
 
-        strings.push_back(options.decode(data));
+    // Each string is a length byte followed by that many bytes of text; record where each
+    // starts, checking that it ends within the resource.
+    size_t offset = 2;
+    for (uint16_t i = 0; i < array_size; ++i) {
+        if ((offset >= size) || ((offset + 1 + in[offset]) > size)) {
+            throw std::runtime_error("'STR#' string extends past end of resource");
+        }
+        _offsets.push_back(offset);
+        offset += 1 + in[offset];
     }
 
-    if (!f.read(pn::pad(1)).eof()) {
+    if (offset != size) {
         throw std::runtime_error(pn::format("extra bytes at end of 'STR#' resource.").c_str());
     }
 }
 
+size_t StringList::size() const { return _offsets.size(); }
+
+pn::data_view StringList::data(size_t index) const {
+    const uint32_t offset = _offsets[index];
+    return _data.slice(offset + 1, _data[offset]);
+}
+
+pn::string StringList::at(size_t index) const { return _options.decode(data(index)); }
+
+vector<pn::string> StringList::strings() const {
+    vector<pn::string> result;
+    result.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        result.push_back(at(i));
+    }
+    return result;
+}
+
 pn::value value(const StringList& strings) {
     pn::array a;
-    for (const pn::string& string : strings.strings) {
-        a.push_back(string.copy());
+    for (pn::string& string : strings.strings()) {
+        a.push_back(std::move(string));
     }
     return std::move(a);
 }
 
+void emit(Emitter& out, const StringList& strings) {
+    out.begin_array();
+    for (size_t i = 0; i < strings.size(); ++i) {
+        out.value(strings.at(i));
+    }
+    out.end_array();
+}
+
 }  // namespace rezin
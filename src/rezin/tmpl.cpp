@@ -0,0 +1,576 @@
+// Copyright (c) 2026 Chris Pickel <sfiera@gmail.com>
+//
+// This file is part of librezin, a free software project.  You can redistribute it and/or modify
+// it under the terms of the MIT License.
+
+#include <rezin/tmpl.hpp>
+
+#include <algorithm>
+#include <rezin/clut.hpp>
+#include <rezin/resource.hpp>
+#include <sfz/sfz.hpp>
+
+using std::unique_ptr;
+using std::vector;
+
+namespace macroman = sfz::macroman;
+
+namespace rezin {
+
+namespace {
+
+enum Code : uint8_t {
+    INT8,
+    INT16,
+    INT32,
+    UINT8,
+    UINT16,
+    UINT32,
+    BOOLEAN,
+    BIT,  // param: index of the bit; the byte is consumed after bit 0.
+    CHAR,
+    TYPE_NAME,
+    PSTRING,        // param: padding.
+    CSTRING,        // param: padding.
+    WSTRING,        // Pascal string with a 2-byte length.
+    LSTRING,        // Pascal string with a 4-byte length.
+    FIXED_PSTRING,  // arg: maximum length; always occupies 1 + arg bytes.
+    FIXED_CSTRING,  // arg: size.
+    HEX,            // arg: size.
+    HEX_TO_END,
+    SKIP,   // arg: size.
+    ALIGN,  // arg: alignment.
+    RECT,
+    POINT,
+    COLOR,
+    COUNT,          // arg: size; param: 1 if the count is one less than the number of items.
+    LIST_TO_END,    // arg: index of the op after the matching LIST_END.
+    LIST_TO_ZERO,   // arg: index of the op after the matching LIST_END.
+    LIST_COUNTED,   // arg: index of the op after the matching LIST_END.
+    LIST_END,       // arg: index of the first op of the list's body.
+    MAP_BEGIN,      // arg: key width.
+    MAP_END,
+};
+
+enum Padding : uint8_t {
+    UNPADDED = 0,
+    EVEN     = 1,
+    ODD      = 2,
+};
+
+const uint16_t kNoKey = 0xffff;
+
+struct FieldType {
+    const char* code;
+    Code        op;
+    uint8_t     param;
+    uint32_t    arg;
+};
+
+const FieldType kFieldTypes[] = {
+        {"DBYT", INT8, 0, 0},      {"DWRD", INT16, 0, 0},      {"DLNG", INT32, 0, 0},
+        {"UBYT", UINT8, 0, 0},     {"UWRD", UINT16, 0, 0},     {"ULNG", UINT32, 0, 0},
+        {"HBYT", UINT8, 0, 0},     {"HWRD", UINT16, 0, 0},     {"HLNG", UINT32, 0, 0},
+        {"BOOL", BOOLEAN, 0, 0},   {"CHAR", CHAR, 0, 0},       {"TNAM", TYPE_NAME, 0, 0},
+        {"PSTR", PSTRING, 0, 0},   {"ESTR", PSTRING, EVEN, 0}, {"OSTR", PSTRING, ODD, 0},
+        {"CSTR", CSTRING, 0, 0},   {"ECST", CSTRING, EVEN, 0}, {"OCST", CSTRING, ODD, 0},
+        {"WSTR", WSTRING, 0, 0},   {"LSTR", LSTRING, 0, 0},    {"HEXD", HEX_TO_END, 0, 0},
+        {"FBYT", SKIP, 0, 1},      {"FWRD", SKIP, 0, 2},       {"FLNG", SKIP, 0, 4},
+        {"AWRD", ALIGN, 0, 2},     {"ALNG", ALIGN, 0, 4},      {"RECT", RECT, 0, 0},
+        {"PNT ", POINT, 0, 0},     {"COLR", COLOR, 0, 0},      {"OCNT", COUNT, 0, 2},
+        {"ZCNT", COUNT, 1, 2},     {"BCNT", COUNT, 0, 1},      {"LCNT", COUNT, 0, 4},
+        {"LZCT", COUNT, 1, 4},
+};
+
+// Parses the 3 hex digits of a field type like "H00A".
+bool parse_size(pn::string_view digits, uint32_t* size) {
+    if (digits.size() != 3) {
+        return false;
+    }
+    *size = 0;
+    for (int i = 0; i < 3; ++i) {
+        const char ch = digits.data()[i];
+        *size <<= 4;
+        if ((ch >= '0') && (ch <= '9')) {
+            *size |= ch - '0';
+        } else if ((ch >= 'A') && (ch <= 'F')) {
+            *size |= ch - 'A' + 10;
+        } else if ((ch >= 'a') && (ch <= 'f')) {
+            *size |= ch - 'a' + 10;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Finds how to read a field of type `type`.  Lists, CASE, and BBIT are handled by the compiler.
+bool find_field_type(pn::string_view type, FieldType* out) {
+    for (const FieldType& t : kFieldTypes) {
+        if (type == t.code) {
+            *out = t;
+            return true;
+        }
+    }
+    uint32_t size;
+    if ((type.size() != 4) || !parse_size(type.substr(1), &size)) {
+        return false;
+    }
+    switch (type.data()[0]) {
+        case 'H': *out = FieldType{"Hnnn", HEX, 0, size}; return true;
+        case 'C': *out = FieldType{"Cnnn", FIXED_CSTRING, 0, size}; return true;
+        case 'P': *out = FieldType{"Pnnn", FIXED_PSTRING, 0, size}; return true;
+        case 'F': *out = FieldType{"Fnnn", SKIP, 0, size}; return true;
+        default: return false;
+    }
+}
+
+bool is_list(pn::string_view type) {
+    return (type == "LSTB") || (type == "LSTZ") || (type == "LSTC");
+}
+
+// Returns true for fields which are read but not written.
+bool is_hidden(Code code) { return (code == SKIP) || (code == ALIGN) || (code == COUNT); }
+
+bool is_integer(Code code) { return code <= UINT32; }
+
+// Parses the value of a CASE field, which may be decimal or, prefixed with "$", hexadecimal.
+int64_t parse_case_value(pn::string_view s) {
+    bool    negative = false;
+    int     base     = 10;
+    int     i        = 0;
+    int64_t value    = 0;
+    if ((i < s.size()) && (s.data()[i] == '-')) {
+        negative = true;
+        ++i;
+    }
+    if ((i < s.size()) && (s.data()[i] == '$')) {
+        base = 16;
+        ++i;
+    }
+    if (i == s.size()) {
+        throw std::runtime_error(pn::format("invalid CASE value \"{0}\"", s).c_str());
+    }
+    for (; i < s.size(); ++i) {
+        const char ch = s.data()[i];
+        int        digit;
+        if ((ch >= '0') && (ch <= '9')) {
+            digit = ch - '0';
+        } else if ((base == 16) && (ch >= 'A') && (ch <= 'F')) {
+            digit = ch - 'A' + 10;
+        } else if ((base == 16) && (ch >= 'a') && (ch <= 'f')) {
+            digit = ch - 'a' + 10;
+        } else {
+            throw std::runtime_error(pn::format("invalid CASE value \"{0}\"", s).c_str());
+        }
+        value = (value * base) + digit;
+    }
+    return negative ? -value : value;
+}
+
+// Reads the fields of a resource, in order.
+class Reader {
+  public:
+    explicit Reader(pn::data_view in) : _data(in.data()), _size(in.size()), _pos(0) {}
+
+    bool at_end() const { return _pos == _size; }
+    int  pos() const { return _pos; }
+
+    pn::data_view take(int size) {
+        if (size > (_size - _pos)) {
+            throw std::runtime_error("resource is too short for its template");
+        }
+        pn::data_view result{_data + _pos, size};
+        _pos += size;
+        return result;
+    }
+
+    pn::data_view rest() { return take(_size - _pos); }
+
+    uint8_t peek() const {
+        if (at_end()) {
+            throw std::runtime_error("resource is too short for its template");
+        }
+        return _data[_pos];
+    }
+
+    uint32_t unsigned_int(int size) {
+        pn::data_view bytes = take(size);
+        uint32_t      value = 0;
+        for (int i = 0; i < size; ++i) {
+            value = (value << 8) | bytes[i];
+        }
+        return value;
+    }
+
+    // Reads a C string: bytes up to a NUL, which is consumed but not returned, or to the end of
+    // the resource.
+    pn::data_view c_string() {
+        const uint8_t* nul = std::find(_data + _pos, _data + _size, 0);
+        pn::data_view  s   = take(nul - (_data + _pos));
+        if (!at_end()) {
+            take(1);
+        }
+        return s;
+    }
+
+    // Skips a byte if needed, so that a string which started at `start` has an even or odd size.
+    void pad(uint8_t padding, int start) {
+        const bool even = ((_pos - start) % 2) == 0;
+        if (((padding == EVEN) && !even) || ((padding == ODD) && even)) {
+            take(1);
+        }
+    }
+
+  private:
+    const uint8_t* _data;
+    int            _size;
+    int            _pos;
+};
+
+pn::string hex(pn::data_view bytes) {
+    static const char kDigits[] = "0123456789abcdef";
+    vector<char>      result(bytes.size() * 2);
+    for (int i = 0; i < bytes.size(); ++i) {
+        result[2 * i]     = kDigits[bytes[i] >> 4];
+        result[2 * i + 1] = kDigits[bytes[i] & 0xf];
+    }
+    return pn::string_view{result.data(), static_cast<int>(result.size())}.copy();
+}
+
+}  // namespace
+
+struct Template::Field {
+    pn::string label;
+    pn::string type;
+};
+
+// A single instruction of a compiled template.  If `key` is not kNoKey, the op's value is
+// preceded by that key of the enclosing map.  If `cases` is nonzero, an integer op's value is
+// replaced by a name from `_cases[cases - 1]`, if one matches.
+struct Template::Op {
+    Code     code;
+    uint8_t  param;
+    uint16_t key;
+    uint16_t cases;
+    uint32_t arg;
+};
+
+struct Template::Case {
+    int64_t    value;
+    pn::string name;
+};
+
+Template::Template(pn::data_view in, const Options& options) : _options(options) {
+    vector<Field> fields;
+    for (int offset = 0; offset < in.size();) {
+        const int length = in[offset];
+        if ((offset + 1 + length + 4) > in.size()) {
+            throw std::runtime_error("'TMPL' field extends past end of resource");
+        }
+        fields.push_back(
+                Field{options.decode(in.slice(offset + 1, length)),
+                      macroman::decode(in.slice(offset + 1 + length, 4))});
+        offset += 1 + length + 4;
+    }
+    compile(fields, 0, fields.size());
+}
+
+Template::~Template() {}
+
+// Compiles the fields [begin, end) of one level of the template.
+//
+// First, the visible fields of the level are counted, to decide whether the level is written as
+// a map or as a single value.  Then each field is compiled in turn, recursing into the bodies of
+// lists.
+void Template::compile(const vector<Field>& fields, size_t begin, size_t end) {
+    int    visible = 0;
+    bool   labeled = false;
+    size_t width   = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const Field& field = fields[i];
+        if (field.type == "CASE") {
+            continue;
+        } else if (field.type == "LSTE") {
+            throw std::runtime_error("unexpected LSTE in 'TMPL' resource");
+        } else if (is_list(field.type)) {
+            i = list_end(fields, i, end);
+        } else {
+            FieldType t;
+            if (find_field_type(field.type, &t) && is_hidden(t.op)) {
+                continue;
+            }
+        }
+        ++visible;
+        labeled = labeled || (field.label.size() > 0);
+        width   = std::max<size_t>(
+                width, Emitter::key_width(field.label.size() ? field.label : field.type));
+    }
+
+    const bool is_map = (visible != 1) || labeled;
+    if (is_map) {
+        _ops.push_back(Op{MAP_BEGIN, 0, kNoKey, 0, static_cast<uint32_t>(width)});
+    }
+    for (size_t i = begin; i < end; ++i) {
+        const Field& field = fields[i];
+        if (field.type == "CASE") {
+            pn::string_view label = field.label;
+            int             eq    = label.find(pn::rune{'='});
+            if (_ops.empty() || !is_integer(_ops.back().code) || (eq < 0)) {
+                throw std::runtime_error("invalid CASE in 'TMPL' resource");
+            }
+            Op& op = _ops.back();
+            if (!op.cases) {
+                _cases.emplace_back();
+                op.cases = _cases.size();
+            }
+            _cases[op.cases - 1].push_back(
+                    Case{parse_case_value(label.substr(eq + 1)), label.substr(0, eq).copy()});
+        } else if (is_list(field.type)) {
+            const size_t body_end = list_end(fields, i, end);
+            const Code   code     = (field.type == "LSTB")
+                                            ? LIST_TO_END
+                                            : (field.type == "LSTZ") ? LIST_TO_ZERO : LIST_COUNTED;
+            const size_t list     = _ops.size();
+            check_bits();
+            _ops.push_back(Op{code, 0, add_key(field, is_map), 0, 0});
+            compile(fields, i + 1, body_end);
+            _ops.push_back(Op{LIST_END, 0, kNoKey, 0, static_cast<uint32_t>(list + 1)});
+            _ops[list].arg = _ops.size();
+            i              = body_end;
+        } else {
+            compile_field(field, add_key(field, is_map));
+        }
+    }
+    check_bits();
+    if (is_map) {
+        _ops.push_back(Op{MAP_END, 0, kNoKey, 0, 0});
+    }
+}
+
+// Checks that the last op doesn't end a group of BBIT fields partway through a byte.  The byte is
+// consumed by the op for its last bit, bit 0, so a shorter group would leave it to be misread as
+// the next field.
+void Template::check_bits() const {
+    if (!_ops.empty() && (_ops.back().code == BIT) && (_ops.back().param > 0)) {
+        throw std::runtime_error("BBIT fields in 'TMPL' resource must come in groups of 8");
+    }
+}
+
+// Finds the LSTE ending the list which starts at `begin`.
+size_t Template::list_end(const vector<Field>& fields, size_t begin, size_t end) {
+    int depth = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (is_list(fields[i].type)) {
+            ++depth;
+        } else if ((fields[i].type == "LSTE") && (--depth == 0)) {
+            return i;
+        }
+    }
+    throw std::runtime_error("list in 'TMPL' resource has no LSTE");
+}
+
+// Returns the key to write before `field`, if the level it is in is written as a map.  Fields
+// without labels are keyed by their type.
+uint16_t Template::add_key(const Field& field, bool is_map) {
+    if (!is_map) {
+        return kNoKey;
+    }
+    _keys.push_back((field.label.size() ? field.label : field.type).copy());
+    return _keys.size() - 1;
+}
+
+void Template::compile_field(const Field& field, uint16_t key) {
+    FieldType t;
+    if (field.type != "BBIT") {
+        check_bits();
+    }
+    if (find_field_type(field.type, &t)) {
+        _ops.push_back(Op{t.op, t.param, is_hidden(t.op) ? kNoKey : key, 0, t.arg});
+        return;
+    } else if (field.type == "BBIT") {
+        // Bits are numbered from the most significant; a group of 8 fills a byte.
+        uint8_t bit = 7;
+        if (!_ops.empty() && (_ops.back().code == BIT) && (_ops.back().param > 0)) {
+            bit = _ops.back().param - 1;
+        }
+        _ops.push_back(Op{BIT, bit, key, 0, 0});
+        return;
+    }
+    throw std::runtime_error(
+            pn::format("unsupported field type {0} in 'TMPL' resource",
+                       pn::dump(field.type, pn::dump_short))
+                    .c_str());
+}
+
+void Template::emit(Emitter& out, pn::data_view in) const {
+    Reader          r(in);
+    int64_t         count = -1;  // set by the last COUNT, for the next LIST_COUNTED.
+    vector<int64_t> lists;       // remaining items of each list being read.
+
+    // Returns true if the list at `list` has another item, consuming its terminator if not.
+    auto more = [&r, &lists](const Op& list) {
+        switch (list.code) {
+            case LIST_TO_END: return !r.at_end();
+            case LIST_TO_ZERO:
+                if (r.peek() == 0) {
+                    r.take(1);
+                    return false;
+                }
+                return true;
+            default: return (lists.back()-- > 0);
+        }
+    };
+
+    for (size_t pc = 0; pc < _ops.size(); ++pc) {
+        const Op& op = _ops[pc];
+        if (op.key != kNoKey) {
+            out.key(_keys[op.key]);
+        }
+
+        int64_t integer;
+        switch (op.code) {
+            case INT8: integer = static_cast<int8_t>(r.unsigned_int(1)); break;
+            case INT16: integer = static_cast<int16_t>(r.unsigned_int(2)); break;
+            case INT32: integer = static_cast<int32_t>(r.unsigned_int(4)); break;
+            case UINT8: integer = r.unsigned_int(1); break;
+            case UINT16: integer = r.unsigned_int(2); break;
+            case UINT32: integer = r.unsigned_int(4); break;
+
+            case BOOLEAN: out.boolean(r.unsigned_int(2) != 0); continue;
+            case BIT:
+                out.boolean((r.peek() >> op.param) & 1);
+                if (op.param == 0) {
+                    r.take(1);
+                }
+                continue;
+            case CHAR: out.value(_options.decode(r.take(1))); continue;
+            case TYPE_NAME: out.value(macroman::decode(r.take(4))); continue;
+
+            case PSTRING: {
+                const int start = r.pos();
+                out.value(_options.decode(r.take(r.unsigned_int(1))));
+                r.pad(op.param, start);
+                continue;
+            }
+            case CSTRING: {
+                const int start = r.pos();
+                out.value(_options.decode(r.c_string()));
+                r.pad(op.param, start);
+                continue;
+            }
+            case WSTRING: out.value(_options.decode(r.take(r.unsigned_int(2)))); continue;
+            case LSTRING: out.value(_options.decode(r.take(r.unsigned_int(4)))); continue;
+            case FIXED_PSTRING: {
+                pn::data_view s = r.take(1 + op.arg);
+                if (s[0] > op.arg) {
+                    throw std::runtime_error("string is longer than its field");
+                }
+                out.value(_options.decode(s.slice(1, s[0])));
+                continue;
+            }
+            case FIXED_CSTRING: {
+                pn::data_view  s   = r.take(op.arg);
+                const uint8_t* nul = std::find(s.data(), s.data() + s.size(), 0);
+                out.value(_options.decode(s.slice(0, nul - s.data())));
+                continue;
+            }
+            case HEX: out.value(hex(r.take(op.arg))); continue;
+            case HEX_TO_END: out.value(hex(r.rest())); continue;
+
+            case SKIP: r.take(op.arg); continue;
+            case ALIGN: r.take((op.arg - (r.pos() % op.arg)) % op.arg); continue;
+
+            case RECT:
+                out.begin_map(6);
+                for (const char* side : {"top", "left", "bottom", "right"}) {
+                    out.key(side);
+                    out.value(int64_t{static_cast<int16_t>(r.unsigned_int(2))});
+                }
+                out.end_map();
+                continue;
+            case POINT:
+                out.begin_map(1);
+                for (const char* axis : {"v", "h"}) {
+                    out.key(axis);
+                    out.value(int64_t{static_cast<int16_t>(r.unsigned_int(2))});
+                }
+                out.end_map();
+                continue;
+            case COLOR: {
+                Color color;
+                color.red   = r.unsigned_int(2);
+                color.green = r.unsigned_int(2);
+                color.blue  = r.unsigned_int(2);
+                rezin::emit(out, color);
+                continue;
+            }
+
+            case COUNT: count = r.unsigned_int(op.arg) + op.param; continue;
+            case LIST_TO_END:
+            case LIST_TO_ZERO:
+            case LIST_COUNTED:
+                if (op.code == LIST_COUNTED) {
+                    if (count < 0) {
+                        throw std::runtime_error("counted list in 'TMPL' has no count");
+                    }
+                    lists.push_back(count);
+                    count = -1;
+                } else {
+                    lists.push_back(0);
+                }
+                out.begin_array();
+                if (!more(op)) {
+                    lists.pop_back();
+                    out.end_array();
+                    pc = op.arg - 1;
+                }
+                continue;
+            case LIST_END:
+                if (more(_ops[op.arg - 1])) {
+                    pc = op.arg - 1;
+                } else {
+                    lists.pop_back();
+                    out.end_array();
+                }
+                continue;
+
+            case MAP_BEGIN: out.begin_map(op.arg); continue;
+            case MAP_END: out.end_map(); continue;
+        }
+
+        if (op.cases) {
+            const vector<Case>& cases = _cases[op.cases - 1];
+            auto it = std::find_if(cases.begin(), cases.end(), [integer](const Case& c) {
+                return c.value == integer;
+            });
+            if (it != cases.end()) {
+                out.value(it->name);
+                continue;
+            }
+        }
+        out.value(integer);
+    }
+
+    if (!r.at_end()) {
+        throw std::runtime_error("extra bytes at end of resource");
+    }
+}
+
+// A 'TMPL' resource is named after the type it describes.
+unique_ptr<Template> find_template(
+        const ResourceFork& rsrc, pn::string_view type, const Options& options) {
+    for (const ResourceType& t : rsrc) {
+        if (t.code() != "TMPL") {
+            continue;
+        }
+        for (const ResourceEntry& entry : t) {
+            if (entry.name() == type) {
+                return unique_ptr<Template>(new Template(entry.data(), options));
+            }
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace rezin
@@ -17,10 +17,15 @@
 
 from __future__ import absolute_import, division, print_function, unicode_literals
 
+import binascii
 import collections
 import os
+import shutil
+import struct
 import subprocess
 import sys
+import zipfile
+import zlib
 
 TEST = os.path.dirname(os.path.realpath(__file__))
 ROOT = os.path.dirname(TEST)
@@ -53,6 +58,40 @@ def test_ls(source):
     assert ls("TMPL", 128) == ("128\tTMPL\n")
 
 
+def test_ls_long(source):
+    ls = lambda *args: subprocess.check_output(source + ["--long", "ls"] + list(map(str, args))).decode("utf-8")
+
+    assert ls() == ("PICT\t1\n"
+                    "RECT\t2\n"
+                    "STR#\t2\n"
+                    "TEXT\t3\n"
+                    "TMPL\t7\n"
+                    "cicn\t2\n"
+                    "clut\t1\n"
+                    "snd \t1\n"
+                    "url \t1\n"
+                    "vers\t1\n")
+    assert ls("STR#") == ("128\t33\t{strings: 5}\tFive strings\n"
+                          "129\t2\t{strings: 0}\tEmpty\n")
+    assert ls("clut", 128) == ("128\t32\t{colors: 3}\tRGB\n")
+
+    # Sample rates are floats, so compare fields by value, not by how they are printed.
+    def entry(*args):
+        id, size, info, name = ls(*args).rstrip("\n").split("\t")
+        assert info.startswith("{") and info.endswith("}")
+        fields = dict(field.split(": ") for field in info[1:-1].split(", "))
+        return int(id), int(size), {k: float(v) for k, v in fields.items()}, name
+
+    assert entry("PICT", 128) == (128, 11860, {"width": 350, "height": 300, "version": 2}, "Ozma")
+    assert entry("cicn", 128) == (
+            128, 626, {"width": 32, "height": 32, "depth": 2, "pixel_type": 0},
+            "Circle with red border")
+    assert entry("cicn", 129)[2]["depth"] == 8
+    assert entry("snd ", 128) == (
+            128, 19087, {"channels": 1, "sample_bits": 8, "sample_rate": 44100, "samples": 19050},
+            "Coin")
+
+
 def test_cat(source):
     cat = lambda *args: subprocess.check_output(source + ["cat"] + list(map(str, args)))
 
@@ -89,18 +128,425 @@ def test_convert_clut(source):
                                     "2:  {r: 0.0, g: 0.0, b: 255.0}\n")
 
 
+def test_convert_json(source):
+    convert = lambda *args: subprocess.check_output(source + ["--format=json", "convert"] + list(map(str, args))).decode("utf-8")
+
+    assert convert("STR#", 128) == ('[\n'
+                                    '  "STR#",\n'
+                                    '  "String",\n'
+                                    '  "List",\n'
+                                    '  "resource",\n'
+                                    '  "type"\n'
+                                    ']\n')
+    assert convert("clut", 128) == ('{\n'
+                                    '  "0": {"r": 255.0, "g": 0.0, "b": 0.0},\n'
+                                    '  "1": {"r": 0.0, "g": 255.0, "b": 0.0},\n'
+                                    '  "2": {"r": 0.0, "g": 0.0, "b": 255.0}\n'
+                                    '}\n')
+
+
+def test_convert_tmpl(source):
+    convert = lambda *args: subprocess.check_output(source + ["convert"] + list(map(str, args))).decode("utf-8")
+
+    assert convert("RECT", 128) == ("top:     0\n"
+                                    "left:    0\n"
+                                    "bottom:  32\n"
+                                    "right:   32\n")
+    assert convert("url ", 128) == "\"https://arescentral.org/\"\n"
+    assert convert("vers", 128) == ("major:     16\n"
+                                    "minor:     96\n"
+                                    "stage:     0\n"
+                                    "build:     9\n"
+                                    "language:  0\n"
+                                    "abbr:      \"9.0b16\"\n"
+                                    "info:      \"Version 9.0 *BETA 16*\"\n")
+
+
+def test_convert_tmpl_fields(tmp_path):
+    tmpl = lambda *fields: b"".join(bytes([len(label)]) + label + type for label, type in fields)
+    bits = [(b"b%d" % i, b"BBIT") for i in range(8)]
+    rsrc = os.path.join(tmp_path, "tmpl.rsrc")
+    with open(rsrc, "wb") as f:
+        f.write(resource_fork([
+            (b"TMPL", 128, tmpl((b"Two words", b"DWRD"), *bits, (b"x", b"DBYT")), b"TEST"),
+            (b"TMPL", 129, tmpl(*bits[:3], (b"x", b"DBYT")), b"BAD1"),
+            (b"TMPL", 130, tmpl(*bits[:3]), b"BAD2"),
+            (b"TEST", 128, b"\x00\x05\xa0\x07"),
+            (b"BAD1", 128, b"\xa0\x07"),
+            (b"BAD2", 128, b"\xa0"),
+        ]))
+    convert = lambda *args: subprocess.check_output([REZIN, "-f", rsrc, "convert"] + list(map(str, args))).decode("utf-8")
+
+    # Quoted keys are aligned by their quoted width.
+    assert convert("TEST", 128) == ("\"Two words\":  5\n"
+                                    "b0:           true\n"
+                                    "b1:           false\n"
+                                    "b2:           true\n"
+                                    "b3:           false\n"
+                                    "b4:           false\n"
+                                    "b5:           false\n"
+                                    "b6:           false\n"
+                                    "b7:           false\n"
+                                    "x:            7\n")
+    for type in ["BAD1", "BAD2"]:
+        assert subprocess.call([REZIN, "-f", rsrc, "convert", type, "128"], stderr=subprocess.DEVNULL) != 0
+
+
 def test_convert_snd(source):
     convert = lambda *args: subprocess.check_output(source + ["convert"] + list(map(str, args)))
 
     assert convert("snd ", 128) == open(os.path.join(TEST, "coin.aiff"), "rb").read()
 
 
+def test_convert_snd_sample_rate(source):
+    convert = lambda *args: subprocess.check_output(source + ["--audio-format=wav", "--sample-rate=22050", "convert"] + list(map(str, args)))
+
+    wav = convert("snd ", 128)
+    assert wav[20:36] == struct.pack("<HHIIHH", 1, 1, 22050, 44100, 2, 16)
+    assert wav[36:44] == b"data" + struct.pack("<I", 9525 * 2)
+    assert len(wav) == 44 + 9525 * 2
+
+
+def test_convert_snd_track(source):
+    convert = lambda *args: subprocess.check_output(source + ["--track=0", "convert"] + list(map(str, args)))
+
+    assert convert("snd ", 128) == open(os.path.join(TEST, "coin.aiff"), "rb").read()
+
+
+def test_convert_snd_wav(source):
+    convert = lambda fmt, *args: subprocess.check_output(source + ["--audio-format=" + fmt, "convert"] + list(map(str, args)))
+
+    wav = open(os.path.join(TEST, "coin.wav"), "rb").read()
+    assert convert("wav", "snd ", 128) == wav
+    assert convert("raw", "snd ", 128) == wav[44:]
+
+
+def resource_fork(resources):
+    """Builds a flat resource fork holding `resources`, a list of (type, id, data) tuples.
+
+    A tuple may have a fourth element, the name of the resource.
+    """
+    types = collections.OrderedDict()
+    data = bytearray()
+    names = bytearray()
+    for code, id, content, *name in resources:
+        name_offset = len(names) if name else 0xffff
+        if name:
+            names += bytes([len(name[0])]) + name[0]
+        types.setdefault(code, []).append(struct.pack(">hHI4x", id, name_offset, len(data)))
+        data += struct.pack(">I", len(content)) + content
+
+    type_list = struct.pack(">H", len(types) - 1)
+    refs = b""
+    for code, entries in types.items():
+        type_list += code + struct.pack(">HH", len(entries) - 1, 2 + 8 * len(types) + len(refs))
+        refs += b"".join(entries)
+    resource_map = bytes(24) + struct.pack(">HH", 28, 28 + len(type_list) + len(refs))
+    resource_map += type_list + refs + names
+    header = struct.pack(">IIII", 256, 256 + len(data), len(data), len(resource_map))
+    return header + bytes(240) + bytes(data) + resource_map
+
+
+def noise(size, seed):
+    """Returns `size` bytes of deterministic noise."""
+    out = bytearray()
+    for _ in range(size):
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff
+        out.append((seed >> 16) & 0xff)
+    return bytes(out)
+
+
+def snd_resource(header, data):
+    """Builds a format 1 'snd ' resource which plays the sound with `header` and `data`."""
+    return struct.pack(">HHHIHHHI", 1, 1, 5, 0, 1, 0x8051, 0, 20) + header + data
+
+
+def extended_sound(channels, sample_size, data, rate=22050):
+    """Builds a 'snd ' resource with an extended sound header."""
+    frames = len(data) // (channels * sample_size // 8)
+    header = struct.pack(">IIIIIBBI10xIIIH14x", 0, channels, rate << 16, 0, 0, 0xff, 60, frames,
+                         0, 0, 0, sample_size)
+    return snd_resource(header, data)
+
+
+def compressed_sound(channels, fmt, compression_id, packets, data, rate=22050):
+    """Builds a 'snd ' resource with a compressed sound header."""
+    header = struct.pack(">IIIIIBBI10xI4sIIIhHHH", 0, channels, rate << 16, 0, 0, 0xfe, 60,
+                         packets, 0, fmt, 0, 0, 0, compression_id, 0, 0, 16)
+    return snd_resource(header, data)
+
+
+def test_convert_snd_headers(tmp_path):
+    ima4 = b"".join(struct.pack(">H", (i << 12) | (i * 20)) + noise(32, i) for i in range(4))
+    rsrc = os.path.join(tmp_path, "snd.rsrc")
+    with open(rsrc, "wb") as f:
+        f.write(resource_fork([
+            (b"snd ", 128, extended_sound(1, 8, noise(256, 1))),
+            (b"snd ", 129, compressed_sound(1, b"ima4", 0, 4, ima4)),
+            (b"snd ", 130, compressed_sound(1, b"\0\0\0\0", 3, 64, noise(128, 3))),
+            (b"snd ", 131, compressed_sound(2, b"MAC6", 0, 64, noise(128, 4))),
+        ]))
+    convert = lambda *args: subprocess.check_output([REZIN, "-f", rsrc, "convert"] + list(map(str, args)))
+
+    aiff = convert("snd ", 128)
+    assert aiff[20:28] == struct.pack(">hIh", 1, 256, 8)
+    assert aiff[54:] == bytes(b ^ 0x80 for b in noise(256, 1))
+    for id, name in [(129, "ima4.aiff"), (130, "mace3.aiff"), (131, "mace6.aiff")]:
+        assert convert("snd ", id) == open(os.path.join(TEST, name), "rb").read()
+
+
+def test_convert_snd_channels(tmp_path):
+    sounds = [(128, 2, 8), (129, 1, 16), (130, 2, 16)]
+    data = noise(244, 5)
+    rsrc = os.path.join(tmp_path, "snd.rsrc")
+    with open(rsrc, "wb") as f:
+        f.write(resource_fork([(b"snd ", id, extended_sound(channels, bits, data))
+                               for id, channels, bits in sounds]))
+    convert = lambda *args: subprocess.check_output([REZIN, "-f", rsrc] + list(map(str, args)))
+
+    swapped = b"".join(data[i + 1:i + 2] + data[i:i + 1] for i in range(0, len(data), 2))
+    for id, channels, bits in sounds:
+        block_align = channels * bits // 8
+        aiff = convert("convert", "snd ", id)
+        assert aiff[20:28] == struct.pack(">hIh", channels, len(data) // block_align, bits)
+        assert aiff[54:] == (bytes(b ^ 0x80 for b in data) if bits == 8 else data)
+
+        wav = convert("--audio-format=wav", "convert", "snd ", id)
+        assert wav[:44] == (b"RIFF" + struct.pack("<I", 36 + len(data)) + b"WAVEfmt " +
+                            struct.pack("<IHHIIHH", 16, 1, channels, 22050, 22050 * block_align,
+                                        block_align, bits) +
+                            b"data" + struct.pack("<I", len(data)))
+        assert wav[44:] == (data if bits == 8 else swapped)
+
+
+def test_atlas(source, tmp_path):
+    audio, index = str(tmp_path / "audio.pcm"), str(tmp_path / "index.bin")
+    subprocess.check_call(source + ["atlas", audio, index])
+
+    ssnd = open(os.path.join(TEST, "coin.aiff"), "rb").read()[54:]
+    assert open(audio, "rb").read() == b"".join(b"\000" + bytes([s]) for s in ssnd)
+    assert open(index, "rb").read() == (b"RZAT" + struct.pack("<III", 2, 1, 1) +
+                                        struct.pack("<HhHHIII", 0, 128, 1, 0, 44100 << 16, 0, len(ssnd)) +
+                                        struct.pack("<H", 0))
+
+
+def test_atlas_directory(tmp_path):
+    os.mkdir(os.path.join(tmp_path, "in"))
+    shutil.copy(os.path.join(TEST, "testdata.as"), os.path.join(tmp_path, "in", "a.as"))
+    shutil.copy(os.path.join(TEST, "testdata.rsrc"), os.path.join(tmp_path, "in", "b.rsrc"))
+    with open(os.path.join(tmp_path, "in", "c.rsrc"), "wb") as f:
+        f.write(resource_fork([(b"TEXT", 128, b"no sounds")]))
+    audio, index = str(tmp_path / "audio.pcm"), str(tmp_path / "index.bin")
+    subprocess.check_output([REZIN, "-d", str(tmp_path / "in"), "atlas", audio, index])
+
+    ssnd = open(os.path.join(TEST, "coin.aiff"), "rb").read()[54:]
+    pcm = b"".join(b"\000" + bytes([s]) for s in ssnd)
+    assert open(audio, "rb").read() == pcm + pcm
+    assert open(index, "rb").read() == (b"RZAT" + struct.pack("<III", 2, 2, 2) +
+                                        struct.pack("<HhHHIII", 0, 128, 1, 0, 44100 << 16, 0, len(ssnd)) +
+                                        struct.pack("<HhHHIII", 1, 128, 1, 0, 44100 << 16, len(ssnd), len(ssnd)) +
+                                        struct.pack("<H", 4) + b"a.as" + struct.pack("<H", 6) + b"b.rsrc")
+
+
 def test_convert_pict(source):
     convert = lambda *args: subprocess.check_output(source + ["convert"] + list(map(str, args)))
 
     assert convert("PICT", 128) == open(os.path.join(TEST, "ozma.png"), "rb").read()
 
 
+def test_convert_pict_max_size(source):
+    convert = lambda *args: subprocess.check_output(source + ["--max-size=128", "convert"] + list(map(str, args)))
+
+    png = convert("PICT", 128)
+    assert png[:8] == b"\x89PNG\r\n\x1a\n"
+    assert png[12:24] == b"IHDR\x00\x00\x00\x80\x00\x00\x00\x6d"
+    assert convert("cicn", 128) == open(os.path.join(TEST, "red-circle.png"), "rb").read()
+
+
+def pict(bounds, ops):
+    """Builds a version 2 'PICT' resource within `bounds` from `ops`, a list of (op, data) pairs."""
+    data = struct.pack(">H4hHH", 0, *bounds, 0x0011, 0x02ff)
+    data += struct.pack(">HHHII4hI", 0x0c00, 0xfffe, 0, 0x00480000, 0x00480000, *bounds, 0)
+    for op, operands in ops:
+        data += struct.pack(">H", op) + operands + bytes(len(operands) % 2)
+    return data + struct.pack(">H", 0x00ff)
+
+
+def png_pixels(png):
+    """Decodes an 8-bit RGBA PNG into rows of (red, green, blue, alpha) tuples."""
+    width, height = struct.unpack(">II", png[16:24])
+    data, i = b"", 8
+    while i < len(png):
+        size, kind = struct.unpack(">I4s", png[i:i + 8])
+        if kind == b"IDAT":
+            data += png[i + 8:i + 8 + size]
+        i += 12 + size
+    raw = zlib.decompress(data)
+
+    stride = 4 * width
+    rows, prev = [], bytes(stride)
+    for y in range(height):
+        start = y * (stride + 1)
+        kind, row = raw[start], bytearray(raw[start + 1:start + 1 + stride])
+        for x in range(stride):
+            a = row[x - 4] if x >= 4 else 0
+            b = prev[x]
+            c = prev[x - 4] if x >= 4 else 0
+            if kind == 1:
+                row[x] = (row[x] + a) & 0xff
+            elif kind == 2:
+                row[x] = (row[x] + b) & 0xff
+            elif kind == 3:
+                row[x] = (row[x] + (a + b) // 2) & 0xff
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                row[x] = (row[x] + (a if (pa <= pb) and (pa <= pc) else b if pb <= pc else c)) & 0xff
+        rows.append([tuple(row[x:x + 4]) for x in range(0, stride, 4)])
+        prev = row
+    return rows
+
+
+def test_convert_pict_vector(tmp_path):
+    rect = lambda *r: struct.pack(">4h", *r)
+    color = lambda *rgb: struct.pack(">3H", *rgb)
+    triangle = [(2, 12), (2, 18), (10, 12), (2, 12)]
+    poly = struct.pack(">H", 10 + 4 * len(triangle)) + rect(2, 12, 10, 18)
+    poly += b"".join(struct.pack(">hh", *p) for p in triangle)
+    # A tall bar at columns 0-3 and rows 21-28, with a wide bar at rows 25-28 out to column 9.
+    scanlines = struct.pack(">10h", 21, 0, 4, 0x7fff, 25, 4, 10, 0x7fff, 29, 0)
+    scanlines += struct.pack(">3h", 10, 0x7fff, 0x7fff)
+    l_shape = struct.pack(">H", 10 + len(scanlines)) + rect(21, 0, 29, 10) + scanlines
+    ops = [
+        (0x0002, bytes(8)),                    # BkPat
+        (0x0003, struct.pack(">H", 3)),        # TxFont
+        (0x0004, b"\x01"),                     # TxFace
+        (0x0008, struct.pack(">H", 8)),        # PnMode
+        (0x0009, b"\xff" * 8),                 # PnPat
+        (0x000a, b"\xff" * 8),                 # FillPat
+        (0x000b, struct.pack(">hh", 4, 4)),    # OvSize
+        (0x000d, struct.pack(">H", 12)),       # TxSize
+        (0x001a, color(0xffff, 0, 0)),         # RGBFgCol
+        (0x0031, rect(2, 2, 10, 10)),          # PaintRect
+        (0x0071, poly),                        # PaintPoly
+        (0x0041, rect(2, 20, 10, 30)),         # PaintRRect
+        (0x0081, struct.pack(">H", 10) + rect(12, 2, 20, 10)),  # PaintRgn
+        (0x0080, l_shape),                     # FrameRgn
+        (0x001a, color(0, 0xffff, 0)),         # RGBFgCol
+        (0x0051, rect(12, 12, 28, 28)),        # PaintOval
+        (0x001a, color(0, 0, 0xffff)),         # RGBFgCol
+        (0x0020, struct.pack(">4h", 30, 0, 30, 31)),  # Line
+    ]
+    bad_poly = [(0x0071, struct.pack(">H", 8) + rect(0, 0, 1, 1))]
+    bad_mode = [(0x0008, struct.pack(">H", 9)), (0x0031, rect(0, 0, 4, 4))]
+    bad_pattern = [(0x0009, b"\xaa\x55" * 4), (0x0031, rect(0, 0, 4, 4))]
+    white_pen = [(0x0009, bytes(8)), (0x0031, rect(0, 0, 4, 4))]
+    rsrc = os.path.join(tmp_path, "pict.rsrc")
+    with open(rsrc, "wb") as f:
+        f.write(resource_fork([(b"PICT", 128, pict((0, 0, 32, 32), ops)),
+                               (b"PICT", 129, pict((0, 0, 32, 32), bad_poly)),
+                               (b"PICT", 130, pict((0, 0, 32, 32), bad_mode)),
+                               (b"PICT", 131, pict((0, 0, 32, 32), bad_pattern)),
+                               (b"PICT", 132, pict((0, 0, 8, 8), white_pen))]))
+    convert = lambda *args: subprocess.check_output([REZIN, "-f", rsrc, "convert"] + list(map(str, args)))
+
+    red, green, blue, clear = (255, 0, 0, 255), (0, 255, 0, 255), (0, 0, 255, 255), (0, 0, 0, 0)
+    pixels = png_pixels(convert("PICT", 128))
+    assert len(pixels) == 32 and len(pixels[0]) == 32
+    assert pixels[5][5] == red
+    assert pixels[3][13] == red
+    assert pixels[8][17] == clear
+    assert pixels[5][25] == red  # the rounded rect at rows 2-9, columns 20-29.
+    assert pixels[3][20] == red
+    assert pixels[2][21] == red and pixels[2][28] == red
+    assert pixels[2][20] == clear and pixels[2][29] == clear
+    assert pixels[9][20] == clear and pixels[9][29] == clear
+    assert pixels[15][5] == red  # the painted region.
+    frame = {21: range(0, 4), 22: (0, 3), 23: (0, 3), 24: (0, 3), 25: (0, 3, 4, 5, 6, 7, 8, 9),
+             26: (0, 9), 27: (0, 9), 28: range(0, 10)}
+    for y, xs in frame.items():
+        for x in range(11):
+            assert pixels[y][x] == (red if x in xs else clear), (x, y)
+    assert pixels[20][20] == green
+    assert pixels[30][16] == blue
+    assert pixels[0][0] == clear
+    for id in [129, 130, 131]:
+        assert subprocess.call([REZIN, "-f", rsrc, "convert", "PICT", str(id)], stderr=subprocess.DEVNULL) != 0
+    white = (255, 255, 255, 255)
+    assert png_pixels(convert("PICT", 132)) == [[white] * 4 + [clear] * 4] * 4 + [[clear] * 8] * 4
+
+
+def test_convert_pict_regions(tmp_path):
+    rect = lambda *r: struct.pack(">4h", *r)
+    def region(bounds, *rows):
+        scanlines = b"".join(struct.pack(">%dh" % len(r), *r) for r in rows)
+        return struct.pack(">H", 10 + len(scanlines)) + rect(*bounds) + scanlines
+    pix_map = lambda row_bytes, pack_type, pixel_type, pixel_size, cmp_count, cmp_size: struct.pack(
+        ">H8sHHIIIHHHHIII", 0x8000 | row_bytes, rect(0, 0, 16, 16), 0, pack_type, 0, 0x00480000,
+        0x00480000, pixel_type, pixel_size, cmp_count, cmp_size, 0, 0, 0)
+    end = 0x7fff
+    # The top-left and bottom-right quarters, and all but columns 4 and 5.
+    mask = region((0, 0, 16, 16), (0, 0, 8, end), (8, 0, 16, end), (16, 8, 16, end), (end,))
+    clip = region((0, 0, 16, 16), (0, 0, 4, 6, 16, end), (16, 0, 4, 6, 16, end), (end,))
+
+    clut = struct.pack(">IHH4H4H", 0, 0, 1, 0, 0, 0, 0, 1, 0xffff, 0, 0)
+    pack_bits = (pix_map(16, 0, 0, 8, 1, 8) + clut + rect(0, 0, 16, 16) + rect(0, 0, 16, 16) +
+                 struct.pack(">h", 0) + mask + b"\x02\xf1\x01" * 16)
+    direct_bits = (struct.pack(">I", 0xff) + pix_map(64, 4, 16, 32, 3, 8) + rect(0, 0, 16, 16) +
+                   rect(0, 0, 16, 16) + struct.pack(">h", 0) + mask +
+                   b"\x06\xf1\x00\xf1\xff\xf1\x00" * 16)
+    rsrc = os.path.join(tmp_path, "pict.rsrc")
+    with open(rsrc, "wb") as f:
+        f.write(resource_fork([
+            (b"PICT", 128, pict((0, 0, 16, 16), [(0x0001, clip), (0x0099, pack_bits)])),
+            (b"PICT", 129, pict((0, 0, 16, 16), [(0x009b, direct_bits)])),
+        ]))
+    convert = lambda *args: subprocess.check_output([REZIN, "-f", rsrc, "convert"] + list(map(str, args)))
+
+    red, green, clear = (255, 0, 0, 255), (0, 255, 0, 255), (0, 0, 0, 0)
+    inside = lambda x, y: (x < 8) == (y < 8)
+    pixels = png_pixels(convert("PICT", 128))
+    for y in range(16):
+        for x in range(16):
+            assert pixels[y][x] == (red if inside(x, y) and x not in (4, 5) else clear), (x, y)
+    pixels = png_pixels(convert("PICT", 129))
+    for y in range(16):
+        for x in range(16):
+            assert pixels[y][x] == (green if inside(x, y) else clear), (x, y)
+
+
+def test_convert_pict_downscale(tmp_path):
+    rect = lambda *r: struct.pack(">4h", *r)
+    pix_map = struct.pack(">H8sHHIIIHHHHIII", 0x8000 | 8, rect(0, 0, 4, 8), 0, 0, 0, 0x00480000,
+                          0x00480000, 0, 8, 1, 8, 0, 0, 0)
+    clut = struct.pack(">IHH4H4H", 0, 0, 1, 0, 0xffff, 0, 0, 1, 0, 0, 0xffff)
+    # Index 0 is red, 1 is blue, and 2 is missing from the color table, so it's clear.
+    rows = [(0, 1, 0, 0, 2, 2, 0, 2), (1, 0, 0, 0, 2, 2, 1, 2), (0, 0, 1, 1, 0, 0, 0, 0),
+            (0, 0, 1, 1, 0, 0, 0, 0)]
+    pack_bits = (pix_map + clut + rect(0, 0, 4, 8) + rect(0, 0, 4, 8) + struct.pack(">h", 0) +
+                 b"".join(b"\x09\x07" + bytes(row) for row in rows))
+    rsrc = os.path.join(tmp_path, "pict.rsrc")
+    with open(rsrc, "wb") as f:
+        f.write(resource_fork([
+            (b"PICT", 128, pict((0, 0, 4, 8), [(0x0098, pack_bits)])),
+            # A pen pattern, which a lone image doesn't need, but which has to be checked.
+            (b"PICT", 129, pict((0, 0, 4, 8), [(0x0009, b"\xff" * 8), (0x0098, pack_bits)])),
+        ]))
+    convert = lambda *args: subprocess.check_output([REZIN, "-f", rsrc] + list(map(str, args)))
+
+    red, blue, clear = (255, 0, 0, 255), (0, 0, 255, 255), (0, 0, 0, 0)
+    colors = [red, blue, clear]
+    pixels = png_pixels(convert("convert", "PICT", 128))
+    assert pixels == [[colors[i] for i in row] for row in rows]
+
+    # Each pixel is the average of a 2x2 block, weighted by alpha, so that clear pixels don't
+    # darken their neighbors.
+    scaled = lambda id: convert("--max-size=4", "convert", "PICT", id)
+    pixels = png_pixels(scaled(128))
+    assert pixels == [[(128, 0, 128, 255), red, clear, (128, 0, 128, 128)], [red, blue, red, red]]
+    assert scaled(129) == scaled(128)
+
+
 def test_convert_cicn(source):
     convert = lambda *args: subprocess.check_output(source + ["convert"] + list(map(str, args)))
 
@@ -108,11 +554,295 @@ def test_convert_cicn(source):
     assert convert("cicn", 129) == open(os.path.join(TEST, "oz.png"), "rb").read()
 
 
+def test_zip_archive():
+    ls = lambda *args: subprocess.check_output([REZIN] + list(args) + ["ls"]).decode("utf-8")
+    archive = os.path.join(TEST, "testdata.zip")
+
+    expected = ("testdata.rsrc:\n"
+                "PICT\n"
+                "RECT\n"
+                "STR#\n"
+                "TEXT\n"
+                "TMPL\n"
+                "cicn\n"
+                "clut\n"
+                "snd \n"
+                "url \n"
+                "vers\n")
+    assert ls("-Z", archive) == expected
+    assert ls("-Z", archive, "-j", "2") == expected
+    assert ls("-Z", archive, "-W", "1") == expected
+
+
+def test_zip_window_corrupt(tmp_path):
+    # The data of TEXT 128 claims to be nearly 4 GiB long; it must be rejected, not allocated.
+    rsrc = bytearray(resource_fork([(b"TEXT", 128, b"text")]))
+    data_offset = struct.unpack(">I", rsrc[0:4])[0]
+    rsrc[data_offset:data_offset + 4] = struct.pack(">I", 0xfffffff0)
+    double = struct.pack(">II16sHIII", 0x00051607, 0x00020000, bytes(16), 1, 2, 38, len(rsrc))
+    archive = os.path.join(tmp_path, "corrupt.zip")
+    with zipfile.ZipFile(archive, "w", zipfile.ZIP_DEFLATED) as z:
+        z.writestr("__MACOSX/._corrupt", double + bytes(rsrc))
+
+    source = [REZIN, "-W", "1", "-z", archive + ",corrupt"]
+    assert subprocess.check_output(source + ["ls"]) == b"TEXT\n"
+    cat = subprocess.run(source + ["cat", "TEXT", "128"], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert cat.returncode != 0
+    assert b"past end of fork" in cat.stderr
+
+
+def test_directory(tmp_path):
+    ls = lambda *args: subprocess.check_output([REZIN] + list(args) + ["ls"]).decode("utf-8")
+    os.mkdir(os.path.join(tmp_path, "a"))
+    shutil.copy(os.path.join(TEST, "testdata.as"), os.path.join(tmp_path, "a", "testdata.as"))
+    shutil.copy(os.path.join(TEST, "testdata.rsrc"), os.path.join(tmp_path, "b.rsrc"))
+    shutil.copy(os.path.join(TEST, "oz.png"), os.path.join(tmp_path, "c.png"))
+
+    types = ("PICT\n"
+             "RECT\n"
+             "STR#\n"
+             "TEXT\n"
+             "TMPL\n"
+             "cicn\n"
+             "clut\n"
+             "snd \n"
+             "url \n"
+             "vers\n")
+    expected = "a/testdata.as:\n" + types + "\nb.rsrc:\n" + types
+    assert ls("-d", str(tmp_path)) == expected
+    assert ls("-d", str(tmp_path), "-j", "4", "--max-open=1") == expected
+
+
+def macbinary(name, rsrc, version=129):
+    """Encodes a file with no data fork as MacBinary."""
+    header = bytearray(128)
+    header[1] = len(name)
+    header[2:2 + len(name)] = name
+    header[65:73] = b"rsrcRSED"
+    struct.pack_into(">II", header, 83, 0, len(rsrc))
+    header[122:124] = bytes([version, 129])
+    struct.pack_into(">H", header, 124, binascii.crc_hqx(bytes(header[:124]), 0))
+    return bytes(header) + rsrc + bytes(-len(rsrc) % 128)
+
+
+def binhex(name, rsrc, rsrc_size=None):
+    """Encodes a file with no data fork as BinHex 4.0.
+
+    If `rsrc_size` is given, the header claims that size for the resource fork, instead of its own.
+    """
+    def with_crc(data):
+        return data + struct.pack(">H", binascii.crc_hqx(data, 0))
+    if rsrc_size is None:
+        rsrc_size = len(rsrc)
+    header = bytes([len(name)]) + name + b"\0rsrcRSED\0\0" + struct.pack(">II", 0, rsrc_size)
+    decoded = with_crc(header) + with_crc(b"") + with_crc(rsrc)
+
+    packed = bytearray()
+    i = 0
+    while i < len(decoded):
+        run = 1
+        while (i + run < len(decoded)) and (decoded[i + run] == decoded[i]) and (run < 255):
+            run += 1
+        packed += b"\x90\0" if decoded[i] == 0x90 else decoded[i:i + 1]
+        if run > 2:
+            packed += bytes([0x90, run])
+        else:
+            run = 1
+        i += run
+    packed += bytes(-len(packed) % 3)
+
+    alphabet = b"!\"#$%&'()*+,-012345689@ABCDEFGHIJKLMNPQRSTUVXYZ[`abcdefhijklmpqr"
+    text = bytearray(b":")
+    for i in range(0, len(packed), 3):
+        group = int.from_bytes(packed[i:i + 3], "big")
+        text += bytes(alphabet[(group >> shift) & 0x3f] for shift in (18, 12, 6, 0))
+    text += b":"
+    lines = [text[i:i + 64] for i in range(0, len(text), 64)]
+    return b"(This file must be converted with BinHex 4.0)\r\n\r\n" + b"\r\n".join(lines) + b"\r\n"
+
+
+def test_encodings(tmp_path):
+    ls = lambda *args: subprocess.check_output([REZIN] + list(args) + ["ls"]).decode("utf-8")
+    with open(os.path.join(TEST, "testdata.rsrc"), "rb") as f:
+        rsrc = f.read()
+    mac_binary = os.path.join(tmp_path, "testdata.bin")
+    with open(mac_binary, "wb") as f:
+        f.write(macbinary(b"testdata", rsrc))
+    bin_hex = os.path.join(tmp_path, "testdata.hqx")
+    with open(bin_hex, "wb") as f:
+        f.write(binhex(b"testdata", rsrc))
+
+    expected = ls("-f", os.path.join(TEST, "testdata.rsrc"))
+    assert ls("-b", mac_binary) == expected
+    assert ls("-x", bin_hex) == expected
+    for path in [mac_binary, bin_hex, os.path.join(TEST, "testdata.as")]:
+        assert ls("-i", path) == expected
+    assert ls("-d", str(tmp_path)) == "testdata.bin:\n" + expected + "\ntestdata.hqx:\n" + expected
+
+    # A resource fork longer than the text could hold is rejected before it is allocated.
+    huge = subprocess.run([REZIN, "-", "ls"], input=binhex(b"huge", b"rsrc", rsrc_size=0xf0000000),
+                          stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert huge.returncode != 0
+    assert b"longer than the file could hold" in huge.stderr
+
+
+def test_stdin():
+    ls = lambda *args, **kwargs: subprocess.check_output(
+        [REZIN] + list(args) + ["ls"], **kwargs).decode("utf-8")
+    with open(os.path.join(TEST, "testdata.rsrc"), "rb") as f:
+        rsrc = f.read()
+
+    expected = ls("-f", os.path.join(TEST, "testdata.rsrc"))
+    for name in ["testdata.rsrc", "testdata.as"]:
+        with open(os.path.join(TEST, name), "rb") as f:
+            assert ls("-", stdin=f) == expected
+    assert ls("--stdin", input=rsrc) == expected
+    assert ls("-", input=macbinary(b"testdata", rsrc)) == expected
+    assert ls("-S", "1", "-", input=rsrc) == expected
+    assert ls("--stdin-size=1", "--stdin", input=rsrc) == expected
+
+
+def hfs_image(files, plus=False):
+    """Builds an HFS or HFS+ disk image holding `files`, a list of (path, rsrc, runs) tuples.
+
+    Each resource fork is split into `runs` runs of blocks, with gaps between them; runs after
+    the first few (3 for HFS, 8 for HFS+) are stored in the extents overflow file.
+    """
+    block_size, node_size = (4096, 4096) if plus else (512, 512)
+    blocks = bytearray()
+    first_block = 0 if plus else 4096
+    used = [max(1, 8192 // block_size)]
+
+    def allocate(data):
+        count = max(1, -(-len(data) // block_size))
+        start = used[0]
+        used[0] += count + 1
+        offset = first_block + start * block_size
+        blocks.extend(bytes(offset + (count + 1) * block_size - len(blocks)))
+        blocks[offset:offset + len(data)] = data
+        return (start, count)
+
+    def node(kind, records, next_node=0):
+        data = struct.pack(">IIBBHH", next_node, 0, kind, kind == 0xff, len(records), 0)
+        offsets = []
+        for record in records:
+            offsets.append(len(data))
+            data += record
+        offsets.append(len(data))
+        data += bytes(node_size - len(data) - 2 * len(offsets))
+        return data + b"".join(struct.pack(">H", offset) for offset in reversed(offsets))
+
+    def tree(records):
+        leaves = [[]]
+        for record in sorted(records):
+            if 14 + sum(len(r) + 2 for r in leaves[-1]) + len(record) + 4 > node_size:
+                leaves.append([])
+            leaves[-1].append(record)
+        header = struct.pack(">HIIIIHHII", 1, 1, len(records), 1, len(leaves), node_size,
+                             516 if plus else 37, len(leaves) + 1, 0)
+        nodes = [node(1, [header + bytes(106 - len(header)), bytes(128), bytes(node_size - 256)])]
+        for i, leaf in enumerate(leaves):
+            nodes.append(node(0xff, leaf, i + 2 if i + 1 < len(leaves) else 0))
+        data = b"".join(nodes)
+        return allocate(data), len(data)
+
+    def key(parent, name):
+        if plus:
+            encoded = name.encode("utf-16-be")
+            return struct.pack(">HIH", 6 + len(encoded), parent, len(encoded) // 2) + encoded
+        encoded = name.encode("mac-roman")
+        k = struct.pack(">BBIB", 6 + len(encoded), 0, parent, len(encoded)) + encoded
+        return k + bytes(len(k) % 2)
+
+    def extents(runs, count):
+        runs = runs + [(0, 0)] * (count - len(runs))
+        return b"".join(struct.pack(">II" if plus else ">HH", *run) for run in runs)
+
+    folders = {"": 2}
+    folder = lambda id: struct.pack(">HHII", 1, 0, 0, id) if plus else struct.pack(
+        ">HHHI", 0x100, 0, 0, id)
+    catalog = [key(1, "Volume") + folder(2)]
+    overflow = []
+    next_id = 16
+    for path, rsrc, split in files:
+        parent = 2
+        parts = path.split("/")
+        for i, part in enumerate(parts[:-1]):
+            prefix = "/".join(parts[:i + 1])
+            if prefix not in folders:
+                folders[prefix] = next_id
+                catalog.append(key(parent, part) + folder(next_id))
+                next_id += 1
+            parent = folders[prefix]
+        size = -(-len(rsrc) // split // block_size) * block_size
+        runs = [allocate(rsrc[i:i + size]) for i in range(0, len(rsrc), size)]
+        inline = 8 if plus else 3
+        for i in range(inline, len(runs), inline):
+            start = sum(count for _, count in runs[:i])
+            if plus:
+                k = struct.pack(">HBBII", 10, 0xff, 0, next_id, start)
+            else:
+                k = struct.pack(">BBIH", 7, 0xff, next_id, start)
+            overflow.append(k + extents(runs[i:i + inline], inline))
+        physical = sum(count for _, count in runs) * block_size
+        if plus:
+            record = (struct.pack(">HHII", 2, 0, 0, next_id) + bytes(76) + bytes(80) +
+                      struct.pack(">QII", len(rsrc), 0, physical // block_size) +
+                      extents(runs[:inline], inline))
+        else:
+            record = (struct.pack(">HBB", 0x200, 0, 0) + bytes(16) +
+                      struct.pack(">IHIIHII", next_id, 0, 0, 0, 0, len(rsrc), physical) +
+                      bytes(12 + 16 + 2 + 12) + extents(runs[:inline], inline) + bytes(4))
+        catalog.append(key(parent, parts[-1]) + record)
+        next_id += 1
+
+    (extents_run, extents_size) = tree(overflow)
+    (catalog_run, catalog_size) = tree(catalog)
+    if plus:
+        header = bytearray(512)
+        struct.pack_into(">HH", header, 0, 0x482b, 4)
+        struct.pack_into(">II", header, 40, block_size, used[0])
+        struct.pack_into(">QII", header, 192, extents_size, 0, extents_run[1])
+        struct.pack_into(">II", header, 208, *extents_run)
+        struct.pack_into(">QII", header, 272, catalog_size, 0, catalog_run[1])
+        struct.pack_into(">II", header, 288, *catalog_run)
+    else:
+        header = bytearray(162)
+        struct.pack_into(">H", header, 0, 0x4244)
+        struct.pack_into(">HII", header, 18, used[0], block_size, block_size)
+        struct.pack_into(">H", header, 28, first_block // 512)
+        struct.pack_into(">I", header, 130, extents_size)
+        struct.pack_into(">HH", header, 134, *extents_run)
+        struct.pack_into(">I", header, 146, catalog_size)
+        struct.pack_into(">HH", header, 150, *catalog_run)
+    blocks[1024:1024 + len(header)] = header
+    return bytes(blocks)
+
+
+def test_hfs(tmp_path):
+    ls = lambda *args: subprocess.check_output([REZIN] + list(args) + ["ls"]).decode("utf-8")
+    with open(os.path.join(TEST, "testdata.rsrc"), "rb") as f:
+        rsrc = f.read()
+    files = [("Folder/testdata", rsrc, 12), ("flat", rsrc, 1)]
+
+    expected = ls("-f", os.path.join(TEST, "testdata.rsrc"))
+    expected = "Folder/testdata:\n" + expected + "\nflat:\n" + expected
+    for plus in [False, True]:
+        image = os.path.join(tmp_path, "testdata.hfs")
+        with open(image, "wb") as f:
+            f.write(hfs_image(files, plus))
+        assert ls("-H", image) == expected
+        assert ls("--hfs", image, "-j", "4") == expected
+
+
 def pytest_generate_tests(metafunc):
+    if "source" not in metafunc.fixturenames:
+        return
     sources = collections.OrderedDict([
         ("as", [REZIN, "-a", os.path.join(TEST, "testdata.as")]),
         ("rsrc", [REZIN, "-f", os.path.join(TEST, "testdata.rsrc")]),
         ("zip", [REZIN, "-z", os.path.join(TEST, "testdata.zip,testdata.rsrc")]),
+        ("zip-window", [REZIN, "-W", "1", "-z", os.path.join(TEST, "testdata.zip,testdata.rsrc")]),
     ])
     metafunc.parametrize("source", sources.values(), ids=list(sources.keys()))
 